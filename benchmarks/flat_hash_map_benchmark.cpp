@@ -0,0 +1,232 @@
+#include "../src/aggregation/container_types.hpp"
+#include "../src/aggregation/grouping.hpp"
+#include "../src/engine/order_slab.hpp"
+#include "../src/fix/fix_types.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// FlatHashMap benchmark - FlatHashMap vs std::pmr::unordered_map
+// ============================================================================
+//
+// Times lookup, insert and erase on the two workloads the engine's hash maps
+// carry:
+// - order index: ClOrdID -> OrderHandle, as OrderBook's index_ (orders are
+//   added, looked up by every report, and erased when reclaimed)
+// - aggregation bucket: PortfolioInstrumentKey -> double, as a hashed
+//   AggregationBucket (a fixed set of hot keys, updated in place)
+//
+// Build and run with `make bench` (or bazel run //benchmarks:flat_hash_map_benchmark).
+// Reports nanoseconds per operation; compare the columns, not the absolute
+// numbers, which depend on the machine.
+//
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Key, typename Value>
+using FlatMap = aggregation::FlatHashMap<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                                         std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+
+template<typename Key, typename Value>
+using NodeMap = std::pmr::unordered_map<Key, Value>;
+
+// Keeps results observable so the timed loops are not optimized away
+volatile uint64_t sink = 0;
+
+template<typename F>
+double time_ns_per_op(size_t operations, F&& body) {
+    auto start = Clock::now();
+    body();
+    auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    return elapsed / static_cast<double>(operations);
+}
+
+void print_row(const char* name, double flat, double node) {
+    std::printf("  %-28s %10.1f %10.1f %8.2fx\n", name, flat, node, node / flat);
+}
+
+// ============================================================================
+// Order index workload
+// ============================================================================
+
+struct OrderIndexResult {
+    double insert = 0;
+    double find_hit = 0;
+    double find_miss = 0;
+    double churn = 0;
+    double erase = 0;
+};
+
+template<typename Map>
+OrderIndexResult run_order_index(const std::vector<fix::OrderKey>& keys,
+                                 const std::vector<fix::OrderKey>& misses,
+                                 const std::vector<size_t>& probe_order,
+                                 size_t live_window) {
+    OrderIndexResult result;
+    Map map;
+    size_t n = keys.size();
+
+    result.insert = time_ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            map.try_emplace(keys[i], engine::OrderHandle{static_cast<uint32_t>(i), 0});
+        }
+    });
+
+    result.find_hit = time_ns_per_op(probe_order.size(), [&] {
+        uint64_t sum = 0;
+        for (size_t i : probe_order) {
+            sum += map.find(keys[i])->second.index;
+        }
+        sink = sink + sum;
+    });
+
+    result.find_miss = time_ns_per_op(misses.size(), [&] {
+        uint64_t found = 0;
+        for (const auto& key : misses) {
+            found += map.find(key) != map.end();
+        }
+        sink = sink + found;
+    });
+
+    result.erase = time_ns_per_op(n, [&] {
+        for (const auto& key : keys) {
+            map.erase(key);
+        }
+    });
+
+    // Steady state: a window of live orders, each new order retiring the
+    // oldest one (the shape of OrderBook with terminal reclamation)
+    result.churn = time_ns_per_op(n, [&] {
+        for (size_t i = 0; i < n; ++i) {
+            map.try_emplace(keys[i], engine::OrderHandle{static_cast<uint32_t>(i), 0});
+            if (i >= live_window) {
+                map.erase(keys[i - live_window]);
+            }
+        }
+    });
+    return result;
+}
+
+void order_index_benchmark() {
+    constexpr size_t ORDERS = 1u << 20;
+    constexpr size_t LIVE_WINDOW = 50000;
+
+    std::vector<fix::OrderKey> keys;
+    std::vector<fix::OrderKey> misses;
+    keys.reserve(ORDERS);
+    misses.reserve(ORDERS);
+    for (size_t i = 0; i < ORDERS; ++i) {
+        keys.push_back(fix::OrderKey{"ORD-" + std::to_string(1000000 + i)});
+        misses.push_back(fix::OrderKey{"MISS-" + std::to_string(1000000 + i)});
+    }
+    std::vector<size_t> probe_order(ORDERS);
+    for (size_t i = 0; i < ORDERS; ++i) probe_order[i] = i;
+    std::shuffle(probe_order.begin(), probe_order.end(), std::mt19937_64(1));
+
+    auto flat = run_order_index<FlatMap<fix::OrderKey, engine::OrderHandle>>(keys, misses, probe_order, LIVE_WINDOW);
+    auto node = run_order_index<NodeMap<fix::OrderKey, engine::OrderHandle>>(keys, misses, probe_order, LIVE_WINDOW);
+
+    std::printf("Order index (%zu ClOrdIDs, ns/op)\n", ORDERS);
+    std::printf("  %-28s %10s %10s %9s\n", "", "flat", "node", "speedup");
+    print_row("insert", flat.insert, node.insert);
+    print_row("find (hit, random order)", flat.find_hit, node.find_hit);
+    print_row("find (miss)", flat.find_miss, node.find_miss);
+    print_row("erase", flat.erase, node.erase);
+    print_row("insert+erase (live window)", flat.churn, node.churn);
+}
+
+// ============================================================================
+// Aggregation bucket workload
+// ============================================================================
+
+struct BucketResult {
+    double update = 0;
+    double get = 0;
+    double insert_erase = 0;
+};
+
+template<typename Map>
+BucketResult run_bucket(const std::vector<aggregation::PortfolioInstrumentKey>& keys,
+                        const std::vector<uint32_t>& stream) {
+    using aggregation::PortfolioInstrumentKey;
+    BucketResult result;
+    Map map;
+    for (const auto& key : keys) {
+        map.try_emplace(key, 0.0);
+    }
+
+    // AggregationBucket::add on an existing key: find and combine in place
+    result.update = time_ns_per_op(stream.size(), [&] {
+        for (uint32_t i : stream) {
+            map.find(keys[i])->second += 1.0;
+        }
+    });
+
+    // AggregationBucket::get
+    result.get = time_ns_per_op(stream.size(), [&] {
+        double sum = 0.0;
+        for (uint32_t i : stream) {
+            auto it = map.find(keys[i]);
+            sum += it == map.end() ? 0.0 : it->second;
+        }
+        sink = sink + static_cast<uint64_t>(sum);
+    });
+
+    // A key that drops back to identity is erased and later re-added
+    result.insert_erase = time_ns_per_op(stream.size(), [&] {
+        for (uint32_t i : stream) {
+            const auto& key = keys[i];
+            if (map.erase(key) == 0) {
+                map.try_emplace(key, 1.0);
+            }
+        }
+    });
+    return result;
+}
+
+void bucket_benchmark() {
+    constexpr uint32_t PORTFOLIOS = 64;
+    constexpr uint32_t SYMBOLS = 2000;
+    constexpr size_t UPDATES = 1u << 22;
+
+    std::vector<aggregation::PortfolioInstrumentKey> keys;
+    keys.reserve(PORTFOLIOS * SYMBOLS);
+    for (uint32_t portfolio = 0; portfolio < PORTFOLIOS; ++portfolio) {
+        for (uint32_t symbol = 0; symbol < SYMBOLS; ++symbol) {
+            keys.push_back(aggregation::PortfolioInstrumentKey::from_id(portfolio, symbol));
+        }
+    }
+    std::mt19937_64 rng(2);
+    std::vector<uint32_t> stream(UPDATES);
+    for (auto& i : stream) {
+        i = static_cast<uint32_t>(rng() % keys.size());
+    }
+
+    using Key = aggregation::PortfolioInstrumentKey;
+    auto flat = run_bucket<FlatMap<Key, double>>(keys, stream);
+    auto node = run_bucket<NodeMap<Key, double>>(keys, stream);
+
+    std::printf("Aggregation bucket (%zu portfolio x instrument keys, ns/op)\n", keys.size());
+    std::printf("  %-28s %10s %10s %9s\n", "", "flat", "node", "speedup");
+    print_row("update in place", flat.update, node.update);
+    print_row("get", flat.get, node.get);
+    print_row("erase or re-insert", flat.insert_erase, node.insert_erase);
+}
+
+} // namespace
+
+int main() {
+    order_index_benchmark();
+    std::printf("\n");
+    bucket_benchmark();
+    return 0;
+}
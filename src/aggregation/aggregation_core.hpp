@@ -3,6 +3,7 @@
 #include "grouping.hpp"
 #include "aggregation_traits.hpp"
 #include "container_types.hpp"
+#include "bucket_storage.hpp"
 #include <optional>
 #include <tuple>
 #include <functional>
@@ -21,45 +22,39 @@ public:
     using combiner_type = Combiner;
 
 private:
-    HashMap<Key, value_type> values_;
+    // Storage is selected from the key type (scalar, dense, side-split or hashed)
+    BucketStorage<Key, value_type> values_;
 
 public:
+    explicit AggregationBucket(MemoryResource* resource = default_memory_resource())
+        : values_(resource) {}
+
     // Get current value for a key (returns identity if not present)
     value_type get(const Key& key) const {
-        auto it = values_.find(key);
-        if (it == values_.end()) {
-            return Combiner::identity();
-        }
-        return it->second;
+        const value_type* value = values_.find(key);
+        return value ? *value : Combiner::identity();
     }
 
     // Check if key exists
     bool contains(const Key& key) const {
-        return values_.find(key) != values_.end();
+        return values_.find(key) != nullptr;
     }
 
     // Add/combine a value - O(1)
     void add(const Key& key, const value_type& delta) {
-        auto it = values_.find(key);
-        if (it == values_.end()) {
-            values_[key] = Combiner::combine(Combiner::identity(), delta);
-        } else {
-            it->second = Combiner::combine(it->second, delta);
-        }
+        value_type& value = values_.find_or_insert(key, Combiner::identity());
+        value = Combiner::combine(value, delta);
     }
 
     // Remove/uncombine a value - O(1)
     // Only available for combiners that support uncombine
     template<typename C = Combiner>
     std::enable_if_t<has_uncombine_v<C>> remove(const Key& key, const value_type& delta) {
-        auto it = values_.find(key);
-        if (it != values_.end()) {
-            it->second = Combiner::uncombine(it->second, delta);
-            // Optionally clean up if back to identity
-            if (it->second == Combiner::identity()) {
-                values_.erase(it);
-            }
-        }
+        values_.modify(key, [&delta](value_type& value) {
+            value = Combiner::uncombine(value, delta);
+            // Clean up if back to identity
+            return value == Combiner::identity();
+        });
     }
 
     // Update: remove old value and add new value - O(1)
@@ -75,9 +70,9 @@ public:
     std::vector<Key> keys() const {
         std::vector<Key> result;
         result.reserve(values_.size());
-        for (const auto& [key, _] : values_) {
+        values_.for_each([&result](const Key& key, const value_type&) {
             result.push_back(key);
-        }
+        });
         return result;
     }
 
@@ -86,6 +81,11 @@ public:
         return values_.size();
     }
 
+    // Pre-size for the number of keys the hints imply for Key
+    void reserve(const CapacityHints& hints) {
+        values_.reserve(key_capacity<Key>::from(hints));
+    }
+
     // Clear all values
     void clear() {
         values_.clear();
@@ -94,9 +94,7 @@ public:
     // Iterate over all values
     template<typename Func>
     void for_each(Func&& func) const {
-        for (const auto& [key, value] : values_) {
-            func(key, value);
-        }
+        values_.for_each(std::forward<Func>(func));
     }
 };
 
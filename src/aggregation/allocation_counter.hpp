@@ -0,0 +1,150 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace aggregation {
+
+// ============================================================================
+// Allocation counting - Heap allocations per engine handler (debug builds)
+// ============================================================================
+//
+// Building with -DAGGREGATION_COUNT_ALLOCATIONS makes every engine message
+// handler record the heap allocations it performed, readable through the
+// engine's allocation_stats(). Without the flag the handler hook expands to
+// nothing and engines carry no stats.
+//
+// Allocations are counted by a replacement global operator new, which exactly
+// one translation unit of the binary installs:
+//
+//   #define AGGREGATION_INSTALL_COUNTING_OPERATOR_NEW
+//   #include "aggregation/allocation_counter.hpp"
+//
+// Memory served by an engine's MemoryArena (without overflowing to the heap)
+// never reaches operator new and is not counted.
+//
+
+// Heap allocations made by this thread so far (bumped by the counting operator new)
+inline thread_local uint64_t heap_allocation_count = 0;
+
+enum class EngineHandler : uint8_t {
+    NEW_ORDER_SINGLE,
+    ORDER_CANCEL_REPLACE,
+    ORDER_CANCEL_REQUEST,
+    EXECUTION_REPORT,
+    ORDER_CANCEL_REJECT,
+    PRE_TRADE_CHECK
+};
+
+inline constexpr size_t ENGINE_HANDLER_COUNT = 6;
+
+struct HandlerAllocationStats {
+    std::array<uint64_t, ENGINE_HANDLER_COUNT> calls{};
+    std::array<uint64_t, ENGINE_HANDLER_COUNT> allocations{};
+
+    uint64_t calls_to(EngineHandler handler) const {
+        return calls[static_cast<size_t>(handler)];
+    }
+
+    uint64_t allocations_in(EngineHandler handler) const {
+        return allocations[static_cast<size_t>(handler)];
+    }
+
+    uint64_t total_allocations() const {
+        uint64_t total = 0;
+        for (uint64_t count : allocations) {
+            total += count;
+        }
+        return total;
+    }
+
+    void merge(const HandlerAllocationStats& other) {
+        for (size_t i = 0; i < ENGINE_HANDLER_COUNT; ++i) {
+            calls[i] += other.calls[i];
+            allocations[i] += other.allocations[i];
+        }
+    }
+
+    void reset() {
+        calls.fill(0);
+        allocations.fill(0);
+    }
+};
+
+// Records the allocations made between construction and destruction
+class AllocationScope {
+private:
+    HandlerAllocationStats& stats_;
+    size_t handler_;
+    uint64_t start_;
+
+public:
+    AllocationScope(HandlerAllocationStats& stats, EngineHandler handler)
+        : stats_(stats), handler_(static_cast<size_t>(handler)), start_(heap_allocation_count) {}
+
+    ~AllocationScope() {
+        ++stats_.calls[handler_];
+        stats_.allocations[handler_] += heap_allocation_count - start_;
+    }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+} // namespace aggregation
+
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+#define AGGREGATION_COUNT_HANDLER_ALLOCATIONS(stats, handler) \
+    ::aggregation::AllocationScope aggregation_allocation_scope_((stats), ::aggregation::EngineHandler::handler)
+#else
+#define AGGREGATION_COUNT_HANDLER_ALLOCATIONS(stats, handler) ((void)0)
+#endif
+
+// ============================================================================
+// Counting operator new (installed by one translation unit)
+// ============================================================================
+
+#if defined(AGGREGATION_INSTALL_COUNTING_OPERATOR_NEW) && !defined(AGGREGATION_COUNTING_OPERATOR_NEW_INSTALLED)
+#define AGGREGATION_COUNTING_OPERATOR_NEW_INSTALLED
+
+void* operator new(std::size_t size) {
+    ++aggregation::heap_allocation_count;
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    ++aggregation::heap_allocation_count;
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = ((size ? size : 1) + align - 1) & ~(align - 1);
+    if (void* p = std::aligned_alloc(align, rounded)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+    return ::operator new(size, alignment);
+}
+
+// Out of line, so the compiler does not pair an inlined free() with new
+__attribute__((noinline)) void aggregation_counting_free(void* p) noexcept { std::free(p); }
+
+void operator delete(void* p) noexcept { aggregation_counting_free(p); }
+void operator delete[](void* p) noexcept { aggregation_counting_free(p); }
+void operator delete(void* p, std::size_t) noexcept { aggregation_counting_free(p); }
+void operator delete[](void* p, std::size_t) noexcept { aggregation_counting_free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { aggregation_counting_free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { aggregation_counting_free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { aggregation_counting_free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { aggregation_counting_free(p); }
+#endif
@@ -0,0 +1,421 @@
+#pragma once
+
+#include "grouping.hpp"
+#include "capacity_hints.hpp"
+#include "container_types.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+namespace aggregation {
+
+// ============================================================================
+// Bucket Storage - Cardinality-specialized backing store for AggregationBucket
+// ============================================================================
+//
+// The storage is selected at compile time from the key type:
+// - GlobalKey:                     ScalarBucketStorage (single value, no lookup)
+// - Underlyer/Strategy/PortfolioKey: DenseBucketStorage (vector indexed by
+//                                    interned ID; these universes are small)
+// - InstrumentSideKey:             SideSplitBucketStorage (one hash probe per
+//                                    symbol, both sides stored together)
+// - anything else:                 HashedBucketStorage (HashMap)
+//
+// All storages expose the same interface:
+// - find(key) -> pointer to value or nullptr
+// - find_or_insert(key, init) -> reference to value (inserted as init)
+// - modify(key, func): apply func(value&) to an existing value and erase the
+//   entry if func returns true
+// - size(), clear(), for_each(func(key, value))
+// - reserve(n): pre-size for n keys so inserts do not grow the storage
+//
+// Storages that allocate take the engine's MemoryResource at construction.
+//
+
+// Hash map storage - general fallback
+template<typename Key, typename Value>
+class HashedBucketStorage {
+private:
+    HashMap<Key, Value> values_;
+
+public:
+    explicit HashedBucketStorage(MemoryResource* resource = default_memory_resource())
+        : values_(resource) {}
+
+    Value* find(const Key& key) {
+        auto it = values_.find(key);
+        return (it != values_.end()) ? &it->second : nullptr;
+    }
+
+    const Value* find(const Key& key) const {
+        auto it = values_.find(key);
+        return (it != values_.end()) ? &it->second : nullptr;
+    }
+
+    Value& find_or_insert(const Key& key, const Value& init) {
+        return values_.try_emplace(key, init).first->second;
+    }
+
+    template<typename Func>
+    void modify(const Key& key, Func&& func) {
+        auto it = values_.find(key);
+        if (it != values_.end() && func(it->second)) {
+            values_.erase(it);
+        }
+    }
+
+    size_t size() const { return values_.size(); }
+    void clear() { values_.clear(); }
+    void reserve(size_t n) { values_.reserve(n); }
+
+    template<typename Func>
+    void for_each(Func&& func) const {
+        for (const auto& [key, value] : values_) {
+            func(key, value);
+        }
+    }
+};
+
+// Single-value storage for GlobalKey
+template<typename Value>
+class ScalarBucketStorage {
+private:
+    Value value_{};
+    bool present_ = false;
+
+public:
+    explicit ScalarBucketStorage(MemoryResource* /*resource*/ = default_memory_resource()) {}
+
+    Value* find(const GlobalKey&) {
+        return present_ ? &value_ : nullptr;
+    }
+
+    const Value* find(const GlobalKey&) const {
+        return present_ ? &value_ : nullptr;
+    }
+
+    Value& find_or_insert(const GlobalKey&, const Value& init) {
+        if (!present_) {
+            value_ = init;
+            present_ = true;
+        }
+        return value_;
+    }
+
+    template<typename Func>
+    void modify(const GlobalKey&, Func&& func) {
+        if (present_ && func(value_)) {
+            present_ = false;
+        }
+    }
+
+    size_t size() const { return present_ ? 1 : 0; }
+
+    void clear() { present_ = false; }
+    void reserve(size_t /*n*/) {}
+
+    template<typename Func>
+    void for_each(Func&& func) const {
+        if (present_) {
+            func(GlobalKey::instance(), value_);
+        }
+    }
+};
+
+// Access to the interned ID of single-identifier keys
+template<typename Key>
+struct interned_key_traits;
+
+template<>
+struct interned_key_traits<UnderlyerKey> {
+    static InternedId id(const UnderlyerKey& key) { return key.underlyer; }
+    static UnderlyerKey from_id(InternedId id) { return UnderlyerKey::from_id(id); }
+};
+
+template<>
+struct interned_key_traits<StrategyKey> {
+    static InternedId id(const StrategyKey& key) { return key.strategy; }
+    static StrategyKey from_id(InternedId id) { return StrategyKey::from_id(id); }
+};
+
+template<>
+struct interned_key_traits<PortfolioKey> {
+    static InternedId id(const PortfolioKey& key) { return key.portfolio; }
+    static PortfolioKey from_id(InternedId id) { return PortfolioKey::from_id(id); }
+};
+
+// Dense storage indexed by interned ID
+//
+// Slot = id + 1 (mod 2^32), so INVALID_INTERNED_ID maps to slot 0 and needs
+// no special casing. The vectors grow to the largest ID seen.
+template<typename Key, typename Value>
+class DenseBucketStorage {
+private:
+    using Traits = interned_key_traits<Key>;
+
+    std::pmr::vector<Value> values_;
+    std::pmr::vector<uint8_t> present_;
+    size_t size_ = 0;
+
+    static size_t slot(const Key& key) {
+        return static_cast<InternedId>(Traits::id(key) + 1);
+    }
+
+public:
+    explicit DenseBucketStorage(MemoryResource* resource = default_memory_resource())
+        : values_(resource), present_(resource) {}
+
+    Value* find(const Key& key) {
+        size_t s = slot(key);
+        return (s < present_.size() && present_[s]) ? &values_[s] : nullptr;
+    }
+
+    const Value* find(const Key& key) const {
+        size_t s = slot(key);
+        return (s < present_.size() && present_[s]) ? &values_[s] : nullptr;
+    }
+
+    Value& find_or_insert(const Key& key, const Value& init) {
+        size_t s = slot(key);
+        if (s >= present_.size()) {
+            size_t new_size = std::max(s + 1, present_.size() * 2);
+            values_.resize(new_size);
+            present_.resize(new_size, 0);
+        }
+        if (!present_[s]) {
+            values_[s] = init;
+            present_[s] = 1;
+            ++size_;
+        }
+        return values_[s];
+    }
+
+    template<typename Func>
+    void modify(const Key& key, Func&& func) {
+        size_t s = slot(key);
+        if (s < present_.size() && present_[s] && func(values_[s])) {
+            present_[s] = 0;
+            --size_;
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    void clear() {
+        std::fill(present_.begin(), present_.end(), 0);
+        size_ = 0;
+    }
+
+    // IDs are dense per domain, so n keys usually occupy slots [1, n]
+    void reserve(size_t n) {
+        if (n + 1 > present_.size()) {
+            values_.resize(n + 1);
+            present_.resize(n + 1, 0);
+        }
+    }
+
+    template<typename Func>
+    void for_each(Func&& func) const {
+        for (size_t s = 0; s < present_.size(); ++s) {
+            if (present_[s]) {
+                func(Traits::from_id(static_cast<InternedId>(s - 1)), values_[s]);
+            }
+        }
+    }
+};
+
+// Side-split storage for InstrumentSideKey
+//
+// Keyed by symbol ID; both sides (1=Bid, 2=Ask) share one entry, so the two
+// sides of an instrument cost a single probe and a single cache line. Keys
+// with any other side value go to a plain hash map keyed by the whole key,
+// so they stay distinct from bid and ask instead of aliasing one of them.
+template<typename Value>
+class SideSplitBucketStorage {
+private:
+    struct SidePair {
+        std::array<Value, 2> values{};
+        uint8_t present = 0;  // Bit i set = side index i present
+    };
+
+    static constexpr size_t OTHER_SIDE = 2;
+
+    HashMap<InternedId, SidePair> values_;
+    HashMap<InstrumentSideKey, Value> other_sides_;
+    size_t size_ = 0;
+
+    // 0 for Bid, 1 for Ask, OTHER_SIDE for anything else
+    static size_t side_index(const InstrumentSideKey& key) {
+        return (key.side == 1 || key.side == 2) ? static_cast<size_t>(key.side - 1) : OTHER_SIDE;
+    }
+
+public:
+    explicit SideSplitBucketStorage(MemoryResource* resource = default_memory_resource())
+        : values_(resource), other_sides_(resource) {}
+
+    Value* find(const InstrumentSideKey& key) {
+        size_t i = side_index(key);
+        if (i == OTHER_SIDE) {
+            auto it = other_sides_.find(key);
+            return it == other_sides_.end() ? nullptr : &it->second;
+        }
+        auto it = values_.find(key.symbol);
+        if (it == values_.end()) return nullptr;
+        return (it->second.present & (1u << i)) ? &it->second.values[i] : nullptr;
+    }
+
+    const Value* find(const InstrumentSideKey& key) const {
+        size_t i = side_index(key);
+        if (i == OTHER_SIDE) {
+            auto it = other_sides_.find(key);
+            return it == other_sides_.end() ? nullptr : &it->second;
+        }
+        auto it = values_.find(key.symbol);
+        if (it == values_.end()) return nullptr;
+        return (it->second.present & (1u << i)) ? &it->second.values[i] : nullptr;
+    }
+
+    Value& find_or_insert(const InstrumentSideKey& key, const Value& init) {
+        size_t i = side_index(key);
+        if (i == OTHER_SIDE) {
+            auto [it, inserted] = other_sides_.try_emplace(key, init);
+            if (inserted) ++size_;
+            return it->second;
+        }
+        SidePair& pair = values_[key.symbol];
+        if (!(pair.present & (1u << i))) {
+            pair.values[i] = init;
+            pair.present |= static_cast<uint8_t>(1u << i);
+            ++size_;
+        }
+        return pair.values[i];
+    }
+
+    template<typename Func>
+    void modify(const InstrumentSideKey& key, Func&& func) {
+        size_t i = side_index(key);
+        if (i == OTHER_SIDE) {
+            auto it = other_sides_.find(key);
+            if (it != other_sides_.end() && func(it->second)) {
+                other_sides_.erase(it);
+                --size_;
+            }
+            return;
+        }
+        auto it = values_.find(key.symbol);
+        if (it == values_.end()) return;
+        SidePair& pair = it->second;
+        if ((pair.present & (1u << i)) && func(pair.values[i])) {
+            pair.present &= static_cast<uint8_t>(~(1u << i));
+            --size_;
+            if (pair.present == 0) {
+                values_.erase(it);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    void clear() {
+        values_.clear();
+        other_sides_.clear();
+        size_ = 0;
+    }
+
+    // n is the number of symbols (each holds both sides)
+    void reserve(size_t n) { values_.reserve(n); }
+
+    template<typename Func>
+    void for_each(Func&& func) const {
+        for (const auto& [symbol, pair] : values_) {
+            for (size_t i = 0; i < 2; ++i) {
+                if (pair.present & (1u << i)) {
+                    func(InstrumentSideKey::from_id(symbol, static_cast<int>(i + 1)), pair.values[i]);
+                }
+            }
+        }
+        for (const auto& [key, value] : other_sides_) {
+            func(key, value);
+        }
+    }
+};
+
+// ============================================================================
+// Storage selection
+// ============================================================================
+
+template<typename Key, typename Value>
+struct bucket_storage_selector {
+    using type = HashedBucketStorage<Key, Value>;
+};
+
+template<typename Value>
+struct bucket_storage_selector<GlobalKey, Value> {
+    using type = ScalarBucketStorage<Value>;
+};
+
+template<typename Value>
+struct bucket_storage_selector<UnderlyerKey, Value> {
+    using type = DenseBucketStorage<UnderlyerKey, Value>;
+};
+
+template<typename Value>
+struct bucket_storage_selector<StrategyKey, Value> {
+    using type = DenseBucketStorage<StrategyKey, Value>;
+};
+
+template<typename Value>
+struct bucket_storage_selector<PortfolioKey, Value> {
+    using type = DenseBucketStorage<PortfolioKey, Value>;
+};
+
+template<typename Value>
+struct bucket_storage_selector<InstrumentSideKey, Value> {
+    using type = SideSplitBucketStorage<Value>;
+};
+
+template<typename Key, typename Value>
+using BucketStorage = typename bucket_storage_selector<Key, Value>::type;
+
+// ============================================================================
+// Key capacity - expected number of storage entries for a key type
+// ============================================================================
+//
+// Strategy and portfolio universes are not covered by CapacityHints; their
+// dense storages grow on the rare new ID.
+//
+
+template<typename Key>
+struct key_capacity {
+    static size_t from(const CapacityHints& /*hints*/) { return 0; }
+};
+
+template<>
+struct key_capacity<GlobalKey> {
+    static size_t from(const CapacityHints& /*hints*/) { return 1; }
+};
+
+template<>
+struct key_capacity<UnderlyerKey> {
+    static size_t from(const CapacityHints& hints) { return hints.underlyers; }
+};
+
+template<>
+struct key_capacity<InstrumentKey> {
+    static size_t from(const CapacityHints& hints) { return hints.instruments; }
+};
+
+// Side-split storage has one entry per symbol
+template<>
+struct key_capacity<InstrumentSideKey> {
+    static size_t from(const CapacityHints& hints) { return hints.instruments; }
+};
+
+template<>
+struct key_capacity<PortfolioInstrumentKey> {
+    static size_t from(const CapacityHints& hints) { return hints.instruments; }
+};
+
+} // namespace aggregation
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+namespace aggregation {
+
+// ============================================================================
+// CapacityHints - Expected sizes used to pre-size engine containers
+// ============================================================================
+//
+// Passed to an engine at construction (or to reserve()) so the order book,
+// the pending ClOrdID map, metric buckets and per-order stored inputs are
+// sized for the trading day up front. With sizes reserved, steady-state order
+// flow neither grows nor rehashes any container.
+//
+// Zero means "no hint": the container grows on demand as before. Hints are
+// not limits; exceeding them only brings back on-demand growth.
+//
+
+struct CapacityHints {
+    size_t orders = 0;       // Orders tracked at once (live plus not yet cleaned up)
+    size_t instruments = 0;  // Distinct symbols traded
+    size_t underlyers = 0;   // Distinct underlyers traded
+};
+
+} // namespace aggregation
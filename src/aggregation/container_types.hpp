@@ -1,11 +1,29 @@
 #pragma once
 
+#include "flat_hash_map.hpp"
+#include "memory_resource.hpp"
+#include <memory_resource>
 #include <unordered_map>
 
 namespace aggregation {
 
 // Type alias for hash map to allow easy swapping of implementation
+//
+// Defaults to the open-addressing FlatHashMap. Define
+// AGGREGATION_USE_STD_UNORDERED_MAP to fall back to the node-based
+// std::unordered_map (e.g. for A/B benchmarking or when callers rely on
+// reference stability across inserts).
+//
+// Both allocate through a polymorphic allocator: construct with a
+// MemoryResource* to place the table in an engine's arena (see
+// memory_resource.hpp); default construction uses the default resource.
+#ifdef AGGREGATION_USE_STD_UNORDERED_MAP
 template<typename Key, typename Value>
-using HashMap = std::unordered_map<Key, Value>;
+using HashMap = std::pmr::unordered_map<Key, Value>;
+#else
+template<typename Key, typename Value>
+using HashMap = FlatHashMap<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                            std::pmr::polymorphic_allocator<std::pair<Key, Value>>>;
+#endif
 
 } // namespace aggregation
@@ -0,0 +1,722 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace aggregation {
+
+// ============================================================================
+// FlatHashMap - Open-addressing hash map (Swiss-table layout)
+// ============================================================================
+//
+// Cache-friendly replacement for std::unordered_map on the hot path. Entries
+// live inline in a single slot array; a parallel array of one-byte control
+// words holds 7 bits of each entry's hash (or an empty/deleted marker). A
+// lookup scans the control bytes eight at a time (SWAR, no SIMD intrinsics
+// required) and only touches slots whose control byte matches, so most probes
+// cost one cache line of metadata plus one slot.
+//
+// Layout:
+//   ctrl_:  capacity_ + GROUP_WIDTH bytes. The trailing GROUP_WIDTH bytes
+//           mirror the first ones so a group load never wraps.
+//   slots_: capacity_ entries of value_type, constructed only when full.
+//
+// Differences from std::unordered_map:
+//   - References and iterators are invalidated by any insert that grows the
+//     table. Erase never moves other entries (it leaves a tombstone, or an
+//     empty slot when no probe sequence can cross it), so
+//     erase(iterator) during iteration is safe.
+//   - value_type is std::pair<Key, Value>; keys must not be modified through
+//     iterators.
+//
+// The hasher output is re-mixed before use, so identity hashes (e.g.
+// std::hash<uint32_t>) are fine.
+//
+
+namespace detail {
+
+// Control byte values. Full slots hold the 7-bit H2 hash in [0, 127].
+inline constexpr int8_t CTRL_EMPTY = -128;    // 0b10000000
+inline constexpr int8_t CTRL_DELETED = -2;    // 0b11111110
+
+inline constexpr size_t GROUP_WIDTH = 8;
+
+template<typename T, typename = void>
+struct is_transparent : std::false_type {};
+
+template<typename T>
+struct is_transparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+template<typename T>
+inline constexpr bool is_transparent_v = is_transparent<T>::value;
+
+// Finalizer from MurmurHash3 - spreads entropy into both H1 and H2 bits
+inline size_t mix_hash(size_t h) {
+    uint64_t x = static_cast<uint64_t>(h);
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<size_t>(x);
+}
+
+// Bitmask over the 8 control bytes of a group. Bit 8*i+7 set = slot i matches.
+class GroupMask {
+private:
+    uint64_t bits_;
+
+public:
+    explicit GroupMask(uint64_t bits) : bits_(bits) {}
+
+    explicit operator bool() const { return bits_ != 0; }
+
+    // Index (0..7) of the lowest matching slot
+    size_t lowest() const {
+        return static_cast<size_t>(__builtin_ctzll(bits_)) >> 3;
+    }
+
+    // Index (0..7) of the highest matching slot
+    size_t highest() const {
+        return static_cast<size_t>(63 - __builtin_clzll(bits_)) >> 3;
+    }
+
+    void clear_lowest() { bits_ &= bits_ - 1; }
+};
+
+// Portable 8-wide group of control bytes
+class Group {
+private:
+    static constexpr uint64_t LSBS = 0x0101010101010101ULL;
+    static constexpr uint64_t MSBS = 0x8080808080808080ULL;
+
+    uint64_t ctrl_;
+
+public:
+    explicit Group(const int8_t* pos) {
+        std::memcpy(&ctrl_, pos, sizeof(ctrl_));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        ctrl_ = __builtin_bswap64(ctrl_);
+#endif
+    }
+
+    // Slots whose H2 equals h2 (may contain false positives; keys are compared)
+    GroupMask match(uint8_t h2) const {
+        uint64_t x = ctrl_ ^ (LSBS * h2);
+        return GroupMask((x - LSBS) & ~x & MSBS);
+    }
+
+    GroupMask match_empty() const {
+        return GroupMask((ctrl_ & (~ctrl_ << 6)) & MSBS);
+    }
+
+    GroupMask match_empty_or_deleted() const {
+        return GroupMask((ctrl_ & (~ctrl_ << 7)) & MSBS);
+    }
+};
+
+} // namespace detail
+
+template<typename Key, typename Value,
+         typename Hash = std::hash<Key>,
+         typename KeyEqual = std::equal_to<Key>,
+         typename Allocator = std::allocator<std::pair<Key, Value>>>
+class FlatHashMap {
+public:
+    using key_type = Key;
+    using mapped_type = Value;
+    using value_type = std::pair<Key, Value>;
+    using size_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using hasher = Hash;
+    using key_equal = KeyEqual;
+    using allocator_type = Allocator;
+    using reference = value_type&;
+    using const_reference = const value_type&;
+
+private:
+    using alloc_traits = std::allocator_traits<Allocator>;
+    using slot_allocator = typename alloc_traits::template rebind_alloc<value_type>;
+    using slot_traits = std::allocator_traits<slot_allocator>;
+    using ctrl_allocator = typename alloc_traits::template rebind_alloc<int8_t>;
+    using ctrl_traits = std::allocator_traits<ctrl_allocator>;
+
+    static constexpr size_t GROUP_WIDTH = detail::GROUP_WIDTH;
+    static constexpr size_t MIN_CAPACITY = GROUP_WIDTH;
+
+    template<bool Const>
+    class Iterator {
+    private:
+        friend class FlatHashMap;
+        friend class Iterator<!Const>;
+
+        using entry_type = std::pair<Key, Value>;
+        using slot_pointer = std::conditional_t<Const, const entry_type*, entry_type*>;
+
+        const int8_t* ctrl_ = nullptr;
+        const int8_t* ctrl_end_ = nullptr;
+        slot_pointer slot_ = nullptr;
+
+        Iterator(const int8_t* ctrl, const int8_t* ctrl_end, slot_pointer slot)
+            : ctrl_(ctrl), ctrl_end_(ctrl_end), slot_(slot) {}
+
+        void skip_empty() {
+            while (ctrl_ != ctrl_end_ && *ctrl_ < 0) {
+                ++ctrl_;
+                ++slot_;
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = entry_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = slot_pointer;
+        using reference = std::conditional_t<Const, const entry_type&, entry_type&>;
+
+        Iterator() = default;
+
+        // iterator -> const_iterator conversion
+        template<bool C = Const, typename = std::enable_if_t<C>>
+        Iterator(const Iterator<false>& other)
+            : ctrl_(other.ctrl_), ctrl_end_(other.ctrl_end_), slot_(other.slot_) {}
+
+        reference operator*() const { return *slot_; }
+        pointer operator->() const { return slot_; }
+
+        Iterator& operator++() {
+            ++ctrl_;
+            ++slot_;
+            skip_empty();
+            return *this;
+        }
+
+        Iterator operator++(int) {
+            Iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        friend bool operator==(const Iterator& a, const Iterator& b) { return a.ctrl_ == b.ctrl_; }
+        friend bool operator!=(const Iterator& a, const Iterator& b) { return a.ctrl_ != b.ctrl_; }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+private:
+    int8_t* ctrl_ = nullptr;
+    value_type* slots_ = nullptr;
+    size_t capacity_ = 0;     // Power of two (or zero before first insert)
+    size_t size_ = 0;
+    size_t deleted_ = 0;      // Tombstone count
+    Hash hash_;
+    KeyEqual eq_;
+    slot_allocator slot_alloc_;
+
+public:
+    // ========================================================================
+    // Construction
+    // ========================================================================
+
+    FlatHashMap() = default;
+
+    explicit FlatHashMap(const Allocator& alloc) : slot_alloc_(alloc) {}
+
+    explicit FlatHashMap(size_t expected_size, const Allocator& alloc = Allocator())
+        : slot_alloc_(alloc) {
+        reserve(expected_size);
+    }
+
+    FlatHashMap(const FlatHashMap& other)
+        : FlatHashMap(other, slot_traits::select_on_container_copy_construction(other.slot_alloc_)) {}
+
+    FlatHashMap(const FlatHashMap& other, const Allocator& alloc)
+        : hash_(other.hash_), eq_(other.eq_), slot_alloc_(alloc) {
+        copy_from(other);
+    }
+
+    FlatHashMap(FlatHashMap&& other) noexcept
+        : ctrl_(other.ctrl_), slots_(other.slots_), capacity_(other.capacity_),
+          size_(other.size_), deleted_(other.deleted_),
+          hash_(std::move(other.hash_)), eq_(std::move(other.eq_)),
+          slot_alloc_(std::move(other.slot_alloc_)) {
+        other.reset_empty();
+    }
+
+    FlatHashMap& operator=(const FlatHashMap& other) {
+        if (this != &other) {
+            destroy_and_deallocate();
+            if constexpr (slot_traits::propagate_on_container_copy_assignment::value) {
+                slot_alloc_ = other.slot_alloc_;
+            }
+            hash_ = other.hash_;
+            eq_ = other.eq_;
+            copy_from(other);
+        }
+        return *this;
+    }
+
+    FlatHashMap& operator=(FlatHashMap&& other) noexcept(
+        slot_traits::propagate_on_container_move_assignment::value ||
+        slot_traits::is_always_equal::value) {
+        if (this == &other) return *this;
+        if (slot_traits::propagate_on_container_move_assignment::value ||
+            slot_alloc_ == other.slot_alloc_) {
+            destroy_and_deallocate();
+            if constexpr (slot_traits::propagate_on_container_move_assignment::value) {
+                slot_alloc_ = std::move(other.slot_alloc_);
+            }
+            ctrl_ = other.ctrl_;
+            slots_ = other.slots_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            deleted_ = other.deleted_;
+            hash_ = std::move(other.hash_);
+            eq_ = std::move(other.eq_);
+            other.reset_empty();
+        } else {
+            // Unequal, non-propagating allocators: move element-wise
+            clear();
+            reserve(other.size());
+            for (auto& entry : other) {
+                insert(std::move(entry));
+            }
+            other.clear();
+        }
+        return *this;
+    }
+
+    ~FlatHashMap() {
+        destroy_and_deallocate();
+    }
+
+    allocator_type get_allocator() const { return allocator_type(slot_alloc_); }
+
+    // ========================================================================
+    // Iteration
+    // ========================================================================
+
+    iterator begin() {
+        iterator it(ctrl_, ctrl_ + capacity_, slots_);
+        it.skip_empty();
+        return it;
+    }
+
+    iterator end() { return iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_); }
+
+    const_iterator begin() const {
+        const_iterator it(ctrl_, ctrl_ + capacity_, slots_);
+        it.skip_empty();
+        return it;
+    }
+
+    const_iterator end() const {
+        return const_iterator(ctrl_ + capacity_, ctrl_ + capacity_, slots_ + capacity_);
+    }
+
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    // ========================================================================
+    // Capacity
+    // ========================================================================
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+
+    // Ensure that n elements can be held without growing the table
+    void reserve(size_t n) {
+        size_t needed = capacity_for(n);
+        if (needed > capacity_) {
+            resize(needed);
+        }
+    }
+
+    void rehash(size_t n) {
+        size_t needed = capacity_for(std::max(n, size_));
+        if (needed != capacity_ || deleted_ > 0) {
+            resize(needed);
+        }
+    }
+
+    // ========================================================================
+    // Lookup
+    // ========================================================================
+
+    iterator find(const Key& key) {
+        size_t idx = find_index(key);
+        return idx == capacity_ ? end() : iterator_at(idx);
+    }
+
+    const_iterator find(const Key& key) const {
+        size_t idx = find_index(key);
+        return idx == capacity_ ? end() : const_iterator_at(idx);
+    }
+
+    size_t count(const Key& key) const {
+        return find_index(key) == capacity_ ? 0 : 1;
+    }
+
+    bool contains(const Key& key) const {
+        return find_index(key) != capacity_;
+    }
+
+    // Heterogeneous lookup (e.g. std::string keys probed with string_view)
+    // Enabled only when both Hash and KeyEqual declare is_transparent
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = std::enable_if_t<detail::is_transparent_v<H> && detail::is_transparent_v<E>>>
+    iterator find(const K& key) {
+        size_t idx = find_index(key);
+        return idx == capacity_ ? end() : iterator_at(idx);
+    }
+
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = std::enable_if_t<detail::is_transparent_v<H> && detail::is_transparent_v<E>>>
+    const_iterator find(const K& key) const {
+        size_t idx = find_index(key);
+        return idx == capacity_ ? end() : const_iterator_at(idx);
+    }
+
+    template<typename K, typename H = Hash, typename E = KeyEqual,
+             typename = std::enable_if_t<detail::is_transparent_v<H> && detail::is_transparent_v<E>>>
+    bool contains(const K& key) const {
+        return find_index(key) != capacity_;
+    }
+
+    Value& at(const Key& key) {
+        size_t idx = find_index(key);
+        if (idx == capacity_) throw std::out_of_range("FlatHashMap::at: key not found");
+        return slots_[idx].second;
+    }
+
+    const Value& at(const Key& key) const {
+        size_t idx = find_index(key);
+        if (idx == capacity_) throw std::out_of_range("FlatHashMap::at: key not found");
+        return slots_[idx].second;
+    }
+
+    // ========================================================================
+    // Modifiers
+    // ========================================================================
+
+    Value& operator[](const Key& key) {
+        return try_emplace(key).first->second;
+    }
+
+    Value& operator[](Key&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+        return try_emplace_impl(key, std::forward<Args>(args)...);
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+        return try_emplace_impl(std::move(key), std::forward<Args>(args)...);
+    }
+
+    template<typename M>
+    std::pair<iterator, bool> insert_or_assign(const Key& key, M&& value) {
+        auto result = try_emplace(key, std::forward<M>(value));
+        if (!result.second) {
+            result.first->second = std::forward<M>(value);
+        }
+        return result;
+    }
+
+    std::pair<iterator, bool> insert(const value_type& entry) {
+        return try_emplace(entry.first, entry.second);
+    }
+
+    std::pair<iterator, bool> insert(value_type&& entry) {
+        return try_emplace(std::move(entry.first), std::move(entry.second));
+    }
+
+    template<typename... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type entry(std::forward<Args>(args)...);
+        return insert(std::move(entry));
+    }
+
+    iterator erase(const_iterator pos) {
+        size_t idx = static_cast<size_t>(pos.ctrl_ - ctrl_);
+        erase_at(idx);
+        iterator next = iterator_at(idx);
+        ++next;
+        return next;
+    }
+
+    iterator erase(iterator pos) {
+        return erase(const_iterator(pos));
+    }
+
+    size_t erase(const Key& key) {
+        size_t idx = find_index(key);
+        if (idx == capacity_) return 0;
+        erase_at(idx);
+        return 1;
+    }
+
+    // Remove all entries, keeping the allocated capacity
+    void clear() {
+        if (size_ == 0 && deleted_ == 0) return;
+        destroy_slots();
+        std::memset(ctrl_, static_cast<unsigned char>(detail::CTRL_EMPTY), capacity_ + GROUP_WIDTH);
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    void swap(FlatHashMap& other) noexcept {
+        using std::swap;
+        swap(ctrl_, other.ctrl_);
+        swap(slots_, other.slots_);
+        swap(capacity_, other.capacity_);
+        swap(size_, other.size_);
+        swap(deleted_, other.deleted_);
+        swap(hash_, other.hash_);
+        swap(eq_, other.eq_);
+        if constexpr (slot_traits::propagate_on_container_swap::value) {
+            swap(slot_alloc_, other.slot_alloc_);
+        }
+    }
+
+private:
+    // ========================================================================
+    // Internals
+    // ========================================================================
+
+    // Smallest power-of-two capacity keeping n elements under 7/8 load
+    static size_t capacity_for(size_t n) {
+        if (n == 0) return 0;
+        size_t min_slots = n + (n + 6) / 7;  // ceil(n * 8 / 7)
+        size_t cap = MIN_CAPACITY;
+        while (cap < min_slots) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    static size_t max_load(size_t capacity) {
+        return capacity - capacity / 8;
+    }
+
+    template<typename K, typename... Args>
+    std::pair<iterator, bool> try_emplace_impl(K&& key, Args&&... args) {
+        size_t hash = hash_key(key);
+        size_t idx = find_index(key, hash);
+        if (idx != capacity_) {
+            return {iterator_at(idx), false};
+        }
+        idx = prepare_insert(hash);
+        slot_traits::construct(slot_alloc_, slots_ + idx,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(std::forward<K>(key)),
+                               std::forward_as_tuple(std::forward<Args>(args)...));
+        return {iterator_at(idx), true};
+    }
+
+    template<typename K>
+    size_t hash_key(const K& key) const {
+        return detail::mix_hash(hash_(key));
+    }
+
+    static uint8_t h2(size_t hash) { return static_cast<uint8_t>(hash & 0x7F); }
+    static size_t h1(size_t hash) { return hash >> 7; }
+
+    iterator iterator_at(size_t idx) {
+        return iterator(ctrl_ + idx, ctrl_ + capacity_, slots_ + idx);
+    }
+
+    const_iterator const_iterator_at(size_t idx) const {
+        return const_iterator(ctrl_ + idx, ctrl_ + capacity_, slots_ + idx);
+    }
+
+    template<typename K>
+    size_t find_index(const K& key) const {
+        if (size_ == 0) return capacity_;
+        return find_index(key, hash_key(key));
+    }
+
+    // Returns capacity_ if not found
+    template<typename K>
+    size_t find_index(const K& key, size_t hash) const {
+        if (capacity_ == 0) return capacity_;
+        const size_t mask = capacity_ - 1;
+        size_t pos = h1(hash) & mask;
+        size_t step = 0;
+        while (true) {
+            detail::Group group(ctrl_ + pos);
+            for (auto m = group.match(h2(hash)); m; m.clear_lowest()) {
+                size_t idx = (pos + m.lowest()) & mask;
+                if (eq_(slots_[idx].first, key)) {
+                    return idx;
+                }
+            }
+            if (group.match_empty()) {
+                return capacity_;
+            }
+            step += GROUP_WIDTH;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // First empty or deleted slot in the probe sequence for hash
+    size_t find_insert_slot(size_t hash) const {
+        const size_t mask = capacity_ - 1;
+        size_t pos = h1(hash) & mask;
+        size_t step = 0;
+        while (true) {
+            detail::Group group(ctrl_ + pos);
+            auto m = group.match_empty_or_deleted();
+            if (m) {
+                return (pos + m.lowest()) & mask;
+            }
+            step += GROUP_WIDTH;
+            pos = (pos + step) & mask;
+        }
+    }
+
+    // Reserve a slot for a key known to be absent; grows if needed
+    size_t prepare_insert(size_t hash) {
+        if (capacity_ == 0) {
+            resize(MIN_CAPACITY);
+        } else if (size_ + deleted_ + 1 > max_load(capacity_)) {
+            // Mostly tombstones: rehash in place, otherwise grow
+            resize(size_ + 1 <= max_load(capacity_) / 2 ? capacity_ : capacity_ * 2);
+        }
+        size_t idx = find_insert_slot(hash);
+        if (ctrl_[idx] == detail::CTRL_DELETED) {
+            --deleted_;
+        }
+        set_ctrl(idx, static_cast<int8_t>(h2(hash)));
+        ++size_;
+        return idx;
+    }
+
+    void set_ctrl(size_t idx, int8_t value) {
+        ctrl_[idx] = value;
+        // Mirror the first GROUP_WIDTH bytes past the end for wrap-free loads
+        if (idx < GROUP_WIDTH) {
+            ctrl_[capacity_ + idx] = value;
+        }
+    }
+
+    void erase_at(size_t idx) {
+        slot_traits::destroy(slot_alloc_, slots_ + idx);
+        --size_;
+        if (was_never_full(idx)) {
+            set_ctrl(idx, detail::CTRL_EMPTY);
+        } else {
+            set_ctrl(idx, detail::CTRL_DELETED);
+            ++deleted_;
+        }
+    }
+
+    // True if every group window covering idx also covers an empty slot, so
+    // no probe sequence can have passed over idx. Such a slot can be marked
+    // empty instead of deleted, which keeps erase/insert churn from
+    // accumulating tombstones (and the rehash they eventually force).
+    bool was_never_full(size_t idx) const {
+        auto empty_before = detail::Group(ctrl_ + ((idx - GROUP_WIDTH) & (capacity_ - 1))).match_empty();
+        auto empty_after = detail::Group(ctrl_ + idx).match_empty();
+        if (!empty_before || !empty_after) return false;
+        size_t full_before = GROUP_WIDTH - 1 - empty_before.highest();
+        size_t full_from = empty_after.lowest();
+        return full_before + full_from < GROUP_WIDTH;
+    }
+
+    void resize(size_t new_capacity) {
+        int8_t* old_ctrl = ctrl_;
+        value_type* old_slots = slots_;
+        size_t old_capacity = capacity_;
+
+        allocate(new_capacity);
+
+        for (size_t i = 0; i < old_capacity; ++i) {
+            if (old_ctrl[i] >= 0) {
+                size_t hash = hash_key(old_slots[i].first);
+                size_t idx = find_insert_slot(hash);
+                set_ctrl(idx, static_cast<int8_t>(h2(hash)));
+                slot_traits::construct(slot_alloc_, slots_ + idx, std::move(old_slots[i]));
+                slot_traits::destroy(slot_alloc_, old_slots + i);
+            }
+        }
+        deleted_ = 0;
+
+        deallocate(old_ctrl, old_slots, old_capacity);
+    }
+
+    void allocate(size_t capacity) {
+        ctrl_allocator ctrl_alloc(slot_alloc_);
+        ctrl_ = ctrl_traits::allocate(ctrl_alloc, capacity + GROUP_WIDTH);
+        slots_ = slot_traits::allocate(slot_alloc_, capacity);
+        capacity_ = capacity;
+        std::memset(ctrl_, static_cast<unsigned char>(detail::CTRL_EMPTY), capacity + GROUP_WIDTH);
+    }
+
+    void deallocate(int8_t* ctrl, value_type* slots, size_t capacity) {
+        if (capacity == 0) return;
+        ctrl_allocator ctrl_alloc(slot_alloc_);
+        ctrl_traits::deallocate(ctrl_alloc, ctrl, capacity + GROUP_WIDTH);
+        slot_traits::deallocate(slot_alloc_, slots, capacity);
+    }
+
+    void destroy_slots() {
+        if constexpr (!std::is_trivially_destructible_v<value_type>) {
+            for (size_t i = 0; i < capacity_; ++i) {
+                if (ctrl_[i] >= 0) {
+                    slot_traits::destroy(slot_alloc_, slots_ + i);
+                }
+            }
+        }
+    }
+
+    void destroy_and_deallocate() {
+        destroy_slots();
+        deallocate(ctrl_, slots_, capacity_);
+        reset_empty();
+    }
+
+    void reset_empty() {
+        ctrl_ = nullptr;
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    // Copy layout slot-for-slot (same capacity, same positions)
+    void copy_from(const FlatHashMap& other) {
+        if (other.size_ == 0) return;
+        allocate(other.capacity_);
+        std::memcpy(ctrl_, other.ctrl_, capacity_ + GROUP_WIDTH);
+        for (size_t i = 0; i < capacity_; ++i) {
+            if (ctrl_[i] >= 0) {
+                slot_traits::construct(slot_alloc_, slots_ + i, other.slots_[i]);
+            }
+        }
+        size_ = other.size_;
+        deleted_ = other.deleted_;
+    }
+};
+
+template<typename K, typename V, typename H, typename E, typename A>
+void swap(FlatHashMap<K, V, H, E, A>& a, FlatHashMap<K, V, H, E, A>& b) noexcept {
+    a.swap(b);
+}
+
+} // namespace aggregation
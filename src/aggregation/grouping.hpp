@@ -1,6 +1,9 @@
 #pragma once
 
+#include "interning.hpp"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <functional>
 
 namespace aggregation {
@@ -17,9 +20,31 @@ struct GlobalKey {
     static GlobalKey instance() { return GlobalKey{}; }
 };
 
+// Identifier-based keys hold interned IDs (see interning.hpp), so copying,
+// comparing and hashing a key never touches a string. Constructing a key from
+// a string interns it; lookup() only finds an existing ID and yields a key that
+// matches nothing when the string was never interned.
+
 // Per-underlyer aggregation
 struct UnderlyerKey {
-    std::string underlyer;
+    InternedId underlyer = INVALID_INTERNED_ID;
+
+    UnderlyerKey() = default;
+    explicit UnderlyerKey(std::string_view name)
+        : underlyer(UnderlyerInterner::instance().intern(name)) {}
+
+    static UnderlyerKey from_id(InternedId id) {
+        UnderlyerKey key;
+        key.underlyer = id;
+        return key;
+    }
+    static UnderlyerKey lookup(std::string_view name) {
+        return from_id(UnderlyerInterner::instance().find(name));
+    }
+
+    const std::string& underlyer_name() const {
+        return UnderlyerInterner::instance().resolve(underlyer);
+    }
 
     bool operator==(const UnderlyerKey& other) const {
         return underlyer == other.underlyer;
@@ -31,7 +56,24 @@ struct UnderlyerKey {
 
 // Per-instrument aggregation
 struct InstrumentKey {
-    std::string symbol;
+    InternedId symbol = INVALID_INTERNED_ID;
+
+    InstrumentKey() = default;
+    explicit InstrumentKey(std::string_view name)
+        : symbol(SymbolInterner::instance().intern(name)) {}
+
+    static InstrumentKey from_id(InternedId id) {
+        InstrumentKey key;
+        key.symbol = id;
+        return key;
+    }
+    static InstrumentKey lookup(std::string_view name) {
+        return from_id(SymbolInterner::instance().find(name));
+    }
+
+    const std::string& symbol_name() const {
+        return SymbolInterner::instance().resolve(symbol);
+    }
 
     bool operator==(const InstrumentKey& other) const {
         return symbol == other.symbol;
@@ -43,10 +85,27 @@ struct InstrumentKey {
 
 // Per-strategy aggregation
 struct StrategyKey {
-    std::string strategy_id;
+    InternedId strategy = INVALID_INTERNED_ID;
+
+    StrategyKey() = default;
+    explicit StrategyKey(std::string_view name)
+        : strategy(StrategyInterner::instance().intern(name)) {}
+
+    static StrategyKey from_id(InternedId id) {
+        StrategyKey key;
+        key.strategy = id;
+        return key;
+    }
+    static StrategyKey lookup(std::string_view name) {
+        return from_id(StrategyInterner::instance().find(name));
+    }
+
+    const std::string& strategy_name() const {
+        return StrategyInterner::instance().resolve(strategy);
+    }
 
     bool operator==(const StrategyKey& other) const {
-        return strategy_id == other.strategy_id;
+        return strategy == other.strategy;
     }
     bool operator!=(const StrategyKey& other) const {
         return !(*this == other);
@@ -55,10 +114,27 @@ struct StrategyKey {
 
 // Per-portfolio aggregation
 struct PortfolioKey {
-    std::string portfolio_id;
+    InternedId portfolio = INVALID_INTERNED_ID;
+
+    PortfolioKey() = default;
+    explicit PortfolioKey(std::string_view name)
+        : portfolio(PortfolioInterner::instance().intern(name)) {}
+
+    static PortfolioKey from_id(InternedId id) {
+        PortfolioKey key;
+        key.portfolio = id;
+        return key;
+    }
+    static PortfolioKey lookup(std::string_view name) {
+        return from_id(PortfolioInterner::instance().find(name));
+    }
+
+    const std::string& portfolio_name() const {
+        return PortfolioInterner::instance().resolve(portfolio);
+    }
 
     bool operator==(const PortfolioKey& other) const {
-        return portfolio_id == other.portfolio_id;
+        return portfolio == other.portfolio;
     }
     bool operator!=(const PortfolioKey& other) const {
         return !(*this == other);
@@ -67,8 +143,26 @@ struct PortfolioKey {
 
 // Composite key for instrument + side
 struct InstrumentSideKey {
-    std::string symbol;
-    int side;  // 1=Bid, 2=Ask
+    InternedId symbol = INVALID_INTERNED_ID;
+    int side = 0;  // 1=Bid, 2=Ask
+
+    InstrumentSideKey() = default;
+    InstrumentSideKey(std::string_view symbol_name, int side_)
+        : symbol(SymbolInterner::instance().intern(symbol_name)), side(side_) {}
+
+    static InstrumentSideKey from_id(InternedId symbol_id, int side_) {
+        InstrumentSideKey key;
+        key.symbol = symbol_id;
+        key.side = side_;
+        return key;
+    }
+    static InstrumentSideKey lookup(std::string_view symbol_name, int side_) {
+        return from_id(SymbolInterner::instance().find(symbol_name), side_);
+    }
+
+    const std::string& symbol_name() const {
+        return SymbolInterner::instance().resolve(symbol);
+    }
 
     bool operator==(const InstrumentSideKey& other) const {
         return symbol == other.symbol && side == other.side;
@@ -80,11 +174,34 @@ struct InstrumentSideKey {
 
 // Composite key for portfolio + instrument
 struct PortfolioInstrumentKey {
-    std::string portfolio_id;
-    std::string symbol;
+    InternedId portfolio = INVALID_INTERNED_ID;
+    InternedId symbol = INVALID_INTERNED_ID;
+
+    PortfolioInstrumentKey() = default;
+    PortfolioInstrumentKey(std::string_view portfolio_name, std::string_view symbol_name)
+        : portfolio(PortfolioInterner::instance().intern(portfolio_name)),
+          symbol(SymbolInterner::instance().intern(symbol_name)) {}
+
+    static PortfolioInstrumentKey from_id(InternedId portfolio_id, InternedId symbol_id) {
+        PortfolioInstrumentKey key;
+        key.portfolio = portfolio_id;
+        key.symbol = symbol_id;
+        return key;
+    }
+    static PortfolioInstrumentKey lookup(std::string_view portfolio_name, std::string_view symbol_name) {
+        return from_id(PortfolioInterner::instance().find(portfolio_name),
+                       SymbolInterner::instance().find(symbol_name));
+    }
+
+    const std::string& portfolio_name() const {
+        return PortfolioInterner::instance().resolve(portfolio);
+    }
+    const std::string& symbol_name() const {
+        return SymbolInterner::instance().resolve(symbol);
+    }
 
     bool operator==(const PortfolioInstrumentKey& other) const {
-        return portfolio_id == other.portfolio_id && symbol == other.symbol;
+        return portfolio == other.portfolio && symbol == other.symbol;
     }
     bool operator!=(const PortfolioInstrumentKey& other) const {
         return !(*this == other);
@@ -105,46 +222,47 @@ namespace std {
     template<>
     struct hash<aggregation::UnderlyerKey> {
         size_t operator()(const aggregation::UnderlyerKey& key) const {
-            return hash<string>{}(key.underlyer);
+            return hash<uint32_t>{}(key.underlyer);
         }
     };
 
     template<>
     struct hash<aggregation::InstrumentKey> {
         size_t operator()(const aggregation::InstrumentKey& key) const {
-            return hash<string>{}(key.symbol);
+            return hash<uint32_t>{}(key.symbol);
         }
     };
 
     template<>
     struct hash<aggregation::StrategyKey> {
         size_t operator()(const aggregation::StrategyKey& key) const {
-            return hash<string>{}(key.strategy_id);
+            return hash<uint32_t>{}(key.strategy);
         }
     };
 
     template<>
     struct hash<aggregation::PortfolioKey> {
         size_t operator()(const aggregation::PortfolioKey& key) const {
-            return hash<string>{}(key.portfolio_id);
+            return hash<uint32_t>{}(key.portfolio);
         }
     };
 
+    // Composite keys pack both 32-bit components into one word, so distinct
+    // keys never share a hash input
     template<>
     struct hash<aggregation::InstrumentSideKey> {
         size_t operator()(const aggregation::InstrumentSideKey& key) const {
-            size_t h1 = hash<string>{}(key.symbol);
-            size_t h2 = hash<int>{}(key.side);
-            return h1 ^ (h2 << 1);
+            uint64_t packed = (static_cast<uint64_t>(key.symbol) << 32) |
+                              static_cast<uint32_t>(key.side);
+            return hash<uint64_t>{}(packed);
         }
     };
 
     template<>
     struct hash<aggregation::PortfolioInstrumentKey> {
         size_t operator()(const aggregation::PortfolioInstrumentKey& key) const {
-            size_t h1 = hash<string>{}(key.portfolio_id);
-            size_t h2 = hash<string>{}(key.symbol);
-            return h1 ^ (h2 << 1);
+            uint64_t packed = (static_cast<uint64_t>(key.portfolio) << 32) | key.symbol;
+            return hash<uint64_t>{}(packed);
         }
     };
 }
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "flat_hash_map.hpp"
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace aggregation {
+
+// ============================================================================
+// String interning - dense 32-bit IDs for identifiers
+// ============================================================================
+//
+// Symbols, underlyers, strategy IDs and portfolio IDs are interned once at
+// order entry (OrderBook::add_order). Grouping keys, key extractors, limit
+// stores and metrics then work on the IDs, so the per-event path neither
+// copies nor hashes strings. Strings are only resolved back for reporting
+// (e.g. LimitBreachInfo::key).
+//
+// Each identifier kind has its own domain so IDs stay dense per kind, which
+// keeps ID-indexed tables small (e.g. a few thousand underlyers even when
+// hundreds of thousands of option symbols are interned).
+//
+// IDs are process-wide and never recycled. Like the rest of the library the
+// interners are not thread-safe; engines sharing a process must intern from a
+// single thread.
+//
+
+using InternedId = uint32_t;
+
+// Returned by lookups for strings that were never interned
+inline constexpr InternedId INVALID_INTERNED_ID = std::numeric_limits<InternedId>::max();
+
+// Domain tags
+struct SymbolDomain {};
+struct UnderlyerDomain {};
+struct StrategyDomain {};
+struct PortfolioDomain {};
+
+// Transparent string hash/equality: lets std::string-keyed FlatHashMaps be
+// probed with string_view or const char* without building a std::string
+struct TransparentStringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+struct TransparentStringEqual {
+    using is_transparent = void;
+
+    bool operator()(std::string_view a, std::string_view b) const {
+        return a == b;
+    }
+};
+
+template<typename Domain>
+class StringInterner {
+private:
+    // Always FlatHashMap (not HashMap): heterogeneous lookup is required
+    FlatHashMap<std::string, InternedId, TransparentStringHash, TransparentStringEqual> ids_;
+    std::deque<std::string> names_;  // Indexed by ID; deque keeps references stable
+
+public:
+    // Process-wide interner for this domain
+    static StringInterner& instance() {
+        static StringInterner interner;
+        return interner;
+    }
+
+    // Get the ID for a string, assigning a new one if needed
+    InternedId intern(std::string_view name) {
+        auto it = ids_.find(name);
+        if (it != ids_.end()) {
+            return it->second;
+        }
+        InternedId id = static_cast<InternedId>(names_.size());
+        names_.emplace_back(name);
+        ids_.try_emplace(names_.back(), id);
+        return id;
+    }
+
+    // Get the ID for a string without interning it (never allocates)
+    // Returns INVALID_INTERNED_ID if the string was never interned
+    InternedId find(std::string_view name) const {
+        auto it = ids_.find(name);
+        return (it != ids_.end()) ? it->second : INVALID_INTERNED_ID;
+    }
+
+    // Resolve an ID back to its string (empty string for INVALID_INTERNED_ID)
+    const std::string& resolve(InternedId id) const {
+        static const std::string empty;
+        return (id < names_.size()) ? names_[id] : empty;
+    }
+
+    // Number of interned strings (IDs are in [0, size()))
+    size_t size() const {
+        return names_.size();
+    }
+};
+
+using SymbolInterner = StringInterner<SymbolDomain>;
+using UnderlyerInterner = StringInterner<UnderlyerDomain>;
+using StrategyInterner = StringInterner<StrategyDomain>;
+using PortfolioInterner = StringInterner<PortfolioDomain>;
+
+} // namespace aggregation
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "grouping.hpp"
+#include "../fix/fix_types.hpp"
 
 // Forward declarations
 namespace engine {
     struct TrackedOrder;
+    struct OrderIds;
 }
 
 namespace aggregation {
@@ -15,11 +17,17 @@ namespace aggregation {
 //
 // Each specialization provides:
 // - extract(order): Extract the key from a TrackedOrder
+// - extract(ids, side): Extract the key from resolved order IDs (used by the
+//   pre-trade path, which resolves a NewOrderSingle's identifiers once and
+//   then builds every metric's key from them)
 // - is_applicable(order): Returns true if this grouping level applies to the order
 //
 // The is_applicable() method allows conditional aggregation, e.g., skipping
 // strategy-level aggregation for orders with empty strategy_id.
 //
+// Keys are built from the interned IDs in TrackedOrder::ids, so extraction
+// does no string copying or hashing.
+//
 
 // Primary template - must be specialized for each key type
 template<typename Key>
@@ -32,6 +40,10 @@ struct KeyExtractor<GlobalKey> {
         return GlobalKey::instance();
     }
 
+    static GlobalKey extract(const engine::OrderIds& /*ids*/, fix::Side /*side*/) {
+        return GlobalKey::instance();
+    }
+
     static bool is_applicable(const engine::TrackedOrder& /*order*/) {
         return true;
     }
@@ -41,6 +53,7 @@ struct KeyExtractor<GlobalKey> {
 template<>
 struct KeyExtractor<UnderlyerKey> {
     static UnderlyerKey extract(const engine::TrackedOrder& order);
+    static UnderlyerKey extract(const engine::OrderIds& ids, fix::Side side);
 
     static bool is_applicable(const engine::TrackedOrder& /*order*/) {
         return true;
@@ -51,6 +64,7 @@ struct KeyExtractor<UnderlyerKey> {
 template<>
 struct KeyExtractor<InstrumentKey> {
     static InstrumentKey extract(const engine::TrackedOrder& order);
+    static InstrumentKey extract(const engine::OrderIds& ids, fix::Side side);
 
     static bool is_applicable(const engine::TrackedOrder& /*order*/) {
         return true;
@@ -61,6 +75,7 @@ struct KeyExtractor<InstrumentKey> {
 template<>
 struct KeyExtractor<StrategyKey> {
     static StrategyKey extract(const engine::TrackedOrder& order);
+    static StrategyKey extract(const engine::OrderIds& ids, fix::Side side);
 
     static bool is_applicable(const engine::TrackedOrder& order);
 };
@@ -69,6 +84,7 @@ struct KeyExtractor<StrategyKey> {
 template<>
 struct KeyExtractor<PortfolioKey> {
     static PortfolioKey extract(const engine::TrackedOrder& order);
+    static PortfolioKey extract(const engine::OrderIds& ids, fix::Side side);
 
     static bool is_applicable(const engine::TrackedOrder& order);
 };
@@ -77,6 +93,7 @@ struct KeyExtractor<PortfolioKey> {
 template<>
 struct KeyExtractor<InstrumentSideKey> {
     static InstrumentSideKey extract(const engine::TrackedOrder& order);
+    static InstrumentSideKey extract(const engine::OrderIds& ids, fix::Side side);
 
     static bool is_applicable(const engine::TrackedOrder& /*order*/) {
         return true;
@@ -87,6 +104,7 @@ struct KeyExtractor<InstrumentSideKey> {
 template<>
 struct KeyExtractor<PortfolioInstrumentKey> {
     static PortfolioInstrumentKey extract(const engine::TrackedOrder& order);
+    static PortfolioInstrumentKey extract(const engine::OrderIds& ids, fix::Side side);
 
     static bool is_applicable(const engine::TrackedOrder& order);
 };
@@ -99,15 +117,27 @@ struct KeyExtractor<PortfolioInstrumentKey> {
 namespace aggregation {
 
 inline UnderlyerKey KeyExtractor<UnderlyerKey>::extract(const engine::TrackedOrder& order) {
-    return UnderlyerKey{order.underlyer};
+    return extract(order.ids, order.side);
+}
+
+inline UnderlyerKey KeyExtractor<UnderlyerKey>::extract(const engine::OrderIds& ids, fix::Side /*side*/) {
+    return UnderlyerKey::from_id(ids.underlyer);
 }
 
 inline InstrumentKey KeyExtractor<InstrumentKey>::extract(const engine::TrackedOrder& order) {
-    return InstrumentKey{order.symbol};
+    return extract(order.ids, order.side);
+}
+
+inline InstrumentKey KeyExtractor<InstrumentKey>::extract(const engine::OrderIds& ids, fix::Side /*side*/) {
+    return InstrumentKey::from_id(ids.symbol);
 }
 
 inline StrategyKey KeyExtractor<StrategyKey>::extract(const engine::TrackedOrder& order) {
-    return StrategyKey{order.strategy_id};
+    return extract(order.ids, order.side);
+}
+
+inline StrategyKey KeyExtractor<StrategyKey>::extract(const engine::OrderIds& ids, fix::Side /*side*/) {
+    return StrategyKey::from_id(ids.strategy);
 }
 
 inline bool KeyExtractor<StrategyKey>::is_applicable(const engine::TrackedOrder& order) {
@@ -115,7 +145,11 @@ inline bool KeyExtractor<StrategyKey>::is_applicable(const engine::TrackedOrder&
 }
 
 inline PortfolioKey KeyExtractor<PortfolioKey>::extract(const engine::TrackedOrder& order) {
-    return PortfolioKey{order.portfolio_id};
+    return extract(order.ids, order.side);
+}
+
+inline PortfolioKey KeyExtractor<PortfolioKey>::extract(const engine::OrderIds& ids, fix::Side /*side*/) {
+    return PortfolioKey::from_id(ids.portfolio);
 }
 
 inline bool KeyExtractor<PortfolioKey>::is_applicable(const engine::TrackedOrder& order) {
@@ -123,11 +157,19 @@ inline bool KeyExtractor<PortfolioKey>::is_applicable(const engine::TrackedOrder
 }
 
 inline InstrumentSideKey KeyExtractor<InstrumentSideKey>::extract(const engine::TrackedOrder& order) {
-    return InstrumentSideKey{order.symbol, static_cast<int>(order.side)};
+    return extract(order.ids, order.side);
+}
+
+inline InstrumentSideKey KeyExtractor<InstrumentSideKey>::extract(const engine::OrderIds& ids, fix::Side side) {
+    return InstrumentSideKey::from_id(ids.symbol, static_cast<int>(side));
 }
 
 inline PortfolioInstrumentKey KeyExtractor<PortfolioInstrumentKey>::extract(const engine::TrackedOrder& order) {
-    return PortfolioInstrumentKey{order.portfolio_id, order.symbol};
+    return extract(order.ids, order.side);
+}
+
+inline PortfolioInstrumentKey KeyExtractor<PortfolioInstrumentKey>::extract(const engine::OrderIds& ids, fix::Side /*side*/) {
+    return PortfolioInstrumentKey::from_id(ids.portfolio, ids.symbol);
 }
 
 inline bool KeyExtractor<PortfolioInstrumentKey>::is_applicable(const engine::TrackedOrder& order) {
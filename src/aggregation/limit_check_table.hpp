@@ -0,0 +1,69 @@
+#pragma once
+
+#include "staged_metric.hpp"
+#include "memory_resource.hpp"
+#include <cstdint>
+
+namespace aggregation {
+
+// ============================================================================
+// LimitUsage - A key's current value and effective limit
+// ============================================================================
+
+struct LimitUsage {
+    double current = 0.0;
+    double limit = 0.0;
+};
+
+// ============================================================================
+// LimitCheckTable - Co-located stage values plus the key's cached limit
+// ============================================================================
+//
+// A pre-trade check needs two things for a key: the metric's current value
+// and the key's effective limit. Read from per-stage buckets and the
+// LimitStore that is one probe per tracked stage plus one or two for the
+// limit.
+//
+// Metrics keep their per-key values in a LimitCheckTable: a StagedBucket
+// whose records also cache the key's effective limit, tagged with the
+// version of the limit store it came from. Limit stores take a new version
+// on every change (limits, default, comparison mode), so a stale cache
+// misses and reloads on the next check. In steady state, usage() is one
+// probe.
+//
+// The Limits type needs version() and get_limit(key) (see engine::LimitStore).
+//
+
+// Mutable: refreshed by usage() on the const check path
+struct CachedLimit {
+    static constexpr uint64_t NO_VERSION = 0;
+
+    mutable double limit = 0.0;
+    mutable uint64_t limit_version = NO_VERSION;
+};
+
+template<typename Key, typename Value, typename... Stages>
+class LimitCheckTable : public StagedBucket<Key, Value, CachedLimit, Stages...> {
+    using Base = StagedBucket<Key, Value, CachedLimit, Stages...>;
+
+public:
+    explicit LimitCheckTable(MemoryResource* resource = default_memory_resource())
+        : Base(resource) {}
+
+    // Value summed over the given stages plus the effective limit
+    template<typename Limits>
+    LimitUsage usage(const Key& key, const Limits& limits,
+                     bool position, bool open, bool in_flight) const {
+        const auto* record = this->find(key);
+        if (record == nullptr) {
+            return LimitUsage{0.0, limits.get_limit(key)};
+        }
+        if (record->limit_version != limits.version()) {
+            record->limit = limits.get_limit(key);
+            record->limit_version = limits.version();
+        }
+        return LimitUsage{static_cast<double>(record->sum(position, open, in_flight)), record->limit};
+    }
+};
+
+} // namespace aggregation
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace aggregation {
+
+// ============================================================================
+// Memory resources - Per-engine allocation through std::pmr
+// ============================================================================
+//
+// Every container the engine owns (order slab and ClOrdID index, metric
+// buckets and stored inputs, limit stores) allocates through a
+// std::pmr::memory_resource passed down from the engine's constructor. The
+// default is std::pmr::get_default_resource() (global new/delete), so
+// engines built without one behave as before.
+//
+// MemoryArena pins an engine's memory to one preallocated region: a
+// monotonic buffer over the region, with an unsynchronized pool on top that
+// recycles freed blocks. Optionally the region is backed by huge pages.
+//
+//   aggregation::MemoryArena arena({256u << 20, true});
+//   MyEngine engine(context, arena.resource());
+//
+// The arena must outlive the engine. Like the engine, it is single-threaded.
+//
+
+using MemoryResource = std::pmr::memory_resource;
+
+inline MemoryResource* default_memory_resource() {
+    return std::pmr::get_default_resource();
+}
+
+// Construct T from a memory resource if it accepts one, else default-construct
+template<typename T>
+T construct_with_resource(MemoryResource* resource) {
+    if constexpr (std::is_constructible_v<T, MemoryResource*>) {
+        return T(resource);
+    } else {
+        (void)resource;
+        return T{};
+    }
+}
+
+struct MemoryArenaOptions {
+    size_t capacity_bytes = size_t{64} << 20;
+    bool huge_pages = false;      // Back the region with huge pages if available
+    bool prefault = true;         // Touch the region up front (no page faults later)
+    bool allow_overflow = true;   // Fall back to new/delete when the region is exhausted;
+                                  // if false, exhaustion throws std::bad_alloc
+};
+
+class MemoryArena {
+private:
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+
+    struct Region {
+        void* data = nullptr;
+        size_t size = 0;
+        bool mapped = false;
+        bool huge_pages = false;
+
+        explicit Region(const MemoryArenaOptions& options) {
+            size = options.capacity_bytes;
+#if defined(__linux__)
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+            if (options.prefault) flags |= MAP_POPULATE;
+            if (options.huge_pages) {
+                size_t rounded = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+                void* p = ::mmap(nullptr, rounded, PROT_READ | PROT_WRITE, flags | MAP_HUGETLB, -1, 0);
+                if (p != MAP_FAILED) {
+                    data = p;
+                    size = rounded;
+                    mapped = true;
+                    huge_pages = true;
+                    return;
+                }
+            }
+            void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if (p == MAP_FAILED) throw std::bad_alloc();
+            data = p;
+            mapped = true;
+#ifdef MADV_HUGEPAGE
+            if (options.huge_pages) {
+                // No reserved huge pages: ask for transparent huge pages instead
+                ::madvise(data, size, MADV_HUGEPAGE);
+            }
+#endif
+#else
+            data = ::operator new(size, std::align_val_t{alignof(std::max_align_t)});
+            if (options.prefault) {
+                for (size_t i = 0; i < size; i += 4096) {
+                    static_cast<volatile char*>(data)[i] = 0;
+                }
+            }
+#endif
+        }
+
+        ~Region() {
+#if defined(__linux__)
+            if (mapped) ::munmap(data, size);
+#else
+            ::operator delete(data, std::align_val_t{alignof(std::max_align_t)});
+#endif
+        }
+
+        Region(const Region&) = delete;
+        Region& operator=(const Region&) = delete;
+    };
+
+    Region region_;
+    std::pmr::monotonic_buffer_resource buffer_;
+    std::pmr::unsynchronized_pool_resource pool_;
+
+public:
+    explicit MemoryArena(const MemoryArenaOptions& options = MemoryArenaOptions{})
+        : region_(options),
+          buffer_(region_.data, region_.size,
+                  options.allow_overflow ? std::pmr::new_delete_resource()
+                                         : std::pmr::null_memory_resource()),
+          pool_(&buffer_) {}
+
+    MemoryArena(const MemoryArena&) = delete;
+    MemoryArena& operator=(const MemoryArena&) = delete;
+
+    // Resource to hand to the engine
+    MemoryResource* resource() { return &pool_; }
+
+    size_t capacity() const { return region_.size; }
+    bool uses_huge_pages() const { return region_.huge_pages; }
+};
+
+} // namespace aggregation
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "memory_resource.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+namespace aggregation {
+
+// ============================================================================
+// OrderSlotTable - Per-order side table indexed by order slot
+// ============================================================================
+//
+// Metrics that remember something per order (e.g. the inputs captured when
+// the order was added, for drift-free removal) key it by the order's slot in
+// the OrderBook slab (TrackedOrder::handle.index) rather than by ClOrdID.
+// Slots are dense and stable across replaces, so every access is an array
+// index: no hashing of the ClOrdID and no re-keying when it changes.
+//
+// Slots are recycled by the OrderBook once orders are cleaned up, so owners
+// must reset() a slot when a new order takes it over.
+//
+// INVALID_SLOT (the slot of an order that is not held by an OrderBook) is
+// never stored: find() returns nullptr and assign() is a no-op.
+//
+
+template<typename T>
+class OrderSlotTable {
+public:
+    static constexpr uint32_t INVALID_SLOT = std::numeric_limits<uint32_t>::max();
+
+private:
+    std::pmr::vector<T> values_;
+    std::pmr::vector<uint8_t> present_;
+    size_t size_ = 0;
+
+public:
+    explicit OrderSlotTable(MemoryResource* resource = default_memory_resource())
+        : values_(resource), present_(resource) {}
+
+    T* find(uint32_t slot) {
+        return (slot < present_.size() && present_[slot]) ? &values_[slot] : nullptr;
+    }
+
+    const T* find(uint32_t slot) const {
+        return (slot < present_.size() && present_[slot]) ? &values_[slot] : nullptr;
+    }
+
+    void assign(uint32_t slot, const T& value) {
+        if (slot == INVALID_SLOT) return;
+        if (slot >= present_.size()) {
+            size_t new_size = std::max<size_t>(size_t{slot} + 1, present_.size() * 2);
+            values_.resize(new_size);
+            present_.resize(new_size, 0);
+        }
+        values_[slot] = value;
+        if (!present_[slot]) {
+            present_[slot] = 1;
+            ++size_;
+        }
+    }
+
+    void reset(uint32_t slot) {
+        if (slot < present_.size() && present_[slot]) {
+            present_[slot] = 0;
+            --size_;
+        }
+    }
+
+    size_t size() const { return size_; }
+
+    // Pre-size for slots [0, n)
+    void reserve(size_t n) {
+        if (n > present_.size()) {
+            values_.resize(n);
+            present_.resize(n, 0);
+        }
+    }
+
+    void clear() {
+        std::fill(present_.begin(), present_.end(), 0);
+        size_ = 0;
+    }
+};
+
+} // namespace aggregation
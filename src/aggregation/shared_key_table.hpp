@@ -0,0 +1,192 @@
+#pragma once
+
+#include "bucket_storage.hpp"
+#include "capacity_hints.hpp"
+#include "memory_resource.hpp"
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <vector>
+
+namespace aggregation {
+
+// ============================================================================
+// SharedKeyTable - One keyed table whose rows hold a record per column
+// ============================================================================
+//
+// Metrics grouped by the same key type each keep their per-key values in
+// their own table, so one event hashes the same key once per metric. A
+// SharedKeyTable holds them side by side instead: each key maps to one row,
+// and each metric owns a column of that row.
+//
+// The key -> row index lives in a BucketStorage (so dense and scalar keys
+// need no hashing); records live in one vector at row * columns + column.
+// The row of the last key looked up is remembered, so the metrics handling
+// one event find their column with a key comparison after the first lookup.
+//
+// A row whose records are all empty (Record::empty()) can be released with
+// release_if_empty(): its key is erased and the row goes on a free list for
+// the next new key, so the table holds the keys currently in use rather than
+// every key ever seen. Released rows are reset to Record{}. Columns are
+// normally added before any row; adding one later re-lays out the records.
+//
+
+template<typename Key, typename Record>
+class SharedKeyTable {
+private:
+    static constexpr uint32_t NO_ROW = std::numeric_limits<uint32_t>::max();
+
+    BucketStorage<Key, uint32_t> rows_;
+    std::pmr::vector<Record> records_;
+    std::pmr::vector<uint32_t> free_rows_;
+    size_t columns_ = 0;
+    uint32_t row_count_ = 0;   // Rows laid out, live or free
+
+    // Last key looked up and its row
+    mutable Key last_key_{};
+    mutable uint32_t last_row_ = NO_ROW;
+
+    uint32_t find_row(const Key& key) const {
+        if (last_row_ != NO_ROW && last_key_ == key) {
+            return last_row_;
+        }
+        const uint32_t* row = rows_.find(key);
+        if (row == nullptr) {
+            return NO_ROW;
+        }
+        last_key_ = key;
+        last_row_ = *row;
+        return *row;
+    }
+
+    Record& at(uint32_t row, size_t column) {
+        return records_[row * columns_ + column];
+    }
+
+    const Record& at(uint32_t row, size_t column) const {
+        return records_[row * columns_ + column];
+    }
+
+    bool row_empty(uint32_t row) const {
+        for (size_t column = 0; column < columns_; ++column) {
+            if (!at(row, column).empty()) return false;
+        }
+        return true;
+    }
+
+    void release_row(const Key& key, uint32_t row) {
+        rows_.modify(key, [](uint32_t&) { return true; });
+        for (size_t column = 0; column < columns_; ++column) {
+            at(row, column) = Record{};
+        }
+        free_rows_.push_back(row);
+        if (last_row_ == row) {
+            last_row_ = NO_ROW;
+        }
+    }
+
+public:
+    explicit SharedKeyTable(MemoryResource* resource = default_memory_resource())
+        : rows_(resource), records_(resource), free_rows_(resource) {}
+
+    // Add a column and return its index
+    size_t add_column() {
+        if (row_count_ > 0) {
+            std::pmr::vector<Record> records(records_.get_allocator());
+            records.reserve(size_t{row_count_} * (columns_ + 1));
+            for (uint32_t row = 0; row < row_count_; ++row) {
+                for (size_t column = 0; column < columns_; ++column) {
+                    records.push_back(at(row, column));
+                }
+                records.push_back(Record{});
+            }
+            records_.swap(records);
+        }
+        return columns_++;
+    }
+
+    size_t columns() const { return columns_; }
+
+    Record* find(const Key& key, size_t column) {
+        uint32_t row = find_row(key);
+        return row != NO_ROW ? &at(row, column) : nullptr;
+    }
+
+    const Record* find(const Key& key, size_t column) const {
+        uint32_t row = find_row(key);
+        return row != NO_ROW ? &at(row, column) : nullptr;
+    }
+
+    Record& find_or_insert(const Key& key, size_t column) {
+        uint32_t row = find_row(key);
+        if (row == NO_ROW) {
+            if (!free_rows_.empty()) {
+                row = free_rows_.back();
+                free_rows_.pop_back();
+            } else {
+                row = row_count_++;
+                records_.resize(size_t{row_count_} * columns_);
+            }
+            rows_.find_or_insert(key, row);
+            last_key_ = key;
+            last_row_ = row;
+        }
+        return at(row, column);
+    }
+
+    // Visit every row as func(key, record of column)
+    template<typename Func>
+    void for_each(size_t column, Func&& func) const {
+        rows_.for_each([this, column, &func](const Key& key, uint32_t row) {
+            func(key, at(row, column));
+        });
+    }
+
+    // Release key's row if every column's record is empty; returns true if
+    // it was released. Records of the row must not be used afterwards.
+    bool release_if_empty(const Key& key) {
+        uint32_t row = find_row(key);
+        if (row == NO_ROW || !row_empty(row)) return false;
+        release_row(key, row);
+        return true;
+    }
+
+    // Release every row whose records are all empty
+    void compact() {
+        std::pmr::vector<Key> empty_keys(records_.get_allocator());
+        rows_.for_each([this, &empty_keys](const Key& key, uint32_t row) {
+            if (row_empty(row)) empty_keys.push_back(key);
+        });
+        for (const Key& key : empty_keys) {
+            release_if_empty(key);
+        }
+    }
+
+    // Number of live rows (keys holding a record)
+    size_t size() const { return row_count_ - free_rows_.size(); }
+
+    // Pre-size for n keys
+    void reserve(size_t n) {
+        rows_.reserve(n);
+        records_.reserve(n * columns_);
+        free_rows_.reserve(n);
+    }
+
+    // Reset one column of every row, releasing rows left empty
+    void clear_column(size_t column) {
+        for (uint32_t row = 0; row < row_count_; ++row) {
+            at(row, column) = Record{};
+        }
+        compact();
+    }
+
+    void clear() {
+        rows_.clear();
+        records_.clear();
+        free_rows_.clear();
+        row_count_ = 0;
+        last_row_ = NO_ROW;
+    }
+};
+
+} // namespace aggregation
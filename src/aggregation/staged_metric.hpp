@@ -1,6 +1,12 @@
 #pragma once
 
 #include "order_stage.hpp"
+#include "bucket_storage.hpp"
+#include "shared_key_table.hpp"
+#include "capacity_hints.hpp"
+#include "memory_resource.hpp"
+#include <array>
+#include <cstdint>
 #include <type_traits>
 
 namespace aggregation {
@@ -16,12 +22,17 @@ namespace aggregation {
 template<bool Include, typename Data>
 struct ConditionalStorage {
     // Empty when Include=false - no data member
+    explicit ConditionalStorage(MemoryResource* /*resource*/ = default_memory_resource()) {}
+
     void clear() {}
 };
 
 template<typename Data>
 struct ConditionalStorage<true, Data> {
-    Data data{};
+    Data data;
+
+    explicit ConditionalStorage(MemoryResource* resource = default_memory_resource())
+        : data(construct_with_resource<Data>(resource)) {}
 
     void clear() {
         if constexpr (std::is_class_v<Data>) {
@@ -44,7 +55,9 @@ struct ConditionalStorage<true, Data> {
 //   StagedMetric<MyData, AllStages>                  // All three stages
 //   StagedMetric<MyData>                             // Default: all stages
 //
-// The Data type must have a clear() method.
+// The Data type must have a clear() method. If it is constructible from a
+// MemoryResource*, each stage's Data is built with the resource passed to the
+// StagedMetric constructor.
 //
 
 template<typename Data, typename... Stages>
@@ -63,6 +76,9 @@ private:
     ConditionalStorage<Config::track_in_flight, Data> in_flight_;
 
 public:
+    explicit StagedMetric(MemoryResource* resource = default_memory_resource())
+        : position_(resource), open_(resource), in_flight_(resource) {}
+
     // ========================================================================
     // Compile-time enabled accessors
     // ========================================================================
@@ -166,6 +182,13 @@ public:
         in_flight_.clear();
     }
 
+    // Pre-size every tracked stage (requires Data::reserve(const CapacityHints&))
+    void reserve(const CapacityHints& hints) {
+        for_each_stage([&hints](OrderStage /*stage*/, Data& data) {
+            data.reserve(hints);
+        });
+    }
+
     // Apply a function to each tracked stage
     template<typename Func>
     void for_each_stage(Func&& func) {
@@ -194,4 +217,213 @@ public:
     }
 };
 
+// ============================================================================
+// StagedBucket - Co-located per-stage sums, one record per key
+// ============================================================================
+//
+// A StagedMetric of AggregationBuckets keeps one bucket, and so one hash map,
+// per stage: a total over stages costs a lookup per stage, and a stage
+// transition erases from one map and inserts into another.
+//
+// StagedBucket is the co-located storage mode for sum aggregations: each key
+// maps to one StagedRecord holding its position/open/in-flight values side
+// by side. Totals are a single lookup and a stage move updates two fields of
+// the same record in place.
+//
+// Each stage value behaves like an entry of a per-stage AggregationBucket:
+// present once added to, and dropped when a removal brings it back to zero
+// (it then reads zero and further removals are no-ops). A record left with
+// no stage value is dropped too: its row is released once every column of
+// it is empty, so the table holds only keys with a value. Records derive
+// from Extra, which carries per-key data that belongs with the values (see
+// LimitCheckTable); it is lost when the record is dropped.
+//
+// Records live in a column of a SharedKeyTable: by default a one-column
+// table of the bucket's own, or after bind() a column of a table shared with
+// other buckets of the same key and record type.
+//
+// Usage:
+//   StagedBucket<UnderlyerKey, double, NoStageExtra, OpenStage, InFlightStage> values;
+//   values.add(OrderStage::IN_FLIGHT, key, 10.0);
+//   values.move(key, OrderStage::IN_FLIGHT, 10.0, OrderStage::OPEN, 10.0);
+//   values.total(key);  // 10.0
+//
+
+struct NoStageExtra {};
+
+template<typename Value, typename Extra = NoStageExtra>
+struct StagedRecord : Extra {
+    std::array<Value, 3> values{};  // Indexed by OrderStage
+    uint8_t present = 0;            // Bit i set = stage i holds a value
+
+    static constexpr size_t index(OrderStage stage) {
+        return static_cast<size_t>(stage);
+    }
+
+    Value get(OrderStage stage) const {
+        size_t i = index(stage);
+        return (present & (1u << i)) ? values[i] : Value{};
+    }
+
+    // No stage holds a value (see SharedKeyTable::release_if_empty)
+    bool empty() const { return present == 0; }
+
+    // Summed in POSITION, OPEN, IN_FLIGHT order, like for_each_stage()
+    Value sum(bool position, bool open, bool in_flight) const {
+        Value total{};
+        if (position) total += get(OrderStage::POSITION);
+        if (open) total += get(OrderStage::OPEN);
+        if (in_flight) total += get(OrderStage::IN_FLIGHT);
+        return total;
+    }
+
+    void add(OrderStage stage, Value delta) {
+        size_t i = index(stage);
+        if (!(present & (1u << i))) {
+            values[i] = Value{};
+            present |= static_cast<uint8_t>(1u << i);
+        }
+        values[i] = values[i] + delta;
+    }
+
+    void remove(OrderStage stage, Value delta) {
+        size_t i = index(stage);
+        if (present & (1u << i)) {
+            values[i] = values[i] - delta;
+            if (values[i] == Value{}) {
+                present &= static_cast<uint8_t>(~(1u << i));
+            }
+        }
+    }
+};
+
+template<typename Key, typename Value, typename Extra, typename... Stages>
+class StagedBucket {
+public:
+    using key_type = Key;
+    using value_type = Value;
+    using Config = StageConfig<Stages...>;
+    using Record = StagedRecord<Value, Extra>;
+    using table_type = SharedKeyTable<Key, Record>;
+
+private:
+    table_type own_;
+    table_type* shared_ = nullptr;
+    size_t column_ = 0;
+    size_t size_ = 0;   // Keys whose record holds a value
+
+    table_type& table() { return shared_ ? *shared_ : own_; }
+    const table_type& table() const { return shared_ ? *shared_ : own_; }
+
+    static constexpr bool is_tracked(OrderStage stage) {
+        switch (stage) {
+            case OrderStage::POSITION: return Config::track_position;
+            case OrderStage::OPEN: return Config::track_open;
+            case OrderStage::IN_FLIGHT: return Config::track_in_flight;
+        }
+        return false;
+    }
+
+    // Apply update to key's record, keeping size_ and releasing the record's
+    // row once it is empty everywhere
+    template<typename Update>
+    void update(Record& record, const Key& key, Update&& apply) {
+        bool was_empty = record.empty();
+        apply(record);
+        if (record.empty()) {
+            if (!was_empty) --size_;
+            table().release_if_empty(key);
+        } else if (was_empty) {
+            ++size_;
+        }
+    }
+
+public:
+    explicit StagedBucket(MemoryResource* resource = default_memory_resource())
+        : own_(resource) {
+        column_ = own_.add_column();
+    }
+
+    // Keep records in a new column of table from now on; bind before the
+    // first update (values recorded so far stay behind). The table must
+    // outlive the bucket.
+    void bind(table_type& table) {
+        own_.clear();
+        size_ = 0;
+        shared_ = &table;
+        column_ = table.add_column();
+    }
+
+    bool is_shared() const { return shared_ != nullptr; }
+
+    // Value of one stage (zero if absent or untracked)
+    Value get(OrderStage stage, const Key& key) const {
+        const Record* record = find(key);
+        return record ? record->get(stage) : Value{};
+    }
+
+    // Sum over all tracked stages - one lookup
+    Value total(const Key& key) const {
+        return sum(key, Config::track_position, Config::track_open, Config::track_in_flight);
+    }
+
+    // Sum over the given stages - one lookup
+    Value sum(const Key& key, bool position, bool open, bool in_flight) const {
+        const Record* record = find(key);
+        return record ? record->sum(position, open, in_flight) : Value{};
+    }
+
+    // Updates to untracked stages are ignored
+    void add(OrderStage stage, const Key& key, Value delta) {
+        if (!is_tracked(stage)) return;
+        update(table().find_or_insert(key, column_), key, [&](Record& record) { record.add(stage, delta); });
+    }
+
+    void remove(OrderStage stage, const Key& key, Value delta) {
+        if (!is_tracked(stage)) return;
+        if (Record* record = table().find(key, column_)) {
+            update(*record, key, [&](Record& r) { r.remove(stage, delta); });
+        }
+    }
+
+    // Remove old_delta from stage from and add new_delta to stage to, with
+    // one lookup
+    void move(const Key& key, OrderStage from, Value old_delta, OrderStage to, Value new_delta) {
+        update(table().find_or_insert(key, column_), key, [&](Record& record) {
+            if (is_tracked(from)) record.remove(from, old_delta);
+            if (is_tracked(to)) record.add(to, new_delta);
+        });
+    }
+
+    const Record* find(const Key& key) const {
+        return table().find(key, column_);
+    }
+
+    // Visit the keys holding a value for stage as func(key, value)
+    template<typename Func>
+    void for_each(OrderStage stage, Func&& func) const {
+        table().for_each(column_, [stage, &func](const Key& key, const Record& record) {
+            if (record.present & (1u << Record::index(stage))) {
+                func(key, record.values[Record::index(stage)]);
+            }
+        });
+    }
+
+    // Number of keys holding a value in this bucket (not other columns)
+    size_t size() const { return size_; }
+
+    void reserve(const CapacityHints& hints) {
+        table().reserve(key_capacity<Key>::from(hints));
+    }
+
+    void clear() {
+        size_ = 0;
+        if (shared_) {
+            shared_->clear_column(column_);
+        } else {
+            own_.clear();
+        }
+    }
+};
+
 } // namespace aggregation
@@ -2,11 +2,15 @@
 
 #include "accessor_mixin.hpp"
 #include "order_state.hpp"
+#include "../aggregation/allocation_counter.hpp"
+#include "../aggregation/capacity_hints.hpp"
+#include "../aggregation/order_slot_table.hpp"
 #include "../aggregation/order_stage.hpp"
 #include "../fix/fix_messages.hpp"
 #include "../instrument/instrument.hpp"
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace engine {
 
@@ -50,6 +54,237 @@ template<typename T, typename Instrument, typename Context>
 inline constexpr bool has_set_instrument_position_with_instrument_and_context_v =
     has_set_instrument_position_with_instrument_and_context<T, Instrument, Context>::value;
 
+// ============================================================================
+// Type trait: has_reserve
+// ============================================================================
+//
+// Detects if a metric type can pre-size its storage from CapacityHints
+//
+
+template<typename T, typename = void>
+struct has_reserve : std::false_type {};
+
+template<typename T>
+struct has_reserve<T,
+    std::void_t<decltype(std::declval<T&>().reserve(std::declval<const aggregation::CapacityHints&>()))>
+> : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_reserve_v = has_reserve<T>::value;
+
+// ============================================================================
+// Type trait: has_prepare_order
+// ============================================================================
+//
+// Detects if a metric can compute a new order's key and contribution once for
+// both the limit check and the add: it defines PreparedOrder, a static
+// prepare_order(msg, ids, instrument, context) and
+// on_order_added(order, prepared). Other metrics get a NoPreparedOrder
+// placeholder and are added the usual way.
+//
+
+template<typename T, typename = void>
+struct has_prepare_order : std::false_type {};
+
+template<typename T>
+struct has_prepare_order<T, std::void_t<typename T::PreparedOrder>> : std::true_type {};
+
+template<typename T>
+inline constexpr bool has_prepare_order_v = has_prepare_order<T>::value;
+
+struct NoPreparedOrder {};
+
+template<typename T, bool = has_prepare_order_v<T>>
+struct prepared_order_of {
+    using type = NoPreparedOrder;
+};
+
+template<typename T>
+struct prepared_order_of<T, true> {
+    using type = typename T::PreparedOrder;
+};
+
+template<typename T>
+using prepared_order_t = typename prepared_order_of<T>::type;
+
+// ============================================================================
+// Shared metric tables
+// ============================================================================
+//
+// A metric that keeps its per-key values in a shareable table defines
+// shared_table_type and bind_shared_table(table&) (see
+// aggregation::SharedKeyTable). The engine owns one table per distinct
+// shared_table_type used by two or more of its metrics and binds each of
+// those metrics to a column of it, so co-keyed metrics (e.g. gross and net
+// delta and vega by underlyer) keep one row per key and an event finds that
+// row once rather than once per metric. Detected at compile time; metrics
+// without a shareable table, or alone with theirs, keep their own.
+//
+
+template<typename T, typename = void>
+struct shared_table_of {
+    using type = void;
+};
+
+template<typename T>
+struct shared_table_of<T, std::void_t<typename T::shared_table_type>> {
+    using type = typename T::shared_table_type;
+};
+
+template<typename T>
+using shared_table_t = typename shared_table_of<T>::type;
+
+namespace detail {
+
+template<typename Tables, typename Table>
+struct append_table;
+
+template<typename... Tables, typename Table>
+struct append_table<std::tuple<Tables...>, Table> {
+    using type = std::conditional_t<
+        std::is_void_v<Table> || std::disjunction_v<std::is_same<Table, Tables>...>,
+        std::tuple<Tables...>,
+        std::tuple<Tables..., Table>>;
+};
+
+template<typename Tables, typename... Ts>
+struct unique_tables {
+    using type = Tables;
+};
+
+template<typename Tables, typename T, typename... Rest>
+struct unique_tables<Tables, T, Rest...>
+    : unique_tables<typename append_table<Tables, T>::type, Rest...> {};
+
+} // namespace detail
+
+template<typename... Metrics>
+struct shared_metric_tables {
+    // Number of metrics keeping their values in a Table
+    template<typename Table>
+    static constexpr size_t users = (size_t{0} + ... + size_t{std::is_same_v<shared_table_t<Metrics>, Table>});
+
+    // Engine-owned table Metric is bound to, or void
+    template<typename Metric>
+    using table_for = std::conditional_t<
+        !std::is_void_v<shared_table_t<Metric>> && (users<shared_table_t<Metric>> >= 2),
+        shared_table_t<Metric>,
+        void>;
+
+    // Tuple of the engine-owned tables
+    using type = typename detail::unique_tables<std::tuple<>, table_for<Metrics>...>::type;
+
+    template<typename... Tables>
+    static std::tuple<Tables...> make(std::tuple<Tables...>* /*tag*/, aggregation::MemoryResource* resource) {
+        (void)resource;  // Unused when no metrics are grouped
+        return std::tuple<Tables...>(aggregation::construct_with_resource<Tables>(resource)...);
+    }
+
+    static type make(aggregation::MemoryResource* resource) {
+        return make(static_cast<type*>(nullptr), resource);
+    }
+
+    // Bind every grouped metric to a column of its table
+    static void bind(std::tuple<Metrics...>& metrics, type& tables) {
+        std::apply([&tables](auto&... metric) {
+            (bind_metric(metric, tables), ...);
+        }, metrics);
+    }
+
+private:
+    template<typename Metric>
+    static void bind_metric(Metric& metric, type& tables) {
+        using Table = table_for<Metric>;
+        if constexpr (!std::is_void_v<Table>) {
+            metric.bind_shared_table(std::get<Table>(tables));
+        } else {
+            (void)metric;
+            (void)tables;
+        }
+    }
+};
+
+// ============================================================================
+// Shared order inputs
+// ============================================================================
+//
+// Metrics that remove an order with the inputs captured for it (exposure
+// metrics, see metrics::OrderInputTable) define order_inputs_type and
+// bind_order_inputs(table&). The engine owns one such table for all of them,
+// so an order's inputs are captured once per event and stored once, and
+// tells it when events begin and which orders entered a stage, were
+// partially filled or were removed. Engines without such metrics get NoOrderInputs, whose
+// hooks do nothing.
+//
+
+template<typename T, typename = void>
+struct order_inputs_of {
+    using type = void;
+};
+
+template<typename T>
+struct order_inputs_of<T, std::void_t<typename T::order_inputs_type>> {
+    using type = typename T::order_inputs_type;
+};
+
+template<typename T>
+inline constexpr bool has_order_inputs_v = !std::is_void_v<typename order_inputs_of<T>::type>;
+
+struct NoOrderInputs {
+    struct record_type {};
+
+    explicit NoOrderInputs(aggregation::MemoryResource* /*resource*/ = nullptr) {}
+
+    template<typename Context, typename Instrument>
+    record_type capture(const Context&, const Instrument&) const { return {}; }
+
+    void begin_event() {}
+    void on_stage_entered(const TrackedOrder&) {}
+    void on_stage_entered(const TrackedOrder&, const record_type&) {}
+    void on_partial_fill(const TrackedOrder&, int64_t) {}
+    void on_order_removed(const TrackedOrder&) {}
+    void reserve(const aggregation::CapacityHints&) {}
+    void clear() {}
+};
+
+namespace detail {
+
+template<typename... Metrics>
+struct first_order_inputs {
+    using type = NoOrderInputs;
+};
+
+template<typename Metric, typename... Rest>
+struct first_order_inputs<Metric, Rest...>
+    : std::conditional_t<has_order_inputs_v<Metric>, order_inputs_of<Metric>, first_order_inputs<Rest...>> {};
+
+} // namespace detail
+
+template<typename... Metrics>
+struct shared_order_inputs {
+    using type = typename detail::first_order_inputs<Metrics...>::type;
+
+    static_assert(((!has_order_inputs_v<Metrics> || std::is_same_v<typename order_inputs_of<Metrics>::type, type>) && ...),
+                  "Metrics of one engine must share their order_inputs_type");
+
+    static void bind(std::tuple<Metrics...>& metrics, type& inputs) {
+        std::apply([&inputs](auto&... metric) {
+            (bind_metric(metric, inputs), ...);
+        }, metrics);
+    }
+
+private:
+    template<typename Metric>
+    static void bind_metric(Metric& metric, type& inputs) {
+        if constexpr (has_order_inputs_v<Metric>) {
+            metric.bind_order_inputs(inputs);
+        } else {
+            (void)metric;
+            (void)inputs;
+        }
+    }
+};
+
 // ============================================================================
 // GenericRiskAggregationEngine - Template-based aggregation engine
 // ============================================================================
@@ -96,9 +331,24 @@ class GenericRiskAggregationEngine
     : public AccessorMixin<GenericRiskAggregationEngine<ContextType, Instrument, Metrics...>, Metrics>... {
 
 private:
+    using SharedTables = shared_metric_tables<Metrics...>;
+    using SharedOrderInputs = shared_order_inputs<Metrics...>;
+
     const ContextType& context_;
     OrderBook order_book_;
+    // Before metrics_: grouped metrics hold pointers into these tables
+    typename SharedTables::type shared_tables_;
+    typename SharedOrderInputs::type order_inputs_;
+    // Handle of the instrument each order was added with, by order slot,
+    // when binding is on (see set_instrument_binding())
+    static constexpr bool BINDS_INSTRUMENTS = instrument::is_instrument_handle_v<Instrument>;
+    struct NoBoundInstrument {};
+    aggregation::OrderSlotTable<std::conditional_t<BINDS_INSTRUMENTS, Instrument, NoBoundInstrument>> instruments_;
+    bool bind_instruments_ = false;
     std::tuple<Metrics...> metrics_;
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    aggregation::HandlerAllocationStats allocation_stats_;
+#endif
 
     template<typename Func>
     void for_each_metric(Func&& func) {
@@ -111,7 +361,32 @@ public:
     using instrument_type = Instrument;
     using context_type = ContextType;
 
-    explicit GenericRiskAggregationEngine(const ContextType& context) : context_(context) {}
+    // All engine-owned containers allocate from resource (see
+    // aggregation/memory_resource.hpp); it must outlive the engine
+    explicit GenericRiskAggregationEngine(const ContextType& context,
+                                          aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : context_(context),
+          order_book_(resource),
+          shared_tables_(SharedTables::make(resource)),
+          order_inputs_(resource),
+          instruments_(resource),
+          metrics_(aggregation::construct_with_resource<Metrics>(resource)...) {
+        SharedTables::bind(metrics_, shared_tables_);
+        SharedOrderInputs::bind(metrics_, order_inputs_);
+    }
+
+    // Metrics point into shared_tables_ and order_inputs_, so the engine
+    // stays where it was built
+    GenericRiskAggregationEngine(const GenericRiskAggregationEngine&) = delete;
+    GenericRiskAggregationEngine& operator=(const GenericRiskAggregationEngine&) = delete;
+
+    // Pre-sizes containers from capacity (see reserve())
+    GenericRiskAggregationEngine(const ContextType& context,
+                                 const aggregation::CapacityHints& capacity,
+                                 aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : GenericRiskAggregationEngine(context, resource) {
+        reserve(capacity);
+    }
 
     // ========================================================================
     // Context access
@@ -149,45 +424,81 @@ public:
     // ========================================================================
     // Outgoing message handlers (order sent)
     // ========================================================================
+    //
+    // Each handler has an overload taking the OrderHandle returned by
+    // on_new_order_single(). Passing the handle back skips the ClOrdID lookup;
+    // a stale handle (order already cleaned up) makes the message a no-op,
+    // just like an unknown ClOrdID.
+    //
+
+    OrderHandle on_new_order_single(const fix::NewOrderSingle& msg, const Instrument& instrument) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, NEW_ORDER_SINGLE);
+        OrderHandle handle = order_book_.add_order(msg);
+        auto* order = order_book_.get_order(handle);
+        if constexpr (BINDS_INSTRUMENTS) {
+            if (bind_instruments_) instruments_.assign(handle.index, instrument);
+        }
+        order_inputs_.begin_event();
+        for_each_metric([order, &instrument, this](auto& metric) {
+            metric.on_order_added(*order, instrument, context_);
+        });
+        order_inputs_.on_stage_entered(*order);
+        return handle;
+    }
 
-    void on_new_order_single(const fix::NewOrderSingle& msg, const Instrument& instrument) {
-        order_book_.add_order(msg);
-        auto* order = order_book_.get_order(msg.key);
-        if (order) {
-            for_each_metric([order, &instrument, this](auto& metric) {
-                metric.on_order_added(*order, instrument, context_);
-            });
+    // ========================================================================
+    // Prepared new orders
+    // ========================================================================
+    //
+    // A caller that inspects a new order before adding it (the combined
+    // check-and-add in RiskAggregationEngineWithLimits::try_submit) interns
+    // its identifiers and calls prepare_order() once, then hands both back to
+    // on_new_order_single() so nothing is interned, extracted or captured
+    // twice.
+    //
+    // Element i is the prepared order of the i-th metric; the last element
+    // holds the order's inputs, captured once for all metrics.
+    //
+
+    using PreparedOrder = std::tuple<prepared_order_t<Metrics>..., typename SharedOrderInputs::type::record_type>;
+
+    PreparedOrder prepare_order(const fix::NewOrderSingle& msg, const OrderIds& ids, const Instrument& instrument) const {
+        const auto inputs = order_inputs_.capture(context_, instrument);
+        return PreparedOrder{prepare_metric_order<Metrics>(msg, ids, instrument, inputs)..., inputs};
+    }
+
+    OrderHandle on_new_order_single(const fix::NewOrderSingle& msg, const Instrument& instrument,
+                                    const OrderIds& ids, const PreparedOrder& prepared) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, NEW_ORDER_SINGLE);
+        OrderHandle handle = order_book_.add_order(msg, ids);
+        auto* order = order_book_.get_order(handle);
+        if constexpr (BINDS_INSTRUMENTS) {
+            if (bind_instruments_) instruments_.assign(handle.index, instrument);
         }
+        order_inputs_.begin_event();
+        add_prepared_order(*order, instrument, prepared, std::index_sequence_for<Metrics...>{});
+        order_inputs_.on_stage_entered(*order, std::get<sizeof...(Metrics)>(prepared));
+        return handle;
     }
 
     void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, const Instrument& instrument) {
-        auto* order = order_book_.get_order(msg.orig_key);
-        if (!order) return;
-
-        OrderState old_state = order->state;
-        order_book_.start_replace(msg.orig_key, msg.key, msg.price, msg.quantity);
-        OrderState new_state = order->state;
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REPLACE);
+        apply_cancel_replace(msg, instrument, order_book_.get_order(msg.orig_key));
+    }
 
-        if (old_state != new_state) {
-            for_each_metric([order, &instrument, old_state, new_state, this](auto& metric) {
-                metric.on_state_change(*order, instrument, context_, old_state, new_state);
-            });
-        }
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, const Instrument& instrument, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REPLACE);
+        apply_cancel_replace(msg, instrument, order_book_.get_order(handle));
     }
 
     void on_order_cancel_request(const fix::OrderCancelRequest& msg, const Instrument& instrument) {
-        auto* order = order_book_.get_order(msg.orig_key);
-        if (!order) return;
-
-        OrderState old_state = order->state;
-        order_book_.start_cancel(msg.orig_key, msg.key);
-        OrderState new_state = order->state;
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REQUEST);
+        apply_cancel_request(msg, instrument, order_book_.get_order(msg.orig_key));
+    }
 
-        if (old_state != new_state) {
-            for_each_metric([order, &instrument, old_state, new_state, this](auto& metric) {
-                metric.on_state_change(*order, instrument, context_, old_state, new_state);
-            });
-        }
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg, const Instrument& instrument, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REQUEST);
+        apply_cancel_request(msg, instrument, order_book_.get_order(handle));
     }
 
     // ========================================================================
@@ -195,51 +506,138 @@ public:
     // ========================================================================
 
     void on_execution_report(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        switch (msg.report_type()) {
-            case fix::ExecutionReportType::INSERT_ACK:
-                handle_insert_ack(msg, instrument);
-                break;
-            case fix::ExecutionReportType::INSERT_NACK:
-                handle_insert_nack(msg, instrument);
-                break;
-            case fix::ExecutionReportType::UPDATE_ACK:
-                handle_update_ack(msg, instrument);
-                break;
-            case fix::ExecutionReportType::UPDATE_NACK:
-                handle_update_nack(msg);
-                break;
-            case fix::ExecutionReportType::CANCEL_ACK:
-            case fix::ExecutionReportType::UNSOLICITED_CANCEL:
-                handle_cancel(msg, instrument);
-                break;
-            case fix::ExecutionReportType::CANCEL_NACK:
-                handle_cancel_nack(msg, instrument);
-                break;
-            case fix::ExecutionReportType::PARTIAL_FILL:
-                handle_partial_fill(msg, instrument);
-                break;
-            case fix::ExecutionReportType::FULL_FILL:
-                handle_full_fill(msg, instrument);
-                break;
-        }
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, EXECUTION_REPORT);
+        auto type = msg.report_type();
+        dispatch_execution_report(msg, type, instrument, order_book_.find_report_order(msg, type));
+    }
+
+    void on_execution_report(const fix::ExecutionReport& msg, const Instrument& instrument, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, EXECUTION_REPORT);
+        dispatch_execution_report(msg, msg.report_type(), instrument, order_book_.get_order(handle));
     }
 
     void on_order_cancel_reject(const fix::OrderCancelReject& msg, const Instrument& instrument) {
-        auto* order = order_book_.get_order(msg.orig_key);
-        if (!order) return;
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REJECT);
+        apply_cancel_reject(msg, instrument, order_book_.get_order(msg.orig_key));
+    }
 
-        OrderState old_state = order->state;
-        if (msg.report_type() == fix::ExecutionReportType::CANCEL_NACK) {
-            order_book_.reject_cancel(msg.orig_key);
-        } else {
-            order_book_.reject_replace(msg.orig_key);
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg, const Instrument& instrument, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REJECT);
+        apply_cancel_reject(msg, instrument, order_book_.get_order(handle));
+    }
+
+    // ========================================================================
+    // Handlers using the bound instrument
+    // ========================================================================
+    //
+    // With binding on (set_instrument_binding(true)), on_new_order_single()
+    // keeps the instrument handle it was given for the order's lifetime, so
+    // messages for a live order can be handled without looking the
+    // instrument up again. Only handle types (instrument::is_instrument_handle,
+    // e.g. InstrumentRef) can be bound: a kept handle reads the same live
+    // values the instrument-passing overloads would be given, and does not
+    // depend on the caller's object staying alive. Using these overloads
+    // with a value Instrument type fails to compile. Binding is off by
+    // default.
+    //
+    // A message for an order with no bound instrument (binding off when it
+    // was added) is ignored, like a message for an unknown order.
+    //
+
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REPLACE);
+        if (auto* order = order_book_.get_order(msg.orig_key)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                apply_cancel_replace(msg, *instrument, order);
+            }
         }
-        OrderState new_state = order->state;
+    }
 
-        if (old_state != new_state) {
-            for_each_metric([order, &instrument, old_state, new_state, this](auto& metric) {
-                metric.on_state_change(*order, instrument, context_, old_state, new_state);
-            });
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REPLACE);
+        if (auto* order = order_book_.get_order(handle)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                apply_cancel_replace(msg, *instrument, order);
+            }
+        }
+    }
+
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REQUEST);
+        if (auto* order = order_book_.get_order(msg.orig_key)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                apply_cancel_request(msg, *instrument, order);
+            }
+        }
+    }
+
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REQUEST);
+        if (auto* order = order_book_.get_order(handle)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                apply_cancel_request(msg, *instrument, order);
+            }
+        }
+    }
+
+    void on_execution_report(const fix::ExecutionReport& msg) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, EXECUTION_REPORT);
+        auto type = msg.report_type();
+        if (auto* order = order_book_.find_report_order(msg, type)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                dispatch_execution_report(msg, type, *instrument, order);
+            }
+        }
+    }
+
+    void on_execution_report(const fix::ExecutionReport& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, EXECUTION_REPORT);
+        if (auto* order = order_book_.get_order(handle)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                dispatch_execution_report(msg, msg.report_type(), *instrument, order);
+            }
+        }
+    }
+
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REJECT);
+        if (auto* order = order_book_.get_order(msg.orig_key)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                apply_cancel_reject(msg, *instrument, order);
+            }
+        }
+    }
+
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REJECT);
+        if (auto* order = order_book_.get_order(handle)) {
+            if (const Instrument* instrument = bound_instrument(*order)) {
+                apply_cancel_reject(msg, *instrument, order);
+            }
+        }
+    }
+
+    static constexpr bool can_bind_instruments() { return BINDS_INSTRUMENTS; }
+
+    // Keep each new order's instrument handle from now on; turning it off
+    // drops every binding
+    void set_instrument_binding(bool enabled) {
+        static_assert(BINDS_INSTRUMENTS, "Only instrument handle types can be bound (see is_instrument_handle)");
+        bind_instruments_ = enabled;
+        if (!enabled) instruments_.clear();
+    }
+
+    bool instrument_binding() const { return bind_instruments_; }
+
+    // Handle of the instrument the order was added with (nullptr if it was
+    // added with binding off, or is not held by the order book); valid
+    // until the next new order
+    const Instrument* bound_instrument(const TrackedOrder& order) const {
+        static_assert(BINDS_INSTRUMENTS, "Only instrument handle types can be bound (see is_instrument_handle)");
+        if constexpr (BINDS_INSTRUMENTS) {
+            return instruments_.find(order.handle.index);
+        } else {
+            return nullptr;
         }
     }
 
@@ -248,15 +646,51 @@ public:
     // ========================================================================
 
     const OrderBook& order_book() const { return order_book_; }
-    size_t active_order_count() const { return order_book_.active_orders().size(); }
+    size_t active_order_count() const { return order_book_.active_order_count(); }
+
+    // Inputs stored per order for exposure metrics (see shared_order_inputs)
+    const typename SharedOrderInputs::type& order_inputs() const { return order_inputs_; }
+
+    // Keep this many terminal orders for late reports and reclaim older ones
+    // on later orders; by default all are kept until cleanup (see OrderBook)
+    void set_terminal_order_retention(size_t orders) { order_book_.set_terminal_retention(orders); }
+
+    // Reclaim every terminal order now, regardless of retention
+    void cleanup_terminal_orders() { order_book_.cleanup_terminal_orders(); }
 
     void clear() {
         order_book_.clear();
+        order_inputs_.clear();
+        instruments_.clear();
         for_each_metric([](auto& metric) {
             metric.clear();
         });
     }
 
+    // ========================================================================
+    // Capacity
+    // ========================================================================
+
+    // Pre-size the order book and every metric that supports it, so that
+    // steady-state order flow up to these sizes never grows a container
+    void reserve(const aggregation::CapacityHints& capacity) {
+        order_book_.reserve(capacity.orders);
+        order_inputs_.reserve(capacity);
+        instruments_.reserve(capacity.orders);
+        for_each_metric([&capacity](auto& metric) {
+            using MetricType = std::decay_t<decltype(metric)>;
+            if constexpr (has_reserve_v<MetricType>) {
+                metric.reserve(capacity);
+            }
+        });
+    }
+
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    // Heap allocations per handler (see aggregation/allocation_counter.hpp)
+    const aggregation::HandlerAllocationStats& allocation_stats() const { return allocation_stats_; }
+    void reset_allocation_stats() { allocation_stats_.reset(); }
+#endif
+
     // ========================================================================
     // Position management
     // ========================================================================
@@ -274,119 +708,198 @@ public:
     }
 
 private:
-    void handle_insert_ack(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        auto* order = order_book_.get_order(msg.key);
+    template<typename Metric, typename Inputs>
+    prepared_order_t<Metric> prepare_metric_order(const fix::NewOrderSingle& msg, const OrderIds& ids,
+                                                  const Instrument& instrument, const Inputs& inputs) const {
+        if constexpr (has_prepare_order_v<Metric> && has_order_inputs_v<Metric>) {
+            (void)instrument;
+            return Metric::prepare_order(msg, ids, inputs);
+        } else if constexpr (has_prepare_order_v<Metric>) {
+            (void)inputs;
+            return Metric::prepare_order(msg, ids, instrument, context_);
+        } else {
+            (void)ids;
+            (void)instrument;
+            (void)inputs;
+            return NoPreparedOrder{};
+        }
+    }
+
+    template<size_t... I>
+    void add_prepared_order(const TrackedOrder& order, const Instrument& instrument,
+                            const PreparedOrder& prepared, std::index_sequence<I...>) {
+        (add_prepared_order_to(std::get<I>(metrics_), order, instrument, std::get<I>(prepared)), ...);
+    }
+
+    template<typename Metric, typename Prepared>
+    void add_prepared_order_to(Metric& metric, const TrackedOrder& order,
+                               const Instrument& instrument, const Prepared& prepared) {
+        if constexpr (has_prepare_order_v<Metric>) {
+            (void)instrument;
+            metric.on_order_added(order, prepared);
+        } else {
+            (void)prepared;
+            metric.on_order_added(order, instrument, context_);
+        }
+    }
+
+    void notify_state_change(TrackedOrder* order, const Instrument& instrument, OrderState old_state, OrderState new_state) {
+        if (old_state == new_state) return;
+        order_inputs_.begin_event();
+        for_each_metric([order, &instrument, old_state, new_state, this](auto& metric) {
+            metric.on_state_change(*order, instrument, context_, old_state, new_state);
+        });
+        order_inputs_.on_stage_entered(*order);
+    }
+
+    void apply_cancel_replace(const fix::OrderCancelReplaceRequest& msg, const Instrument& instrument, TrackedOrder* order) {
         if (!order) return;
 
         OrderState old_state = order->state;
-        order_book_.acknowledge_order(msg.key);
+        order_book_.start_replace(*order, msg.key, msg.price, msg.quantity);
         OrderState new_state = order->state;
 
-        if (old_state != new_state) {
-            for_each_metric([order, &instrument, old_state, new_state, this](auto& metric) {
-                metric.on_state_change(*order, instrument, context_, old_state, new_state);
-            });
+        notify_state_change(order, instrument, old_state, new_state);
+    }
+
+    void apply_cancel_request(const fix::OrderCancelRequest& msg, const Instrument& instrument, TrackedOrder* order) {
+        if (!order) return;
+
+        OrderState old_state = order->state;
+        order_book_.start_cancel(*order, msg.key);
+        OrderState new_state = order->state;
+
+        notify_state_change(order, instrument, old_state, new_state);
+    }
+
+    void apply_cancel_reject(const fix::OrderCancelReject& msg, const Instrument& instrument, TrackedOrder* order) {
+        if (!order) return;
+
+        OrderState old_state = order->state;
+        if (msg.report_type() == fix::ExecutionReportType::CANCEL_NACK) {
+            order_book_.reject_cancel(*order);
+        } else {
+            order_book_.reject_replace(*order);
         }
+        OrderState new_state = order->state;
+
+        notify_state_change(order, instrument, old_state, new_state);
     }
 
-    void handle_insert_nack(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        auto* order = order_book_.get_order(msg.key);
+    void dispatch_execution_report(const fix::ExecutionReport& msg, fix::ExecutionReportType type, const Instrument& instrument,
+                                   TrackedOrder* order) {
         if (!order) return;
 
+        switch (type) {
+            case fix::ExecutionReportType::INSERT_ACK:
+                handle_insert_ack(order, instrument);
+                break;
+            case fix::ExecutionReportType::INSERT_NACK:
+                handle_insert_nack(order, instrument);
+                break;
+            case fix::ExecutionReportType::UPDATE_ACK:
+                handle_update_ack(order, instrument);
+                break;
+            case fix::ExecutionReportType::UPDATE_NACK:
+                order_book_.reject_replace(*order);
+                break;
+            case fix::ExecutionReportType::CANCEL_ACK:
+            case fix::ExecutionReportType::UNSOLICITED_CANCEL:
+                handle_cancel(order, instrument);
+                break;
+            case fix::ExecutionReportType::CANCEL_NACK:
+                handle_cancel_nack(order, instrument);
+                break;
+            case fix::ExecutionReportType::PARTIAL_FILL:
+                handle_partial_fill(msg, order, instrument);
+                break;
+            case fix::ExecutionReportType::FULL_FILL:
+                handle_full_fill(msg, order, instrument);
+                break;
+        }
+    }
+
+    void handle_insert_ack(TrackedOrder* order, const Instrument& instrument) {
+        OrderState old_state = order->state;
+        order_book_.acknowledge_order(*order);
+        OrderState new_state = order->state;
+
+        notify_state_change(order, instrument, old_state, new_state);
+    }
+
+    void handle_insert_nack(TrackedOrder* order, const Instrument& instrument) {
         for_each_metric([order, &instrument, this](auto& metric) {
             metric.on_order_removed(*order, instrument, context_);
         });
+        order_inputs_.on_order_removed(*order);
 
-        order_book_.reject_order(msg.key);
+        order_book_.reject_order(*order);
     }
 
-    void handle_update_ack(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        fix::OrderKey orig_key = msg.orig_key.value_or(msg.key);
-        auto* order = order_book_.get_order(orig_key);
-        if (!order) return;
-
+    void handle_update_ack(TrackedOrder* order, const Instrument& instrument) {
         // Capture old state and quantity BEFORE complete_replace updates them
         OrderState old_state = order->state;
         int64_t old_leaves_qty = order->leaves_qty;
 
-        auto result = order_book_.complete_replace(orig_key);
+        // The order keeps its slot across the replace, so it can be used
+        // directly afterwards even when the ClOrdID changed
+        auto result = order_book_.complete_replace(*order);
         if (result.has_value()) {
-            auto* updated_order = order_book_.resolve_order(msg.key);
-            if (updated_order) {
-                OrderState new_state = updated_order->state;
-
-                // For stage transitions, we need to move the OLD quantity from old stage to new stage
-                // Then update the quantity in the new stage
-                auto old_stage = aggregation::stage_from_order_state(old_state);
-                auto new_stage = aggregation::stage_from_order_state(new_state);
-
-                if (old_stage != new_stage && aggregation::is_active_order_state(new_state)) {
-                    // First: remove old_qty from old stage and add old_qty to new stage
-                    // Second: update from old_qty to new_qty in new stage
-                    // These can be combined: remove old_qty from old stage, add new_qty to new stage
-                    for_each_metric([updated_order, &instrument, old_leaves_qty, old_state, new_state, this](auto& metric) {
-                        metric.on_order_updated_with_state_change(*updated_order, instrument, context_, old_leaves_qty, old_state, new_state);
-                    });
-                } else {
-                    // Same stage, just quantity update
-                    for_each_metric([updated_order, &instrument, old_leaves_qty, this](auto& metric) {
-                        metric.on_order_updated(*updated_order, instrument, context_, old_leaves_qty);
-                    });
-                }
+            OrderState new_state = order->state;
+
+            // For stage transitions, we need to move the OLD quantity from old stage to new stage
+            // Then update the quantity in the new stage
+            auto old_stage = aggregation::stage_from_order_state(old_state);
+            auto new_stage = aggregation::stage_from_order_state(new_state);
+
+            order_inputs_.begin_event();
+            if (old_stage != new_stage && aggregation::is_active_order_state(new_state)) {
+                // First: remove old_qty from old stage and add old_qty to new stage
+                // Second: update from old_qty to new_qty in new stage
+                // These can be combined: remove old_qty from old stage, add new_qty to new stage
+                for_each_metric([order, &instrument, old_leaves_qty, old_state, new_state, this](auto& metric) {
+                    metric.on_order_updated_with_state_change(*order, instrument, context_, old_leaves_qty, old_state, new_state);
+                });
+            } else {
+                // Same stage, just quantity update
+                for_each_metric([order, &instrument, old_leaves_qty, this](auto& metric) {
+                    metric.on_order_updated(*order, instrument, context_, old_leaves_qty);
+                });
             }
+            order_inputs_.on_stage_entered(*order);
         }
     }
 
-    void handle_update_nack(const fix::ExecutionReport& msg) {
-        fix::OrderKey orig_key = msg.orig_key.value_or(msg.key);
-        order_book_.reject_replace(orig_key);
-    }
-
-    void handle_cancel(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        fix::OrderKey key = msg.orig_key.value_or(msg.key);
-        auto* order = order_book_.resolve_order(key);
-        if (!order) return;
-
+    void handle_cancel(TrackedOrder* order, const Instrument& instrument) {
         for_each_metric([order, &instrument, this](auto& metric) {
             metric.on_order_removed(*order, instrument, context_);
         });
+        order_inputs_.on_order_removed(*order);
 
-        order_book_.complete_cancel(key);
+        order_book_.complete_cancel(*order);
     }
 
-    void handle_cancel_nack(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        fix::OrderKey orig_key = msg.orig_key.value_or(msg.key);
-        auto* order = order_book_.get_order(orig_key);
-        if (!order) return;
-
+    void handle_cancel_nack(TrackedOrder* order, const Instrument& instrument) {
         OrderState old_state = order->state;
-        order_book_.reject_cancel(orig_key);
+        order_book_.reject_cancel(*order);
         OrderState new_state = order->state;
 
-        if (old_state != new_state) {
-            for_each_metric([order, &instrument, old_state, new_state, this](auto& metric) {
-                metric.on_state_change(*order, instrument, context_, old_state, new_state);
-            });
-        }
+        notify_state_change(order, instrument, old_state, new_state);
     }
 
-    void handle_partial_fill(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        auto* order = order_book_.resolve_order(msg.key);
-        if (!order) return;
-
-        auto result = order_book_.apply_fill(msg.key, msg.last_qty, msg.last_px);
+    void handle_partial_fill(const fix::ExecutionReport& msg, TrackedOrder* order, const Instrument& instrument) {
+        auto result = order_book_.apply_fill(*order, msg.last_qty, msg.last_px);
         if (result.has_value()) {
             int64_t filled_qty = result->filled_qty;
+            order_inputs_.begin_event();
             for_each_metric([order, &instrument, filled_qty, this](auto& metric) {
                 metric.on_partial_fill(*order, instrument, context_, filled_qty);
             });
+            order_inputs_.on_partial_fill(*order, filled_qty);
         }
     }
 
-    void handle_full_fill(const fix::ExecutionReport& msg, const Instrument& instrument) {
-        auto* order = order_book_.resolve_order(msg.key);
-        if (!order) return;
-
+    void handle_full_fill(const fix::ExecutionReport& msg, TrackedOrder* order, const Instrument& instrument) {
         // Get the filled quantity before removal (order->leaves_qty will be updated)
         int64_t filled_qty = msg.last_qty;
 
@@ -396,11 +909,13 @@ private:
         });
 
         // Credit position stage with filled quantity
+        order_inputs_.begin_event();
         for_each_metric([order, &instrument, filled_qty, this](auto& metric) {
             metric.on_full_fill(*order, instrument, context_, filled_qty);
         });
+        order_inputs_.on_order_removed(*order);
 
-        order_book_.apply_fill(msg.key, msg.last_qty, msg.last_px);
+        order_book_.apply_fill(*order, msg.last_qty, msg.last_px);
     }
 };
 
@@ -417,8 +932,14 @@ class GenericRiskAggregationEngine<ContextType, void, Metrics...>
     : public AccessorMixin<GenericRiskAggregationEngine<ContextType, void, Metrics...>, Metrics>... {
 
 private:
+    using SharedTables = shared_metric_tables<Metrics...>;
+
     OrderBook order_book_;
+    typename SharedTables::type shared_tables_;  // See the primary template
     std::tuple<Metrics...> metrics_;
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    aggregation::HandlerAllocationStats allocation_stats_;
+#endif
 
     template<typename Func>
     void for_each_metric(Func&& func) {
@@ -431,7 +952,21 @@ public:
     using instrument_type = void;
     using context_type = ContextType;
 
-    GenericRiskAggregationEngine() = default;
+    explicit GenericRiskAggregationEngine(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : order_book_(resource),
+          shared_tables_(SharedTables::make(resource)),
+          metrics_(aggregation::construct_with_resource<Metrics>(resource)...) {
+        SharedTables::bind(metrics_, shared_tables_);
+    }
+
+    GenericRiskAggregationEngine(const GenericRiskAggregationEngine&) = delete;
+    GenericRiskAggregationEngine& operator=(const GenericRiskAggregationEngine&) = delete;
+
+    explicit GenericRiskAggregationEngine(const aggregation::CapacityHints& capacity,
+                                          aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : GenericRiskAggregationEngine(resource) {
+        reserve(capacity);
+    }
 
     // ========================================================================
     // Metric access
@@ -463,45 +998,43 @@ public:
     // ========================================================================
     // Outgoing message handlers (order sent) - no instrument needed
     // ========================================================================
+    //
+    // OrderHandle overloads behave as in the primary template.
+    //
 
-    void on_new_order_single(const fix::NewOrderSingle& msg) {
-        order_book_.add_order(msg);
-        auto* order = order_book_.get_order(msg.key);
-        if (order) {
-            for_each_metric([order](auto& metric) {
-                metric.on_order_added(*order);
-            });
-        }
+    OrderHandle on_new_order_single(const fix::NewOrderSingle& msg) {
+        return on_new_order_single(msg, intern_order_ids(msg));
     }
 
-    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg) {
-        auto* order = order_book_.get_order(msg.orig_key);
-        if (!order) return;
+    // Add an order whose identifiers the caller has already interned
+    OrderHandle on_new_order_single(const fix::NewOrderSingle& msg, const OrderIds& ids) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, NEW_ORDER_SINGLE);
+        OrderHandle handle = order_book_.add_order(msg, ids);
+        auto* order = order_book_.get_order(handle);
+        for_each_metric([order](auto& metric) {
+            metric.on_order_added(*order);
+        });
+        return handle;
+    }
 
-        OrderState old_state = order->state;
-        order_book_.start_replace(msg.orig_key, msg.key, msg.price, msg.quantity);
-        OrderState new_state = order->state;
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REPLACE);
+        apply_cancel_replace(msg, order_book_.get_order(msg.orig_key));
+    }
 
-        if (old_state != new_state) {
-            for_each_metric([order, old_state, new_state](auto& metric) {
-                metric.on_state_change(*order, old_state, new_state);
-            });
-        }
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REPLACE);
+        apply_cancel_replace(msg, order_book_.get_order(handle));
     }
 
     void on_order_cancel_request(const fix::OrderCancelRequest& msg) {
-        auto* order = order_book_.get_order(msg.orig_key);
-        if (!order) return;
-
-        OrderState old_state = order->state;
-        order_book_.start_cancel(msg.orig_key, msg.key);
-        OrderState new_state = order->state;
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REQUEST);
+        apply_cancel_request(msg, order_book_.get_order(msg.orig_key));
+    }
 
-        if (old_state != new_state) {
-            for_each_metric([order, old_state, new_state](auto& metric) {
-                metric.on_state_change(*order, old_state, new_state);
-            });
-        }
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REQUEST);
+        apply_cancel_request(msg, order_book_.get_order(handle));
     }
 
     // ========================================================================
@@ -509,52 +1042,24 @@ public:
     // ========================================================================
 
     void on_execution_report(const fix::ExecutionReport& msg) {
-        switch (msg.report_type()) {
-            case fix::ExecutionReportType::INSERT_ACK:
-                handle_insert_ack(msg);
-                break;
-            case fix::ExecutionReportType::INSERT_NACK:
-                handle_insert_nack(msg);
-                break;
-            case fix::ExecutionReportType::UPDATE_ACK:
-                handle_update_ack(msg);
-                break;
-            case fix::ExecutionReportType::UPDATE_NACK:
-                handle_update_nack(msg);
-                break;
-            case fix::ExecutionReportType::CANCEL_ACK:
-            case fix::ExecutionReportType::UNSOLICITED_CANCEL:
-                handle_cancel(msg);
-                break;
-            case fix::ExecutionReportType::CANCEL_NACK:
-                handle_cancel_nack(msg);
-                break;
-            case fix::ExecutionReportType::PARTIAL_FILL:
-                handle_partial_fill(msg);
-                break;
-            case fix::ExecutionReportType::FULL_FILL:
-                handle_full_fill(msg);
-                break;
-        }
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, EXECUTION_REPORT);
+        auto type = msg.report_type();
+        dispatch_execution_report(msg, type, order_book_.find_report_order(msg, type));
     }
 
-    void on_order_cancel_reject(const fix::OrderCancelReject& msg) {
-        auto* order = order_book_.get_order(msg.orig_key);
-        if (!order) return;
+    void on_execution_report(const fix::ExecutionReport& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, EXECUTION_REPORT);
+        dispatch_execution_report(msg, msg.report_type(), order_book_.get_order(handle));
+    }
 
-        OrderState old_state = order->state;
-        if (msg.report_type() == fix::ExecutionReportType::CANCEL_NACK) {
-            order_book_.reject_cancel(msg.orig_key);
-        } else {
-            order_book_.reject_replace(msg.orig_key);
-        }
-        OrderState new_state = order->state;
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REJECT);
+        apply_cancel_reject(msg, order_book_.get_order(msg.orig_key));
+    }
 
-        if (old_state != new_state) {
-            for_each_metric([order, old_state, new_state](auto& metric) {
-                metric.on_state_change(*order, old_state, new_state);
-            });
-        }
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg, OrderHandle handle) {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(allocation_stats_, ORDER_CANCEL_REJECT);
+        apply_cancel_reject(msg, order_book_.get_order(handle));
     }
 
     // ========================================================================
@@ -562,7 +1067,14 @@ public:
     // ========================================================================
 
     const OrderBook& order_book() const { return order_book_; }
-    size_t active_order_count() const { return order_book_.active_orders().size(); }
+    size_t active_order_count() const { return order_book_.active_order_count(); }
+
+    // Keep this many terminal orders for late reports and reclaim older ones
+    // on later orders; by default all are kept until cleanup (see OrderBook)
+    void set_terminal_order_retention(size_t orders) { order_book_.set_terminal_retention(orders); }
+
+    // Reclaim every terminal order now, regardless of retention
+    void cleanup_terminal_orders() { order_book_.cleanup_terminal_orders(); }
 
     void clear() {
         order_book_.clear();
@@ -571,6 +1083,28 @@ public:
         });
     }
 
+    // ========================================================================
+    // Capacity
+    // ========================================================================
+
+    // Pre-size the order book and every metric that supports it, so that
+    // steady-state order flow up to these sizes never grows a container
+    void reserve(const aggregation::CapacityHints& capacity) {
+        order_book_.reserve(capacity.orders);
+        for_each_metric([&capacity](auto& metric) {
+            using MetricType = std::decay_t<decltype(metric)>;
+            if constexpr (has_reserve_v<MetricType>) {
+                metric.reserve(capacity);
+            }
+        });
+    }
+
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    // Heap allocations per handler (see aggregation/allocation_counter.hpp)
+    const aggregation::HandlerAllocationStats& allocation_stats() const { return allocation_stats_; }
+    void reset_allocation_stats() { allocation_stats_.reset(); }
+#endif
+
     // ========================================================================
     // Position management
     // ========================================================================
@@ -588,12 +1122,11 @@ public:
     }
 
 private:
-    void handle_insert_ack(const fix::ExecutionReport& msg) {
-        auto* order = order_book_.get_order(msg.key);
+    void apply_cancel_replace(const fix::OrderCancelReplaceRequest& msg, TrackedOrder* order) {
         if (!order) return;
 
         OrderState old_state = order->state;
-        order_book_.acknowledge_order(msg.key);
+        order_book_.start_replace(*order, msg.key, msg.price, msg.quantity);
         OrderState new_state = order->state;
 
         if (old_state != new_state) {
@@ -603,78 +1136,134 @@ private:
         }
     }
 
-    void handle_insert_nack(const fix::ExecutionReport& msg) {
-        auto* order = order_book_.get_order(msg.key);
+    void apply_cancel_request(const fix::OrderCancelRequest& msg, TrackedOrder* order) {
         if (!order) return;
 
+        OrderState old_state = order->state;
+        order_book_.start_cancel(*order, msg.key);
+        OrderState new_state = order->state;
+
+        if (old_state != new_state) {
+            for_each_metric([order, old_state, new_state](auto& metric) {
+                metric.on_state_change(*order, old_state, new_state);
+            });
+        }
+    }
+
+    void apply_cancel_reject(const fix::OrderCancelReject& msg, TrackedOrder* order) {
+        if (!order) return;
+
+        OrderState old_state = order->state;
+        if (msg.report_type() == fix::ExecutionReportType::CANCEL_NACK) {
+            order_book_.reject_cancel(*order);
+        } else {
+            order_book_.reject_replace(*order);
+        }
+        OrderState new_state = order->state;
+
+        if (old_state != new_state) {
+            for_each_metric([order, old_state, new_state](auto& metric) {
+                metric.on_state_change(*order, old_state, new_state);
+            });
+        }
+    }
+
+    void dispatch_execution_report(const fix::ExecutionReport& msg, fix::ExecutionReportType type,
+                                   TrackedOrder* order) {
+        if (!order) return;
+
+        switch (type) {
+            case fix::ExecutionReportType::INSERT_ACK:
+                handle_insert_ack(order);
+                break;
+            case fix::ExecutionReportType::INSERT_NACK:
+                handle_insert_nack(order);
+                break;
+            case fix::ExecutionReportType::UPDATE_ACK:
+                handle_update_ack(order);
+                break;
+            case fix::ExecutionReportType::UPDATE_NACK:
+                order_book_.reject_replace(*order);
+                break;
+            case fix::ExecutionReportType::CANCEL_ACK:
+            case fix::ExecutionReportType::UNSOLICITED_CANCEL:
+                handle_cancel(order);
+                break;
+            case fix::ExecutionReportType::CANCEL_NACK:
+                handle_cancel_nack(order);
+                break;
+            case fix::ExecutionReportType::PARTIAL_FILL:
+                handle_partial_fill(msg, order);
+                break;
+            case fix::ExecutionReportType::FULL_FILL:
+                handle_full_fill(msg, order);
+                break;
+        }
+    }
+
+    void handle_insert_ack(TrackedOrder* order) {
+        OrderState old_state = order->state;
+        order_book_.acknowledge_order(*order);
+        OrderState new_state = order->state;
+
+        if (old_state != new_state) {
+            for_each_metric([order, old_state, new_state](auto& metric) {
+                metric.on_state_change(*order, old_state, new_state);
+            });
+        }
+    }
+
+    void handle_insert_nack(TrackedOrder* order) {
         for_each_metric([order](auto& metric) {
             metric.on_order_removed(*order);
         });
 
-        order_book_.reject_order(msg.key);
+        order_book_.reject_order(*order);
     }
 
-    void handle_update_ack(const fix::ExecutionReport& msg) {
-        fix::OrderKey orig_key = msg.orig_key.value_or(msg.key);
-        auto* order = order_book_.get_order(orig_key);
-        if (!order) return;
-
+    void handle_update_ack(TrackedOrder* order) {
         // Capture old state and quantity BEFORE complete_replace updates them
         OrderState old_state = order->state;
         int64_t old_leaves_qty = order->leaves_qty;
 
-        auto result = order_book_.complete_replace(orig_key);
+        // The order keeps its slot across the replace, so it can be used
+        // directly afterwards even when the ClOrdID changed
+        auto result = order_book_.complete_replace(*order);
         if (result.has_value()) {
-            auto* updated_order = order_book_.resolve_order(msg.key);
-            if (updated_order) {
-                OrderState new_state = updated_order->state;
-
-                // For stage transitions, we need to move the OLD quantity from old stage to new stage
-                // Then update the quantity in the new stage
-                auto old_stage = aggregation::stage_from_order_state(old_state);
-                auto new_stage = aggregation::stage_from_order_state(new_state);
-
-                if (old_stage != new_stage && aggregation::is_active_order_state(new_state)) {
-                    // First: remove old_qty from old stage and add old_qty to new stage
-                    // Second: update from old_qty to new_qty in new stage
-                    // These can be combined: remove old_qty from old stage, add new_qty to new stage
-                    for_each_metric([updated_order, old_leaves_qty, old_state, new_state](auto& metric) {
-                        metric.on_order_updated_with_state_change(*updated_order, old_leaves_qty, old_state, new_state);
-                    });
-                } else {
-                    // Same stage, just quantity update
-                    for_each_metric([updated_order, old_leaves_qty](auto& metric) {
-                        metric.on_order_updated(*updated_order, old_leaves_qty);
-                    });
-                }
+            OrderState new_state = order->state;
+
+            // For stage transitions, we need to move the OLD quantity from old stage to new stage
+            // Then update the quantity in the new stage
+            auto old_stage = aggregation::stage_from_order_state(old_state);
+            auto new_stage = aggregation::stage_from_order_state(new_state);
+
+            if (old_stage != new_stage && aggregation::is_active_order_state(new_state)) {
+                // First: remove old_qty from old stage and add old_qty to new stage
+                // Second: update from old_qty to new_qty in new stage
+                // These can be combined: remove old_qty from old stage, add new_qty to new stage
+                for_each_metric([order, old_leaves_qty, old_state, new_state](auto& metric) {
+                    metric.on_order_updated_with_state_change(*order, old_leaves_qty, old_state, new_state);
+                });
+            } else {
+                // Same stage, just quantity update
+                for_each_metric([order, old_leaves_qty](auto& metric) {
+                    metric.on_order_updated(*order, old_leaves_qty);
+                });
             }
         }
     }
 
-    void handle_update_nack(const fix::ExecutionReport& msg) {
-        fix::OrderKey orig_key = msg.orig_key.value_or(msg.key);
-        order_book_.reject_replace(orig_key);
-    }
-
-    void handle_cancel(const fix::ExecutionReport& msg) {
-        fix::OrderKey key = msg.orig_key.value_or(msg.key);
-        auto* order = order_book_.resolve_order(key);
-        if (!order) return;
-
+    void handle_cancel(TrackedOrder* order) {
         for_each_metric([order](auto& metric) {
             metric.on_order_removed(*order);
         });
 
-        order_book_.complete_cancel(key);
+        order_book_.complete_cancel(*order);
     }
 
-    void handle_cancel_nack(const fix::ExecutionReport& msg) {
-        fix::OrderKey orig_key = msg.orig_key.value_or(msg.key);
-        auto* order = order_book_.get_order(orig_key);
-        if (!order) return;
-
+    void handle_cancel_nack(TrackedOrder* order) {
         OrderState old_state = order->state;
-        order_book_.reject_cancel(orig_key);
+        order_book_.reject_cancel(*order);
         OrderState new_state = order->state;
 
         if (old_state != new_state) {
@@ -684,11 +1273,8 @@ private:
         }
     }
 
-    void handle_partial_fill(const fix::ExecutionReport& msg) {
-        auto* order = order_book_.resolve_order(msg.key);
-        if (!order) return;
-
-        auto result = order_book_.apply_fill(msg.key, msg.last_qty, msg.last_px);
+    void handle_partial_fill(const fix::ExecutionReport& msg, TrackedOrder* order) {
+        auto result = order_book_.apply_fill(*order, msg.last_qty, msg.last_px);
         if (result.has_value()) {
             int64_t filled_qty = result->filled_qty;
             for_each_metric([order, filled_qty](auto& metric) {
@@ -697,10 +1283,7 @@ private:
         }
     }
 
-    void handle_full_fill(const fix::ExecutionReport& msg) {
-        auto* order = order_book_.resolve_order(msg.key);
-        if (!order) return;
-
+    void handle_full_fill(const fix::ExecutionReport& msg, TrackedOrder* order) {
         // Get the filled quantity before removal (order->leaves_qty will be updated)
         int64_t filled_qty = msg.last_qty;
 
@@ -714,7 +1297,7 @@ private:
             metric.on_full_fill(*order, filled_qty);
         });
 
-        order_book_.apply_fill(msg.key, msg.last_qty, msg.last_px);
+        order_book_.apply_fill(*order, msg.last_qty, msg.last_px);
     }
 };
 
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "../aggregation/container_types.hpp"
+#include <atomic>
+#include <cstdint>
 #include <optional>
 #include <string>
 #include <cmath>
@@ -17,6 +19,13 @@ enum class LimitComparisonMode {
     ABSOLUTE    // Compare absolute value (|value| > limit triggers breach)
 };
 
+// Unique across stores, so a limit cached against one store's version never
+// validates against another store
+inline uint64_t next_limit_store_version() {
+    static std::atomic<uint64_t> next{1};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
 // ============================================================================
 // LimitStore - Generic limit storage for any key type
 // ============================================================================
@@ -24,6 +33,9 @@ enum class LimitComparisonMode {
 // Stores limits keyed by a given Key type (e.g., std::string for underlyer).
 // Supports a default limit and per-key overrides.
 //
+// Every change takes a new version(); metrics that cache effective limits
+// per key (aggregation::LimitCheckTable) reload them when it moves.
+//
 
 template<typename Key>
 class LimitStore {
@@ -31,11 +43,20 @@ private:
     aggregation::HashMap<Key, double> limits_;
     double default_limit_ = std::numeric_limits<double>::max();
     LimitComparisonMode mode_ = LimitComparisonMode::ABSOLUTE;
+    uint64_t version_ = next_limit_store_version();
+
+    void changed() {
+        version_ = next_limit_store_version();
+    }
 
 public:
+    explicit LimitStore(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : limits_(resource) {}
+
     // Set the default limit (used when no specific limit is set)
     void set_default_limit(double limit) {
         default_limit_ = limit;
+        changed();
     }
 
     double default_limit() const {
@@ -45,11 +66,13 @@ public:
     // Set limit for a specific key
     void set_limit(const Key& key, double limit) {
         limits_[key] = limit;
+        changed();
     }
 
     // Remove limit for a specific key (falls back to default)
     void remove_limit(const Key& key) {
         limits_.erase(key);
+        changed();
     }
 
     // Get limit for a key (returns default if not set)
@@ -66,6 +89,7 @@ public:
     // Set comparison mode
     void set_comparison_mode(LimitComparisonMode mode) {
         mode_ = mode;
+        changed();
     }
 
     LimitComparisonMode comparison_mode() const {
@@ -74,13 +98,15 @@ public:
 
     // Check if a value would breach the limit for a given key
     bool would_breach(const Key& key, double current_value, double delta = 0.0) const {
-        double limit = get_limit(key);
-        double new_value = current_value + delta;
+        return exceeds(current_value + delta, get_limit(key));
+    }
 
+    // Check a value against a limit the caller already looked up
+    bool exceeds(double value, double limit) const {
         if (mode_ == LimitComparisonMode::ABSOLUTE) {
-            return std::abs(new_value) > limit;
+            return std::abs(value) > limit;
         }
-        return new_value > limit;
+        return value > limit;
     }
 
     // Check if a value is at or above the limit (for count-based limits where >= triggers breach)
@@ -92,9 +118,15 @@ public:
         return current_value >= limit;
     }
 
+    // Changes whenever a limit, the default or the comparison mode changes
+    uint64_t version() const {
+        return version_;
+    }
+
     // Clear all limits (keeps default)
     void clear() {
         limits_.clear();
+        changed();
     }
 
     // Clear everything including default
@@ -102,6 +134,7 @@ public:
         limits_.clear();
         default_limit_ = std::numeric_limits<double>::max();
         mode_ = LimitComparisonMode::ABSOLUTE;
+        changed();
     }
 };
 
@@ -55,15 +55,41 @@ std::string key_to_string(const Key& key) {
     } else if constexpr (std::is_same_v<Key, aggregation::GlobalKey>) {
         return "global";
     } else if constexpr (std::is_same_v<Key, aggregation::UnderlyerKey>) {
-        return key.underlyer;
+        return key.underlyer_name();
     } else if constexpr (std::is_same_v<Key, aggregation::InstrumentKey>) {
-        return key.symbol;
+        return key.symbol_name();
     } else if constexpr (std::is_same_v<Key, aggregation::StrategyKey>) {
-        return key.strategy_id;
+        return key.strategy_name();
     } else if constexpr (std::is_same_v<Key, aggregation::PortfolioKey>) {
-        return key.portfolio_id;
+        return key.portfolio_name();
     } else if constexpr (std::is_same_v<Key, aggregation::InstrumentSideKey>) {
-        return key.symbol + ":" + std::to_string(key.side);
+        return key.symbol_name() + ":" + std::to_string(key.side);
+    } else if constexpr (std::is_same_v<Key, aggregation::PortfolioInstrumentKey>) {
+        return key.portfolio_name() + ":" + key.symbol_name();
+    } else {
+        return "unknown";
+    }
+}
+
+// Key string for a key extracted from a NewOrderSingle
+// Formats from the order's own identifiers, so it is correct even when the
+// pre-trade lookup found no interned ID (first order for a symbol etc.)
+template<typename Key>
+std::string order_key_to_string(const fix::NewOrderSingle& order) {
+    if constexpr (std::is_same_v<Key, aggregation::GlobalKey>) {
+        return "global";
+    } else if constexpr (std::is_same_v<Key, aggregation::UnderlyerKey>) {
+        return order.underlyer;
+    } else if constexpr (std::is_same_v<Key, aggregation::InstrumentKey>) {
+        return order.symbol;
+    } else if constexpr (std::is_same_v<Key, aggregation::StrategyKey>) {
+        return order.strategy_id;
+    } else if constexpr (std::is_same_v<Key, aggregation::PortfolioKey>) {
+        return order.portfolio_id;
+    } else if constexpr (std::is_same_v<Key, aggregation::InstrumentSideKey>) {
+        return order.symbol + ":" + std::to_string(static_cast<int>(order.side));
+    } else if constexpr (std::is_same_v<Key, aggregation::PortfolioInstrumentKey>) {
+        return order.portfolio_id + ":" + order.symbol;
     } else {
         return "unknown";
     }
@@ -95,7 +121,8 @@ private:
     std::tuple<LimitStore<typename Metrics::key_type>...> stores_;
 
 public:
-    MetricLimitStores() = default;
+    explicit MetricLimitStores(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : stores_(LimitStore<typename Metrics::key_type>(resource)...) {}
 
     // Get the limit store for a specific metric type
     template<typename Metric>
@@ -152,6 +179,21 @@ struct has_extract_key<Metric, std::void_t<decltype(
 template<typename Metric>
 inline constexpr bool has_extract_key_v = has_extract_key<Metric>::value;
 
+// Trait to detect if a metric reads its value and the key's limit in one
+// probe (limit_usage(key, store), see aggregation::LimitCheckTable)
+template<typename Metric, typename = void>
+struct has_limit_usage : std::false_type {};
+
+template<typename Metric>
+struct has_limit_usage<Metric, std::void_t<decltype(
+    std::declval<const Metric&>().limit_usage(
+        std::declval<const typename Metric::key_type&>(),
+        std::declval<const LimitStore<typename Metric::key_type>&>())
+)>> : std::true_type {};
+
+template<typename Metric>
+inline constexpr bool has_limit_usage_v = has_limit_usage<Metric>::value;
+
 // Trait to get the limit type enum for a metric
 template<typename Metric>
 struct metric_limit_type {
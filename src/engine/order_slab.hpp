@@ -0,0 +1,309 @@
+#pragma once
+
+#include "../aggregation/memory_resource.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace engine {
+
+// ============================================================================
+// OrderHandle - Generational handle to a slab slot
+// ============================================================================
+//
+// A handle names a slot index plus the generation the slot had when the
+// object was created. Releasing a slot bumps its generation, so handles to
+// released (or released and reused) slots fail lookup instead of aliasing a
+// different order.
+//
+
+struct OrderHandle {
+    static constexpr uint32_t INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool is_valid() const { return index != INVALID_INDEX; }
+
+    bool operator==(const OrderHandle& other) const {
+        return index == other.index && generation == other.generation;
+    }
+
+    bool operator!=(const OrderHandle& other) const {
+        return !(*this == other);
+    }
+};
+
+// ============================================================================
+// HandleQueue - FIFO ring of OrderHandles
+// ============================================================================
+//
+// Backed by a power-of-two ring that only grows when full, so a queue whose
+// length stays bounded stops allocating once it has reached that length.
+//
+
+class HandleQueue {
+private:
+    std::pmr::vector<OrderHandle> ring_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+
+    void grow(size_t min_capacity) {
+        size_t capacity = ring_.empty() ? 16 : ring_.size();
+        while (capacity < min_capacity) {
+            capacity *= 2;
+        }
+        std::pmr::vector<OrderHandle> ring(capacity, ring_.get_allocator());
+        for (size_t i = 0; i < size_; ++i) {
+            ring[i] = ring_[(head_ + i) & (ring_.size() - 1)];
+        }
+        ring_.swap(ring);
+        head_ = 0;
+    }
+
+public:
+    explicit HandleQueue(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : ring_(resource) {}
+
+    void push(OrderHandle handle) {
+        if (size_ == ring_.size()) {
+            grow(size_ + 1);
+        }
+        ring_[(head_ + size_) & (ring_.size() - 1)] = handle;
+        ++size_;
+    }
+
+    OrderHandle front() const { return ring_[head_]; }
+
+    void pop() {
+        head_ = (head_ + 1) & (ring_.size() - 1);
+        --size_;
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void reserve(size_t n) {
+        if (n > ring_.size()) {
+            grow(n);
+        }
+    }
+
+    void clear() {
+        head_ = 0;
+        size_ = 0;
+    }
+};
+
+// ============================================================================
+// OrderSlab - Chunked slab with stable addresses and slot reuse
+// ============================================================================
+//
+// Objects live in fixed-size chunks that are never moved or freed until the
+// slab is destroyed, so pointers stay valid for an object's whole lifetime
+// (unlike values stored in an open-addressing hash map, which move on
+// rehash). Released slots go on a free list and are reused LIFO, keeping the
+// live set compact and warm in cache.
+//
+// Slot indices are dense in [0, slot_count()), which lets callers keep
+// per-object side tables as plain vectors indexed by OrderHandle::index.
+//
+// Chunks, and the bookkeeping vectors, come from the MemoryResource given at
+// construction.
+//
+
+template<typename T, size_t ChunkSize = 1024>
+class OrderSlab {
+private:
+    static_assert(ChunkSize > 0, "ChunkSize must be positive");
+
+    struct Slot {
+        std::optional<T> value;
+        uint32_t generation = 0;
+    };
+
+    aggregation::MemoryResource* resource_;
+    std::pmr::vector<Slot*> chunks_;
+    std::pmr::vector<uint32_t> free_list_;
+    uint32_t slot_count_ = 0;  // Slots handed out at least once
+    size_t size_ = 0;          // Live objects
+
+    Slot& slot(uint32_t index) {
+        return chunks_[index / ChunkSize][index % ChunkSize];
+    }
+
+    const Slot& slot(uint32_t index) const {
+        return chunks_[index / ChunkSize][index % ChunkSize];
+    }
+
+    uint32_t acquire_index() {
+        if (!free_list_.empty()) {
+            uint32_t index = free_list_.back();
+            free_list_.pop_back();
+            return index;
+        }
+        if (slot_count_ == chunks_.size() * ChunkSize) {
+            allocate_chunk();
+        }
+        return slot_count_++;
+    }
+
+    void allocate_chunk() {
+        void* memory = resource_->allocate(sizeof(Slot) * ChunkSize, alignof(Slot));
+        Slot* chunk = static_cast<Slot*>(memory);
+        for (size_t i = 0; i < ChunkSize; ++i) {
+            new (chunk + i) Slot();
+        }
+        chunks_.push_back(chunk);
+    }
+
+    void release_chunks() {
+        for (Slot* chunk : chunks_) {
+            for (size_t i = 0; i < ChunkSize; ++i) {
+                chunk[i].~Slot();
+            }
+            resource_->deallocate(chunk, sizeof(Slot) * ChunkSize, alignof(Slot));
+        }
+        chunks_.clear();
+    }
+
+public:
+    explicit OrderSlab(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : resource_(resource), chunks_(resource), free_list_(resource) {}
+
+    OrderSlab(const OrderSlab&) = delete;
+    OrderSlab& operator=(const OrderSlab&) = delete;
+
+    OrderSlab(OrderSlab&& other) noexcept
+        : resource_(other.resource_),
+          chunks_(std::move(other.chunks_)),
+          free_list_(std::move(other.free_list_)),
+          slot_count_(std::exchange(other.slot_count_, 0)),
+          size_(std::exchange(other.size_, 0)) {
+        other.chunks_.clear();
+        other.free_list_.clear();
+    }
+
+    // Steals the other slab's chunks. The bookkeeping vectors keep this
+    // slab's resource, so they are copied (and may throw) only when the two
+    // resources differ; *this is untouched if that copy fails.
+    OrderSlab& operator=(OrderSlab&& other) {
+        if (this != &other) {
+            if (chunks_.get_allocator() == other.chunks_.get_allocator()) {
+                release_chunks();
+                chunks_ = std::move(other.chunks_);
+                free_list_ = std::move(other.free_list_);
+            } else {
+                std::pmr::vector<Slot*> chunks(other.chunks_, chunks_.get_allocator());
+                std::pmr::vector<uint32_t> free_list(other.free_list_, free_list_.get_allocator());
+                release_chunks();
+                chunks_.swap(chunks);
+                free_list_.swap(free_list);
+            }
+            // Chunks stay with the resource that allocated them
+            resource_ = other.resource_;
+            slot_count_ = std::exchange(other.slot_count_, 0);
+            size_ = std::exchange(other.size_, 0);
+            other.chunks_.clear();
+            other.free_list_.clear();
+        }
+        return *this;
+    }
+
+    ~OrderSlab() {
+        release_chunks();
+    }
+
+    // Construct an object in a free slot and return its handle
+    template<typename... Args>
+    OrderHandle emplace(Args&&... args) {
+        uint32_t index = acquire_index();
+        Slot& s = slot(index);
+        s.value.emplace(std::forward<Args>(args)...);
+        ++size_;
+        return OrderHandle{index, s.generation};
+    }
+
+    // Object for a handle, or nullptr if the handle is invalid or stale
+    T* get(OrderHandle handle) {
+        if (handle.index >= slot_count_) return nullptr;
+        Slot& s = slot(handle.index);
+        return (s.value.has_value() && s.generation == handle.generation) ? &*s.value : nullptr;
+    }
+
+    const T* get(OrderHandle handle) const {
+        if (handle.index >= slot_count_) return nullptr;
+        const Slot& s = slot(handle.index);
+        return (s.value.has_value() && s.generation == handle.generation) ? &*s.value : nullptr;
+    }
+
+    // Destroy the object and recycle its slot; returns false for stale handles
+    bool erase(OrderHandle handle) {
+        if (get(handle) == nullptr) return false;
+        Slot& s = slot(handle.index);
+        s.value.reset();
+        ++s.generation;
+        free_list_.push_back(handle.index);
+        --size_;
+        return true;
+    }
+
+    // Visit every live object as func(handle, object)
+    template<typename Func>
+    void for_each(Func&& func) {
+        for (uint32_t index = 0; index < slot_count_; ++index) {
+            Slot& s = slot(index);
+            if (s.value.has_value()) {
+                func(OrderHandle{index, s.generation}, *s.value);
+            }
+        }
+    }
+
+    template<typename Func>
+    void for_each(Func&& func) const {
+        for (uint32_t index = 0; index < slot_count_; ++index) {
+            const Slot& s = slot(index);
+            if (s.value.has_value()) {
+                func(OrderHandle{index, s.generation}, *s.value);
+            }
+        }
+    }
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    // Upper bound on slot indices handed out so far
+    size_t slot_count() const { return slot_count_; }
+
+    // Allocate chunks (and free list space) for n objects up front
+    void reserve(size_t n) {
+        size_t chunk_count = (n + ChunkSize - 1) / ChunkSize;
+        chunks_.reserve(chunk_count);
+        while (chunks_.size() < chunk_count) {
+            allocate_chunk();
+        }
+        free_list_.reserve(chunk_count * ChunkSize);
+    }
+
+    // Destroy all objects; chunks are kept for reuse and outstanding handles
+    // become stale
+    void clear() {
+        free_list_.clear();
+        for (uint32_t index = slot_count_; index-- > 0; ) {
+            Slot& s = slot(index);
+            if (s.value.has_value()) {
+                s.value.reset();
+                ++s.generation;
+            }
+            free_list_.push_back(index);
+        }
+        size_ = 0;
+    }
+};
+
+} // namespace engine
@@ -2,7 +2,12 @@
 
 #include "../fix/fix_messages.hpp"
 #include "../aggregation/container_types.hpp"
+#include "../aggregation/interning.hpp"
+#include "order_slab.hpp"
+#include <array>
+#include <limits>
 #include <optional>
+#include <vector>
 
 namespace engine {
 
@@ -17,6 +22,8 @@ enum class OrderState {
     REJECTED           // Rejected
 };
 
+inline constexpr size_t ORDER_STATE_COUNT = 7;
+
 inline const char* to_string(OrderState state) {
     switch (state) {
         case OrderState::PENDING_NEW: return "PENDING_NEW";
@@ -30,13 +37,52 @@ inline const char* to_string(OrderState state) {
     }
 }
 
+// Interned identifiers of a tracked order (see aggregation/interning.hpp)
+struct OrderIds {
+    aggregation::InternedId symbol = aggregation::INVALID_INTERNED_ID;
+    aggregation::InternedId underlyer = aggregation::INVALID_INTERNED_ID;
+    aggregation::InternedId strategy = aggregation::INVALID_INTERNED_ID;
+    aggregation::InternedId portfolio = aggregation::INVALID_INTERNED_ID;
+
+    // True if every identifier resolved (none is INVALID_INTERNED_ID)
+    bool all_resolved() const {
+        return symbol != aggregation::INVALID_INTERNED_ID &&
+               underlyer != aggregation::INVALID_INTERNED_ID &&
+               strategy != aggregation::INVALID_INTERNED_ID &&
+               portfolio != aggregation::INVALID_INTERNED_ID;
+    }
+};
+
+// Intern the identifiers of an order (assigns new IDs as needed)
+inline OrderIds intern_order_ids(const fix::NewOrderSingle& msg) {
+    OrderIds ids;
+    ids.symbol = aggregation::SymbolInterner::instance().intern(msg.symbol);
+    ids.underlyer = aggregation::UnderlyerInterner::instance().intern(msg.underlyer);
+    ids.strategy = aggregation::StrategyInterner::instance().intern(msg.strategy_id);
+    ids.portfolio = aggregation::PortfolioInterner::instance().intern(msg.portfolio_id);
+    return ids;
+}
+
+// Resolve the identifiers of an order without interning (never allocates)
+// Identifiers never seen before resolve to INVALID_INTERNED_ID
+inline OrderIds find_order_ids(const fix::NewOrderSingle& msg) {
+    OrderIds ids;
+    ids.symbol = aggregation::SymbolInterner::instance().find(msg.symbol);
+    ids.underlyer = aggregation::UnderlyerInterner::instance().find(msg.underlyer);
+    ids.strategy = aggregation::StrategyInterner::instance().find(msg.strategy_id);
+    ids.portfolio = aggregation::PortfolioInterner::instance().find(msg.portfolio_id);
+    return ids;
+}
+
 // Tracked order information
 struct TrackedOrder {
     fix::OrderKey key;
+    OrderHandle handle;        // Slot in the OrderBook slab; stable for the order's lifetime
     std::string symbol;
     std::string underlyer;
     std::string strategy_id;
     std::string portfolio_id;
+    OrderIds ids;              // Interned once in OrderBook::add_order; used for grouping
     fix::Side side;
     double price;
     int64_t quantity;          // Original/current order quantity
@@ -49,6 +95,11 @@ struct TrackedOrder {
     std::optional<double> pending_price;
     std::optional<int64_t> pending_quantity;
     std::optional<fix::OrderKey> pending_key;  // New ClOrdID for pending replace
+    std::optional<fix::OrderKey> pending_cancel_key;  // ClOrdID of pending cancel request
+
+    // Links in the OrderBook's active-order list (invalid when not active)
+    OrderHandle active_prev;
+    OrderHandle active_next;
 
     // Note: notional() and delta_exposure() are now computed via InstrumentProvider
     // See InstrumentProvider::compute_notional() and compute_delta_exposure()
@@ -70,86 +121,302 @@ struct TrackedOrder {
 };
 
 // Order book maintaining state of all tracked orders
+//
+// Orders live in an OrderSlab, so a TrackedOrder never moves while it is
+// tracked: pointers returned by get_order() stay valid across later inserts
+// and replaces, and a keyed replace only re-points the ClOrdID index. The
+// ClOrdID maps are thin indexes onto OrderHandles. The slab and both maps
+// allocate from the MemoryResource given at construction; the strings inside
+// TrackedOrder still use the global allocator.
+//
+// Callers that keep the handle returned by add_order() (e.g. a gateway that
+// stores it next to its own order state) can use get_order(handle) and skip
+// the ClOrdID hash lookup entirely.
+//
+// Orders that reach a terminal state are retired: queued in the order they
+// finished. By default they are all kept, so late reports for them resolve,
+// until cleanup_terminal_orders() runs. After set_terminal_retention(n),
+// retired orders beyond the most recent n are reclaimed a few at a time by
+// later add_order() calls, so memory stays flat without a full scan. Pending
+// replace/cancel ClOrdIDs are unmapped on every exit from the pending state.
+//
+// Every state change goes through set_state(), which keeps a count of orders
+// per OrderState and an intrusive list (oldest first) of the active ones, so
+// active_order_count() is O(1) and for_each_active() visits only live orders.
 class OrderBook {
 private:
+    // Retired orders reclaimed per add_order(); more than one, so a backlog
+    // (e.g. after the retention is lowered) drains
+    static constexpr size_t RECLAIM_PER_ORDER = 2;
+
+public:
+    // Default retention: terminal orders stay until cleanup_terminal_orders()
+    static constexpr size_t RETAIN_ALL_TERMINAL = std::numeric_limits<size_t>::max();
+
+private:
+
+    OrderSlab<TrackedOrder> orders_;
+
     // Primary index: ClOrdID -> Order
-    aggregation::HashMap<fix::OrderKey, TrackedOrder> orders_;
+    aggregation::HashMap<fix::OrderKey, OrderHandle> index_;
+
+    // Mapping from pending replace/cancel ClOrdID to the order it targets
+    aggregation::HashMap<fix::OrderKey, OrderHandle> pending_replace_map_;
+
+    // Terminal orders, oldest first
+    HandleQueue retired_;
+    size_t terminal_retention_ = RETAIN_ALL_TERMINAL;
+
+    // Orders per OrderState, and the active ones as an intrusive list
+    std::array<size_t, ORDER_STATE_COUNT> state_counts_{};
+    OrderHandle active_head_;
+    OrderHandle active_tail_;
+    size_t active_count_ = 0;
+
+    TrackedOrder* find_indexed(const aggregation::HashMap<fix::OrderKey, OrderHandle>& index,
+                               const fix::OrderKey& key) {
+        auto it = index.find(key);
+        return (it != index.end()) ? orders_.get(it->second) : nullptr;
+    }
+
+    const TrackedOrder* find_indexed(const aggregation::HashMap<fix::OrderKey, OrderHandle>& index,
+                                     const fix::OrderKey& key) const {
+        auto it = index.find(key);
+        return (it != index.end()) ? orders_.get(it->second) : nullptr;
+    }
+
+    // Remove a ClOrdID mapping if it still refers to this order
+    static void unmap(aggregation::HashMap<fix::OrderKey, OrderHandle>& index,
+                      const fix::OrderKey& key, OrderHandle handle) {
+        auto it = index.find(key);
+        if (it != index.end() && it->second == handle) {
+            index.erase(it);
+        }
+    }
+
+    void clear_pending_keys(TrackedOrder& order) {
+        if (order.pending_key.has_value()) {
+            unmap(pending_replace_map_, *order.pending_key, order.handle);
+            order.pending_key.reset();
+        }
+        if (order.pending_cancel_key.has_value()) {
+            unmap(pending_replace_map_, *order.pending_cancel_key, order.handle);
+            order.pending_cancel_key.reset();
+        }
+    }
+
+    void link_active(TrackedOrder& order) {
+        order.active_prev = active_tail_;
+        order.active_next = OrderHandle{};
+        if (TrackedOrder* tail = orders_.get(active_tail_)) {
+            tail->active_next = order.handle;
+        } else {
+            active_head_ = order.handle;
+        }
+        active_tail_ = order.handle;
+        ++active_count_;
+    }
+
+    void unlink_active(TrackedOrder& order) {
+        if (TrackedOrder* prev = orders_.get(order.active_prev)) {
+            prev->active_next = order.active_next;
+        } else {
+            active_head_ = order.active_next;
+        }
+        if (TrackedOrder* next = orders_.get(order.active_next)) {
+            next->active_prev = order.active_prev;
+        } else {
+            active_tail_ = order.active_prev;
+        }
+        order.active_prev = OrderHandle{};
+        order.active_next = OrderHandle{};
+        --active_count_;
+    }
+
+    // Single point of state change: maintains the counters and active list
+    void set_state(TrackedOrder& order, OrderState state) {
+        bool was_active = !order.is_terminal();
+        --state_counts_[static_cast<size_t>(order.state)];
+        ++state_counts_[static_cast<size_t>(state)];
+        order.state = state;
+        if (was_active && order.is_terminal()) {
+            unlink_active(order);
+        }
+    }
+
+    // Queue an order that has just become terminal for reclamation
+    void retire(TrackedOrder& order) {
+        clear_pending_keys(order);
+        retired_.push(order.handle);
+    }
 
-    // Mapping from pending replace ClOrdID to original ClOrdID
-    aggregation::HashMap<fix::OrderKey, fix::OrderKey> pending_replace_map_;
+    // Drop an order and every ClOrdID mapping to it
+    void remove(TrackedOrder& order) {
+        if (!order.is_terminal()) {
+            unlink_active(order);
+        }
+        --state_counts_[static_cast<size_t>(order.state)];
+        clear_pending_keys(order);
+        unmap(index_, order.key, order.handle);
+        orders_.erase(order.handle);
+    }
 
 public:
+    explicit OrderBook(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : orders_(resource), index_(resource), pending_replace_map_(resource), retired_(resource) {}
+
+    // Pre-size the slab and both ClOrdID maps for this many tracked orders
+    void reserve(size_t orders) {
+        orders_.reserve(orders);
+        index_.reserve(orders);
+        pending_replace_map_.reserve(orders);
+        retired_.reserve(orders);
+    }
+
+    // Number of retired (terminal) orders kept for late reports before they
+    // are reclaimed; 0 reclaims them as soon as later orders arrive.
+    // RETAIN_ALL_TERMINAL (the default) never reclaims them automatically
+    void set_terminal_retention(size_t orders) { terminal_retention_ = orders; }
+    size_t terminal_retention() const { return terminal_retention_; }
+
+    // Reclaim up to max_orders retired orders beyond the retention window;
+    // returns the number reclaimed. Handles to reclaimed orders become stale.
+    size_t reclaim_retired(size_t max_orders) {
+        size_t reclaimed = 0;
+        while (reclaimed < max_orders && retired_.size() > terminal_retention_) {
+            OrderHandle handle = retired_.front();
+            retired_.pop();
+            // Already gone if its ClOrdID was reused or cleanup ran
+            TrackedOrder* order = orders_.get(handle);
+            if (order && order->is_terminal()) {
+                remove(*order);
+                ++reclaimed;
+            }
+        }
+        return reclaimed;
+    }
+
+    // Retired orders not yet reclaimed
+    size_t retired_count() const { return retired_.size(); }
+
+    // Pending replace/cancel ClOrdIDs currently mapped
+    size_t pending_key_count() const { return pending_replace_map_.size(); }
+
     // Add a new order (on NewOrderSingle sent)
-    void add_order(const fix::NewOrderSingle& msg) {
-        TrackedOrder order;
+    // A ClOrdID that is already tracked replaces the previous order
+    OrderHandle add_order(const fix::NewOrderSingle& msg) {
+        return add_order(msg, intern_order_ids(msg));
+    }
+
+    // Add an order whose identifiers the caller has already interned
+    OrderHandle add_order(const fix::NewOrderSingle& msg, const OrderIds& ids) {
+        reclaim_retired(RECLAIM_PER_ORDER);
+
+        if (TrackedOrder* existing = get_order(msg.key)) {
+            remove(*existing);
+        }
+
+        OrderHandle handle = orders_.emplace();
+        TrackedOrder& order = *orders_.get(handle);
         order.key = msg.key;
+        order.handle = handle;
         order.symbol = msg.symbol;
         order.underlyer = msg.underlyer;
         order.strategy_id = msg.strategy_id;
         order.portfolio_id = msg.portfolio_id;
+        order.ids = ids;
         order.side = msg.side;
         order.price = msg.price;
         order.quantity = msg.quantity;
         order.leaves_qty = msg.quantity;
         order.cum_qty = 0;
         order.state = OrderState::PENDING_NEW;
+        ++state_counts_[static_cast<size_t>(OrderState::PENDING_NEW)];
+        link_active(order);
 
-        orders_[msg.key] = std::move(order);
+        index_[msg.key] = handle;
+        return handle;
     }
 
     // Get order by ClOrdID
     TrackedOrder* get_order(const fix::OrderKey& key) {
-        auto it = orders_.find(key);
-        if (it != orders_.end()) {
-            return &it->second;
-        }
-        return nullptr;
+        return find_indexed(index_, key);
     }
 
     const TrackedOrder* get_order(const fix::OrderKey& key) const {
-        auto it = orders_.find(key);
-        if (it != orders_.end()) {
-            return &it->second;
-        }
-        return nullptr;
+        return find_indexed(index_, key);
+    }
+
+    // Get order by handle (nullptr if the order has since been removed)
+    TrackedOrder* get_order(OrderHandle handle) {
+        return orders_.get(handle);
+    }
+
+    const TrackedOrder* get_order(OrderHandle handle) const {
+        return orders_.get(handle);
+    }
+
+    // Handle for a ClOrdID (invalid handle if not tracked)
+    OrderHandle find_handle(const fix::OrderKey& key) const {
+        auto it = index_.find(key);
+        return (it != index_.end()) ? it->second : OrderHandle{};
     }
 
     // Resolve a ClOrdID that might be a pending replace key
     TrackedOrder* resolve_order(const fix::OrderKey& key) {
         // First check if this is a pending replace key
-        auto pending_it = pending_replace_map_.find(key);
-        if (pending_it != pending_replace_map_.end()) {
-            return get_order(pending_it->second);
+        if (auto* order = find_indexed(pending_replace_map_, key)) {
+            return order;
         }
         return get_order(key);
     }
 
+    // Locate the order an execution report refers to, using the same key
+    // the corresponding lifecycle transition expects
+    TrackedOrder* find_report_order(const fix::ExecutionReport& msg, fix::ExecutionReportType type) {
+        switch (type) {
+            case fix::ExecutionReportType::INSERT_ACK:
+            case fix::ExecutionReportType::INSERT_NACK:
+                return get_order(msg.key);
+            case fix::ExecutionReportType::UPDATE_ACK:
+            case fix::ExecutionReportType::UPDATE_NACK:
+            case fix::ExecutionReportType::CANCEL_NACK:
+                return get_order(msg.orig_key.value_or(msg.key));
+            case fix::ExecutionReportType::CANCEL_ACK:
+            case fix::ExecutionReportType::UNSOLICITED_CANCEL:
+                return resolve_order(msg.orig_key.value_or(msg.key));
+            case fix::ExecutionReportType::PARTIAL_FILL:
+            case fix::ExecutionReportType::FULL_FILL:
+                return resolve_order(msg.key);
+        }
+        return nullptr;
+    }
+
     // Mark order as acknowledged (OPEN)
-    void acknowledge_order(const fix::OrderKey& key) {
-        auto* order = get_order(key);
-        if (order && order->state == OrderState::PENDING_NEW) {
-            order->state = OrderState::OPEN;
+    void acknowledge_order(TrackedOrder& order) {
+        if (order.state == OrderState::PENDING_NEW) {
+            set_state(order, OrderState::OPEN);
         }
     }
 
     // Mark order as rejected
-    void reject_order(const fix::OrderKey& key) {
-        auto* order = get_order(key);
-        if (order) {
-            order->state = OrderState::REJECTED;
+    void reject_order(TrackedOrder& order) {
+        bool was_terminal = order.is_terminal();
+        set_state(order, OrderState::REJECTED);
+        if (!was_terminal) {
+            retire(order);
         }
     }
 
     // Start a pending replace
-    void start_replace(const fix::OrderKey& orig_key, const fix::OrderKey& new_key,
-                       double new_price, double new_quantity) {
-        auto* order = get_order(orig_key);
-        if (order && (order->state == OrderState::OPEN || order->state == OrderState::PENDING_NEW)) {
-            order->state = OrderState::PENDING_REPLACE;
-            order->pending_key = new_key;
-            order->pending_price = new_price;
-            order->pending_quantity = new_quantity;
-            pending_replace_map_[new_key] = orig_key;
+    void start_replace(TrackedOrder& order, const fix::OrderKey& new_key,
+                       double new_price, int64_t new_quantity) {
+        if (order.state == OrderState::OPEN || order.state == OrderState::PENDING_NEW) {
+            set_state(order, OrderState::PENDING_REPLACE);
+            order.pending_key = new_key;
+            order.pending_price = new_price;
+            order.pending_quantity = new_quantity;
+            pending_replace_map_[new_key] = order.handle;
         }
     }
 
@@ -160,41 +427,37 @@ public:
         // Note: old_notional and old_delta_exposure computed via InstrumentProvider
     };
 
-    std::optional<ReplaceResult> complete_replace(const fix::OrderKey& orig_key) {
-        auto* order = get_order(orig_key);
-        if (order && order->state == OrderState::PENDING_REPLACE &&
-            order->pending_price.has_value() && order->pending_quantity.has_value()) {
+    std::optional<ReplaceResult> complete_replace(TrackedOrder& order) {
+        if (order.state == OrderState::PENDING_REPLACE &&
+            order.pending_price.has_value() && order.pending_quantity.has_value()) {
 
             ReplaceResult result;
-            result.old_price = order->price;
-            result.old_leaves_qty = order->leaves_qty;
+            result.old_price = order.price;
+            result.old_leaves_qty = order.leaves_qty;
 
             // Apply pending values
-            order->price = order->pending_price.value();
-            order->quantity = order->pending_quantity.value();
-            order->leaves_qty = order->pending_quantity.value();
-
-            // Save the key to use for final lookup before potentially invalidating order pointer
-            fix::OrderKey final_key = orig_key;
-
-            // Update key mapping if new key was assigned
-            if (order->pending_key.has_value()) {
-                final_key = order->pending_key.value();
-                pending_replace_map_.erase(final_key);
-                TrackedOrder updated_order = std::move(*order);
-                updated_order.key = final_key;
-                orders_.erase(orig_key);
-                orders_[final_key] = std::move(updated_order);
+            order.price = order.pending_price.value();
+            order.quantity = order.pending_quantity.value();
+            order.leaves_qty = order.pending_quantity.value();
+
+            // Re-key the index if a new ClOrdID was assigned; the order itself
+            // stays in its slot. Another order still tracked under the new
+            // ClOrdID is dropped, as in add_order()
+            if (order.pending_key.has_value()) {
+                unmap(pending_replace_map_, *order.pending_key, order.handle);
+                unmap(index_, order.key, order.handle);
+                TrackedOrder* displaced = get_order(*order.pending_key);
+                if (displaced != nullptr && displaced != &order) {
+                    remove(*displaced);
+                }
+                order.key = std::move(*order.pending_key);
+                index_[order.key] = order.handle;
             }
 
-            // Clear pending state - use saved key since order pointer may be invalid
-            order = get_order(final_key);
-            if (order) {
-                order->state = OrderState::OPEN;
-                order->pending_price.reset();
-                order->pending_quantity.reset();
-                order->pending_key.reset();
-            }
+            set_state(order, OrderState::OPEN);
+            order.pending_price.reset();
+            order.pending_quantity.reset();
+            order.pending_key.reset();
 
             return result;
         }
@@ -202,41 +465,38 @@ public:
     }
 
     // Reject a replace - revert to original state
-    void reject_replace(const fix::OrderKey& orig_key) {
-        auto* order = get_order(orig_key);
-        if (order && order->state == OrderState::PENDING_REPLACE) {
-            if (order->pending_key.has_value()) {
-                pending_replace_map_.erase(order->pending_key.value());
-            }
-            order->state = OrderState::OPEN;
-            order->pending_price.reset();
-            order->pending_quantity.reset();
-            order->pending_key.reset();
+    void reject_replace(TrackedOrder& order) {
+        if (order.state == OrderState::PENDING_REPLACE) {
+            clear_pending_keys(order);
+            set_state(order, OrderState::OPEN);
+            order.pending_price.reset();
+            order.pending_quantity.reset();
         }
     }
 
     // Start a pending cancel
-    void start_cancel(const fix::OrderKey& orig_key, const fix::OrderKey& cancel_key) {
-        auto* order = get_order(orig_key);
-        if (order && (order->state == OrderState::OPEN || order->state == OrderState::PENDING_NEW)) {
-            order->state = OrderState::PENDING_CANCEL;
-            pending_replace_map_[cancel_key] = orig_key;
+    void start_cancel(TrackedOrder& order, const fix::OrderKey& cancel_key) {
+        if (order.state == OrderState::OPEN || order.state == OrderState::PENDING_NEW) {
+            set_state(order, OrderState::PENDING_CANCEL);
+            order.pending_cancel_key = cancel_key;
+            pending_replace_map_[cancel_key] = order.handle;
         }
     }
 
     // Complete a cancel
-    void complete_cancel(const fix::OrderKey& key) {
-        auto* order = resolve_order(key);
-        if (order) {
-            order->state = OrderState::CANCELED;
+    void complete_cancel(TrackedOrder& order) {
+        bool was_terminal = order.is_terminal();
+        set_state(order, OrderState::CANCELED);
+        if (!was_terminal) {
+            retire(order);
         }
     }
 
     // Reject a cancel - revert to original state
-    void reject_cancel(const fix::OrderKey& orig_key) {
-        auto* order = get_order(orig_key);
-        if (order && order->state == OrderState::PENDING_CANCEL) {
-            order->state = OrderState::OPEN;
+    void reject_cancel(TrackedOrder& order) {
+        if (order.state == OrderState::PENDING_CANCEL) {
+            clear_pending_keys(order);
+            set_state(order, OrderState::OPEN);
         }
     }
 
@@ -247,18 +507,18 @@ public:
         bool is_complete;
     };
 
-    std::optional<FillResult> apply_fill(const fix::OrderKey& key, int64_t last_qty, double /*last_px*/) {
-        auto* order = resolve_order(key);
-        if (order && !order->is_terminal()) {
+    std::optional<FillResult> apply_fill(TrackedOrder& order, int64_t last_qty, double /*last_px*/) {
+        if (!order.is_terminal()) {
             FillResult result;
             result.filled_qty = last_qty;
 
-            order->leaves_qty -= last_qty;
-            order->cum_qty += last_qty;
+            order.leaves_qty -= last_qty;
+            order.cum_qty += last_qty;
 
-            if (order->leaves_qty <= 0) {
-                order->state = OrderState::FILLED;
-                order->leaves_qty = 0;
+            if (order.leaves_qty <= 0) {
+                set_state(order, OrderState::FILLED);
+                order.leaves_qty = 0;
+                retire(order);
                 result.is_complete = true;
             } else {
                 result.is_complete = false;
@@ -269,33 +529,54 @@ public:
         return std::nullopt;
     }
 
-    // Remove terminal orders (cleanup)
+    // Remove all terminal orders now, ignoring the retention window
+    // Handles to removed orders become stale
     void cleanup_terminal_orders() {
-        for (auto it = orders_.begin(); it != orders_.end(); ) {
-            if (it->second.is_terminal()) {
-                it = orders_.erase(it);
-            } else {
-                ++it;
+        orders_.for_each([this](OrderHandle, TrackedOrder& order) {
+            if (order.is_terminal()) {
+                remove(order);
             }
+        });
+        retired_.clear();
+    }
+
+    // Visit active (non-terminal) orders, oldest first, without allocating
+    // func must not add or remove orders
+    template<typename Func>
+    void for_each_active(Func&& func) const {
+        for (const TrackedOrder* order = orders_.get(active_head_); order; order = orders_.get(order->active_next)) {
+            func(*order);
         }
     }
 
-    // Get all active orders
+    // Get all active orders (allocates; prefer for_each_active)
     std::vector<const TrackedOrder*> active_orders() const {
         std::vector<const TrackedOrder*> result;
-        for (const auto& [_, order] : orders_) {
-            if (!order.is_terminal()) {
-                result.push_back(&order);
-            }
-        }
+        result.reserve(active_count_);
+        for_each_active([&result](const TrackedOrder& order) {
+            result.push_back(&order);
+        });
         return result;
     }
 
+    size_t active_order_count() const { return active_count_; }
+
+    // Tracked orders currently in a state (terminal ones until reclaimed)
+    size_t order_count(OrderState state) const {
+        return state_counts_[static_cast<size_t>(state)];
+    }
+
     size_t size() const { return orders_.size(); }
 
     void clear() {
         orders_.clear();
+        index_.clear();
         pending_replace_map_.clear();
+        retired_.clear();
+        state_counts_.fill(0);
+        active_head_ = OrderHandle{};
+        active_tail_ = OrderHandle{};
+        active_count_ = 0;
     }
 };
 
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 #include <sstream>
@@ -25,6 +28,11 @@ enum class LimitType {
     GLOBAL_NET_NOTIONAL    // Global net notional (BID - ASK)
 };
 
+inline constexpr size_t LIMIT_TYPE_COUNT = 11;
+
+// max_permissible_quantity() when no configured limit bounds the quantity
+inline constexpr int64_t UNLIMITED_QUANTITY = std::numeric_limits<int64_t>::max();
+
 inline const char* to_string(LimitType type) {
     switch (type) {
         case LimitType::ORDER_COUNT: return "ORDER_COUNT";
@@ -42,6 +50,34 @@ inline const char* to_string(LimitType type) {
     }
 }
 
+// ============================================================================
+// LimitTypeMask - Fixed-size set of LimitTypes
+// ============================================================================
+//
+// Answer of the allocation-free pre-trade checks (would_pass / breached_limits):
+// which limit types an order breaches, without keys or usage figures.
+//
+
+struct LimitTypeMask {
+    static_assert(LIMIT_TYPE_COUNT <= 32, "LimitTypeMask holds at most 32 limit types");
+
+    uint32_t bits = 0;
+
+    static constexpr uint32_t bit(LimitType type) {
+        return uint32_t{1} << static_cast<unsigned>(type);
+    }
+
+    void set(LimitType type) { bits |= bit(type); }
+    bool test(LimitType type) const { return (bits & bit(type)) != 0; }
+
+    bool any() const { return bits != 0; }
+    bool none() const { return bits == 0; }
+    size_t count() const { return static_cast<size_t>(__builtin_popcount(bits)); }
+
+    bool operator==(const LimitTypeMask& other) const { return bits == other.bits; }
+    bool operator!=(const LimitTypeMask& other) const { return bits != other.bits; }
+};
+
 // ============================================================================
 // LimitBreachInfo - Details about a single limit breach
 // ============================================================================
@@ -70,6 +106,7 @@ struct LimitBreachInfo {
 
 struct PreTradeCheckResult {
     bool would_breach = false;
+    LimitTypeMask breached;
     std::vector<LimitBreachInfo> breaches;
 
     // Implicit conversion: true = order is OK to proceed
@@ -78,6 +115,7 @@ struct PreTradeCheckResult {
     // Add a breach
     void add_breach(LimitBreachInfo info) {
         would_breach = true;
+        breached.set(info.type);
         breaches.push_back(std::move(info));
     }
 
@@ -96,12 +134,7 @@ struct PreTradeCheckResult {
 
     // Check if a specific limit type was breached
     bool has_breach(LimitType type) const {
-        for (const auto& breach : breaches) {
-            if (breach.type == type) {
-                return true;
-            }
-        }
-        return false;
+        return breached.test(type);
     }
 
     // Get first breach of a specific type (if any)
@@ -115,4 +148,54 @@ struct PreTradeCheckResult {
     }
 };
 
+// ============================================================================
+// BatchPreTradeCheckResult - Result of a batch pre-trade check
+// ============================================================================
+
+struct BatchPreTradeCheckResult {
+    std::vector<PreTradeCheckResult> orders;  // One per order, in batch order
+    size_t passed = 0;
+
+    bool all_passed() const { return passed == orders.size(); }
+    size_t size() const { return orders.size(); }
+    const PreTradeCheckResult& operator[](size_t i) const { return orders[i]; }
+};
+
+// ============================================================================
+// Breach sinks - Where the limit checks report breaches
+// ============================================================================
+//
+// The limit checks evaluate every metric the same way and hand each breach to
+// a sink as (type, key formatter, limit, current, hypothetical). The key is
+// only formatted by the sink that keeps details, so the mask sink never
+// touches the heap. done() lets a sink stop the check early.
+//
+
+namespace detail {
+
+struct BreachDetailSink {
+    PreTradeCheckResult& result;
+
+    bool done() const { return false; }
+
+    template<typename FormatKey>
+    void record(LimitType type, FormatKey&& format_key, double limit, double current, double hypothetical) {
+        result.add_breach({type, format_key(), limit, current, hypothetical});
+    }
+};
+
+struct BreachMaskSink {
+    LimitTypeMask mask;
+    bool stop_at_first = false;
+
+    bool done() const { return stop_at_first && mask.any(); }
+
+    template<typename FormatKey>
+    void record(LimitType type, FormatKey&&, double, double, double) {
+        mask.set(type);
+    }
+};
+
+}  // namespace detail
+
 }  // namespace engine
@@ -4,9 +4,16 @@
 #include "limits_config.hpp"
 #include "metric_limit_store.hpp"
 #include "pre_trade_check.hpp"
+#include "../aggregation/limit_check_table.hpp"
 #include "../metrics/delta_metric.hpp"
 #include "../metrics/order_count_metric.hpp"
 #include "../metrics/notional_metric.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
 
 namespace engine {
 
@@ -50,18 +57,190 @@ namespace engine {
 //   auto instrument = provider.get_instrument(order.symbol);
 //   auto result = engine.pre_trade_check(order, instrument);
 //
+//   // Hot path: no allocation; details only for rejects
+//   if (!engine.would_pass(order, instrument)) {
+//       auto details = engine.pre_trade_check(order, instrument);
+//   }
+//
+//   // Order entry: check and, if within limits, add in one call
+//   SubmitResult submit = engine.try_submit(order, instrument);
+//
+
+// ============================================================================
+// BatchKeyUsage - One metric's usage per key over a batch pre-trade check
+// ============================================================================
+//
+// Current usage and limit are read once per distinct key; accepted is what
+// the batch's earlier passing orders add. Most batches touch few keys, so
+// up to LINEAR_SCAN_LIMIT entries are scanned linearly; past that they are
+// indexed by key (likewise the quoted instruments), so a basket of many
+// distinct keys stays linear overall. The order being checked is pending
+// until it is known to pass (commit) or not.
+//
+
+namespace detail {
+
+template<typename Key>
+struct BatchKeyUsage {
+    static constexpr size_t LINEAR_SCAN_LIMIT = 16;
+
+    struct Entry {
+        Key key;
+        double current;
+        double limit;
+        double accepted;
+    };
+
+    std::vector<Entry> entries;
+    aggregation::FlatHashMap<Key, size_t> entry_index;  // Once past LINEAR_SCAN_LIMIT
+    size_t pending = 0;
+    double pending_contribution = 0.0;
+
+    // Instruments quoted by passing orders (QuotedInstrumentCountMetric only)
+    std::vector<aggregation::InternedId> quoted_symbols;
+    aggregation::FlatHashMap<aggregation::InternedId, uint8_t> quoted_index;  // Once past LINEAR_SCAN_LIMIT
+    aggregation::InternedId pending_symbol = aggregation::INVALID_INTERNED_ID;
+
+    // Index of key's entry; load() -> {current, limit} is called for new keys
+    template<typename Load>
+    size_t find_or_add(const Key& key, Load&& load) {
+        if (entries.size() <= LINEAR_SCAN_LIMIT) {
+            for (size_t i = 0; i < entries.size(); ++i) {
+                if (entries[i].key == key) return i;
+            }
+        } else {
+            auto it = entry_index.find(key);
+            if (it != entry_index.end()) return it->second;
+        }
+        auto [current, limit] = load();
+        entries.push_back({key, current, limit, 0.0});
+        if (entries.size() == LINEAR_SCAN_LIMIT + 1) {
+            for (size_t i = 0; i < entries.size(); ++i) {
+                entry_index.try_emplace(entries[i].key, i);
+            }
+        } else if (entries.size() > LINEAR_SCAN_LIMIT) {
+            entry_index.try_emplace(key, entries.size() - 1);
+        }
+        return entries.size() - 1;
+    }
+
+    bool is_quoted(aggregation::InternedId symbol) const {
+        if (quoted_symbols.size() > LINEAR_SCAN_LIMIT) {
+            return quoted_index.contains(symbol);
+        }
+        for (aggregation::InternedId quoted : quoted_symbols) {
+            if (quoted == symbol) return true;
+        }
+        return false;
+    }
+
+    void reset_pending() {
+        pending_contribution = 0.0;
+        pending_symbol = aggregation::INVALID_INTERNED_ID;
+    }
+
+    // The pending order passed: later orders see its contribution
+    void commit() {
+        if (pending_contribution != 0.0) {
+            entries[pending].accepted += pending_contribution;
+        }
+        if (pending_symbol != aggregation::INVALID_INTERNED_ID) {
+            quoted_symbols.push_back(pending_symbol);
+            if (quoted_symbols.size() == LINEAR_SCAN_LIMIT + 1) {
+                for (aggregation::InternedId quoted : quoted_symbols) {
+                    quoted_index.try_emplace(quoted, 1);
+                }
+            } else if (quoted_symbols.size() > LINEAR_SCAN_LIMIT) {
+                quoted_index.try_emplace(pending_symbol, 1);
+            }
+        }
+        reset_pending();
+    }
+};
+
+// ============================================================================
+// BatchOrderIds - Resolves a batch's identifiers without interning
+// ============================================================================
+//
+// A batch check only reads, so it resolves identifiers with find() rather
+// than interning them. An identifier never seen before gets a provisional ID
+// instead, one per distinct name, counting down from INVALID_INTERNED_ID, so
+// two new instruments in one batch stay two keys. Nothing can be stored
+// under an unseen name (setting a limit for it interns it), so its
+// provisional ID reads as no usage under the default limit, as its interned
+// ID would. The names are views into the batch's orders.
+//
+
+class BatchOrderIds {
+private:
+    std::vector<std::string_view> unseen_symbols_;
+    std::vector<std::string_view> unseen_underlyers_;
+    std::vector<std::string_view> unseen_strategies_;
+    std::vector<std::string_view> unseen_portfolios_;
+
+    template<typename Interner>
+    static aggregation::InternedId resolve(const Interner& interner, std::vector<std::string_view>& unseen,
+                                           std::string_view name) {
+        aggregation::InternedId id = interner.find(name);
+        if (id != aggregation::INVALID_INTERNED_ID) return id;
+        size_t index = 0;
+        while (index < unseen.size() && unseen[index] != name) {
+            ++index;
+        }
+        if (index == unseen.size()) {
+            unseen.push_back(name);
+        }
+        return aggregation::INVALID_INTERNED_ID - 1 - static_cast<aggregation::InternedId>(index);
+    }
+
+public:
+    OrderIds resolve(const fix::NewOrderSingle& order) {
+        OrderIds ids;
+        ids.symbol = resolve(aggregation::SymbolInterner::instance(), unseen_symbols_, order.symbol);
+        ids.underlyer = resolve(aggregation::UnderlyerInterner::instance(), unseen_underlyers_, order.underlyer);
+        ids.strategy = resolve(aggregation::StrategyInterner::instance(), unseen_strategies_, order.strategy_id);
+        ids.portfolio = resolve(aggregation::PortfolioInterner::instance(), unseen_portfolios_, order.portfolio_id);
+        return ids;
+    }
+};
+
+}  // namespace detail
+
+// ============================================================================
+// SubmitResult - Outcome of try_submit()
+// ============================================================================
+
+struct SubmitResult {
+    OrderHandle handle;           // Invalid if the order was rejected
+    PreTradeCheckResult check;    // Breaches that rejected the order
+
+    bool accepted() const { return handle.is_valid(); }
+    explicit operator bool() const { return accepted(); }
+};
 
 template<typename ContextType, typename Instrument, typename... Metrics>
 class RiskAggregationEngineWithLimits {
 private:
     GenericRiskAggregationEngine<ContextType, Instrument, Metrics...> engine_;
     MetricLimitStores<Metrics...> limits_;
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    // Pre-trade checks are const; lifecycle handlers are counted by engine_
+    mutable aggregation::HandlerAllocationStats pre_trade_allocation_stats_;
+#endif
 
 public:
     using instrument_type = Instrument;
     using context_type = ContextType;
 
-    explicit RiskAggregationEngineWithLimits(const ContextType& context) : engine_(context) {}
+    explicit RiskAggregationEngineWithLimits(const ContextType& context,
+                                             aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : engine_(context, resource), limits_(resource) {}
+
+    // Pre-sizes containers from capacity (see reserve())
+    RiskAggregationEngineWithLimits(const ContextType& context,
+                                    const aggregation::CapacityHints& capacity,
+                                    aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : engine_(context, capacity, resource), limits_(resource) {}
 
     // ========================================================================
     // Context access
@@ -77,29 +256,88 @@ public:
     const GenericRiskAggregationEngine<ContextType, Instrument, Metrics...>& engine() const { return engine_; }
 
     // Forward all message handlers - caller provides instrument
-    void on_new_order_single(const fix::NewOrderSingle& msg, const Instrument& instrument) {
-        engine_.on_new_order_single(msg, instrument);
+    OrderHandle on_new_order_single(const fix::NewOrderSingle& msg, const Instrument& instrument) {
+        return engine_.on_new_order_single(msg, instrument);
     }
 
     void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, const Instrument& instrument) {
         engine_.on_order_cancel_replace(msg, instrument);
     }
 
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, const Instrument& instrument, OrderHandle handle) {
+        engine_.on_order_cancel_replace(msg, instrument, handle);
+    }
+
     void on_order_cancel_request(const fix::OrderCancelRequest& msg, const Instrument& instrument) {
         engine_.on_order_cancel_request(msg, instrument);
     }
 
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg, const Instrument& instrument, OrderHandle handle) {
+        engine_.on_order_cancel_request(msg, instrument, handle);
+    }
+
     void on_execution_report(const fix::ExecutionReport& msg, const Instrument& instrument) {
         engine_.on_execution_report(msg, instrument);
     }
 
+    void on_execution_report(const fix::ExecutionReport& msg, const Instrument& instrument, OrderHandle handle) {
+        engine_.on_execution_report(msg, instrument, handle);
+    }
+
     void on_order_cancel_reject(const fix::OrderCancelReject& msg, const Instrument& instrument) {
         engine_.on_order_cancel_reject(msg, instrument);
     }
 
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg, const Instrument& instrument, OrderHandle handle) {
+        engine_.on_order_cancel_reject(msg, instrument, handle);
+    }
+
+    // Forward handlers using the instrument bound at on_new_order_single()
+    // (see GenericRiskAggregationEngine)
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg) {
+        engine_.on_order_cancel_replace(msg);
+    }
+
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, OrderHandle handle) {
+        engine_.on_order_cancel_replace(msg, handle);
+    }
+
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg) {
+        engine_.on_order_cancel_request(msg);
+    }
+
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg, OrderHandle handle) {
+        engine_.on_order_cancel_request(msg, handle);
+    }
+
+    void on_execution_report(const fix::ExecutionReport& msg) {
+        engine_.on_execution_report(msg);
+    }
+
+    void on_execution_report(const fix::ExecutionReport& msg, OrderHandle handle) {
+        engine_.on_execution_report(msg, handle);
+    }
+
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg) {
+        engine_.on_order_cancel_reject(msg);
+    }
+
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg, OrderHandle handle) {
+        engine_.on_order_cancel_reject(msg, handle);
+    }
+
+    static constexpr bool can_bind_instruments() {
+        return GenericRiskAggregationEngine<ContextType, Instrument, Metrics...>::can_bind_instruments();
+    }
+    void set_instrument_binding(bool enabled) { engine_.set_instrument_binding(enabled); }
+    bool instrument_binding() const { return engine_.instrument_binding(); }
+    const Instrument* bound_instrument(const TrackedOrder& order) const { return engine_.bound_instrument(order); }
+
     // Forward order book access
     const OrderBook& order_book() const { return engine_.order_book(); }
     size_t active_order_count() const { return engine_.active_order_count(); }
+    void set_terminal_order_retention(size_t orders) { engine_.set_terminal_order_retention(orders); }
+    void cleanup_terminal_orders() { engine_.cleanup_terminal_orders(); }
 
     void clear() {
         engine_.clear();
@@ -110,6 +348,23 @@ public:
         limits_.reset();
     }
 
+    void reserve(const aggregation::CapacityHints& capacity) {
+        engine_.reserve(capacity);
+    }
+
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    aggregation::HandlerAllocationStats allocation_stats() const {
+        aggregation::HandlerAllocationStats stats = engine_.allocation_stats();
+        stats.merge(pre_trade_allocation_stats_);
+        return stats;
+    }
+
+    void reset_allocation_stats() {
+        engine_.reset_allocation_stats();
+        pre_trade_allocation_stats_.reset();
+    }
+#endif
+
     // ========================================================================
     // Position management
     // ========================================================================
@@ -179,14 +434,19 @@ public:
     // Check if a new order would breach any configured limits
     // Returns a structured result with all breaches
     PreTradeCheckResult pre_trade_check(const fix::NewOrderSingle& order, const Instrument& instrument) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
         PreTradeCheckResult result;
-        check_all_limits<Metrics...>(order, instrument, result);
+        detail::BreachDetailSink sink{result};
+        // Resolve the order's identifiers once; every metric builds its key from them
+        const OrderIds ids = find_order_ids(order);
+        check_all_limits<Metrics...>(order, ids, instrument, sink);
         return result;
     }
 
     // Check if an order update would breach any configured limits
     // Returns a structured result with all breaches
     PreTradeCheckResult pre_trade_check(const fix::OrderCancelReplaceRequest& update, const Instrument& instrument) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
         PreTradeCheckResult result;
 
         // Look up the existing order
@@ -196,25 +456,25 @@ public:
             return result;
         }
 
-        check_all_update_limits<Metrics...>(update, *existing, instrument, result);
+        detail::BreachDetailSink sink{result};
+        check_all_update_limits<Metrics...>(update, *existing, instrument, sink);
         return result;
     }
 
     // Check if a new order would breach a specific metric's limit
     template<typename Metric>
     PreTradeCheckResult pre_trade_check_single(const fix::NewOrderSingle& order, const Instrument& instrument) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
         PreTradeCheckResult result;
-        if constexpr (is_quoted_instrument_metric<Metric>::value) {
-            check_quoted_instrument_limit<Metric>(order, instrument, result);
-        } else {
-            check_standard_limit<Metric>(order, instrument, result);
-        }
+        detail::BreachDetailSink sink{result};
+        check_metric_limit<Metric>(order, find_order_ids(order), instrument, sink);
         return result;
     }
 
     // Check if an order update would breach a specific metric's limit
     template<typename Metric>
     PreTradeCheckResult pre_trade_check_single(const fix::OrderCancelReplaceRequest& update, const Instrument& instrument) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
         PreTradeCheckResult result;
 
         const TrackedOrder* existing = engine_.order_book().get_order(update.orig_key);
@@ -222,10 +482,136 @@ public:
             return result;
         }
 
-        check_standard_update_limit<Metric>(update, *existing, instrument, result);
+        detail::BreachDetailSink sink{result};
+        check_standard_update_limit<Metric>(update, *existing, instrument, sink);
         return result;
     }
 
+    // ========================================================================
+    // Fast-Path Pre-Trade Check (no heap allocation)
+    // ========================================================================
+    //
+    // would_pass() stops at the first breached limit; breached_limits() checks
+    // them all. Neither formats keys or builds LimitBreachInfo, so on a reject
+    // call pre_trade_check() for the details.
+    //
+
+    bool would_pass(const fix::NewOrderSingle& order, const Instrument& instrument) const {
+        return check_mask(order, instrument, true).none();
+    }
+
+    bool would_pass(const fix::OrderCancelReplaceRequest& update, const Instrument& instrument) const {
+        return check_mask(update, instrument, true).none();
+    }
+
+    LimitTypeMask breached_limits(const fix::NewOrderSingle& order, const Instrument& instrument) const {
+        return check_mask(order, instrument, false);
+    }
+
+    LimitTypeMask breached_limits(const fix::OrderCancelReplaceRequest& update, const Instrument& instrument) const {
+        return check_mask(update, instrument, false);
+    }
+
+    // ========================================================================
+    // Check-and-add
+    // ========================================================================
+    //
+    // try_submit() is pre_trade_check() followed, if no limit would be
+    // breached, by on_new_order_single(), in one call: the order's
+    // identifiers are resolved once, and metrics that support it (see
+    // has_prepare_order) extract the key and capture the inputs once for both
+    // the check and the add. Identifiers are only interned once the order
+    // passes, so a rejected order leaves the engine and the interners
+    // untouched.
+    //
+
+    SubmitResult try_submit(const fix::NewOrderSingle& order, const Instrument& instrument) {
+        SubmitResult submit;
+        OrderIds ids = find_order_ids(order);
+        auto prepared = engine_.prepare_order(order, ids, instrument);
+        check_prepared(order, ids, instrument, prepared, submit.check);
+        if (!submit.check.would_breach) {
+            if (!ids.all_resolved()) {
+                // First order for some identifier: intern, and re-derive the keys
+                ids = intern_order_ids(order);
+                prepared = engine_.prepare_order(order, ids, instrument);
+            }
+            submit.handle = engine_.on_new_order_single(order, instrument, ids, prepared);
+        }
+        return submit;
+    }
+
+    // ========================================================================
+    // Batch Pre-Trade Check
+    // ========================================================================
+    //
+    // Checks a basket or quote ladder as if its orders were sent one after
+    // another: each order is checked against current usage plus what the
+    // batch's earlier passing orders add. A failing order adds nothing, so
+    // later orders may still pass. Usage and limits are read once per
+    // distinct key rather than once per order. instruments[i] points to the
+    // instrument of orders[i]; the two must be the same length and the
+    // pointers non-null (std::invalid_argument otherwise). Identifiers are
+    // resolved without interning (see detail::BatchOrderIds).
+    //
+
+    BatchPreTradeCheckResult pre_trade_check_batch(const std::vector<fix::NewOrderSingle>& orders,
+                                                   const std::vector<const Instrument*>& instruments) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        if (instruments.size() != orders.size()) {
+            throw std::invalid_argument("pre_trade_check_batch: one instrument per order required");
+        }
+        if (std::find(instruments.begin(), instruments.end(), nullptr) != instruments.end()) {
+            throw std::invalid_argument("pre_trade_check_batch: null instrument");
+        }
+        BatchPreTradeCheckResult batch;
+        batch.orders.resize(orders.size());
+        BatchUsage usage;
+        detail::BatchOrderIds batch_ids;
+        for (size_t i = 0; i < orders.size(); ++i) {
+            check_batch_order(orders[i], batch_ids.resolve(orders[i]), *instruments[i], usage, batch.orders[i],
+                              std::index_sequence_for<Metrics...>{});
+            if (!batch.orders[i].would_breach) {
+                ++batch.passed;
+            }
+        }
+        return batch;
+    }
+
+    // ========================================================================
+    // Maximum Permissible Quantity
+    // ========================================================================
+    //
+    // Largest quantity for which the order (its quantity is ignored) would
+    // pass every limit: 0 if none would, UNLIMITED_QUANTITY if no limit
+    // bounds it. Metrics whose contribution scales with quantity (exposure
+    // metrics, see compute_quantity_contribution) are solved for the
+    // quantity under their limit's comparison mode; the others (order and
+    // quoted instrument counts) are gates that pass or fail whatever the
+    // quantity. Under an ABSOLUTE limit a metric may pass only from some
+    // quantity up (an order reducing usage that is beyond -limit or +limit),
+    // so each metric yields a range of quantities; the answer is the top of
+    // their intersection, re-checked against every limit.
+    //
+
+    int64_t max_permissible_quantity(const fix::NewOrderSingle& order, const Instrument& instrument) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        const OrderIds ids = find_order_ids(order);
+        QuantityRange range;
+        ((range = range.intersect(metric_quantity_range<Metrics>(order, ids, instrument))), ...);
+        if (range.empty()) return 0;
+        if (range.hi == UNLIMITED_QUANTITY) return UNLIMITED_QUANTITY;
+
+        // The ranges are solved in floating point: confirm the quantity
+        // passes every limit, stepping down past rounding
+        for (int64_t quantity = range.hi; quantity >= range.lo && quantity + 2 > range.hi; --quantity) {
+            if ((quantity_within_limit<Metrics>(order, ids, instrument, quantity) && ...)) {
+                return quantity;
+            }
+        }
+        return 0;
+    }
+
 private:
     // ========================================================================
     // Metric type detection traits
@@ -241,74 +627,289 @@ private:
     // Pre-Trade Check Implementation
     // ========================================================================
 
-    template<typename First, typename... Rest>
-    void check_all_limits(const fix::NewOrderSingle& order, const Instrument& instrument, PreTradeCheckResult& result) const {
-        check_metric_limit<First>(order, instrument, result);
+    LimitTypeMask check_mask(const fix::NewOrderSingle& order, const Instrument& instrument, bool stop_at_first) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        detail::BreachMaskSink sink;
+        sink.stop_at_first = stop_at_first;
+        check_all_limits<Metrics...>(order, find_order_ids(order), instrument, sink);
+        return sink.mask;
+    }
+
+    LimitTypeMask check_mask(const fix::OrderCancelReplaceRequest& update, const Instrument& instrument, bool stop_at_first) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        detail::BreachMaskSink sink;
+        sink.stop_at_first = stop_at_first;
+        if (const TrackedOrder* existing = engine_.order_book().get_order(update.orig_key)) {
+            check_all_update_limits<Metrics...>(update, *existing, instrument, sink);
+        }
+        return sink.mask;
+    }
+
+    using PreparedOrder = typename GenericRiskAggregationEngine<ContextType, Instrument, Metrics...>::PreparedOrder;
+
+    void check_prepared(const fix::NewOrderSingle& order, const OrderIds& ids, const Instrument& instrument,
+                        const PreparedOrder& prepared, PreTradeCheckResult& result) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        detail::BreachDetailSink sink{result};
+        check_prepared_limits(order, ids, instrument, prepared, sink, std::index_sequence_for<Metrics...>{});
+    }
+
+    template<size_t... I, typename Sink>
+    void check_prepared_limits(const fix::NewOrderSingle& order, const OrderIds& ids, const Instrument& instrument,
+                               const PreparedOrder& prepared, Sink& sink, std::index_sequence<I...>) const {
+        (check_prepared_limit<Metrics>(order, ids, instrument, std::get<I>(prepared), sink), ...);
+    }
+
+    // Check one metric's limit, from its prepared key and value if it has them
+    template<typename Metric, typename Prepared, typename Sink>
+    void check_prepared_limit(const fix::NewOrderSingle& order, const OrderIds& ids, const Instrument& instrument,
+                              const Prepared& prepared, Sink& sink) const {
+        if constexpr (has_prepare_order_v<Metric>) {
+            check_key_limit<Metric>(order, prepared.key, prepared.value, sink);
+        } else {
+            check_metric_limit<Metric>(order, ids, instrument, sink);
+        }
+    }
+
+    using BatchUsage = std::tuple<detail::BatchKeyUsage<typename Metrics::key_type>...>;
+
+    template<size_t... I>
+    void check_batch_order(const fix::NewOrderSingle& order, const OrderIds& ids, const Instrument& instrument,
+                           BatchUsage& usage, PreTradeCheckResult& result, std::index_sequence<I...>) const {
+        (check_batch_limit<Metrics>(order, ids, instrument, std::get<I>(usage), result), ...);
+        if (!result.would_breach) {
+            (std::get<I>(usage).commit(), ...);
+        }
+    }
+
+    template<typename Metric>
+    void check_batch_limit(const fix::NewOrderSingle& order, const OrderIds& ids, const Instrument& instrument,
+                           detail::BatchKeyUsage<typename Metric::key_type>& usage,
+                           PreTradeCheckResult& result) const {
+        usage.reset_pending();
+        double contribution;
+        if constexpr (is_quoted_instrument_metric<Metric>::value) {
+            // Quoted already, or by an earlier order of the batch: no new instrument
+            if (is_instrument_already_quoted(ids.symbol) || usage.is_quoted(ids.symbol)) {
+                return;
+            }
+            usage.pending_symbol = ids.symbol;
+            contribution = static_cast<double>(Metric::compute_order_contribution(order, instrument));
+        } else {
+            contribution = static_cast<double>(Metric::compute_order_contribution(order, instrument, engine_.context()));
+        }
+        check_batch_key_limit<Metric>(order, aggregation::KeyExtractor<typename Metric::key_type>::extract(ids, order.side),
+                                      contribution, usage, result);
+    }
+
+    template<typename Metric>
+    void check_batch_key_limit(const fix::NewOrderSingle& order, const typename Metric::key_type& key,
+                               double contribution, detail::BatchKeyUsage<typename Metric::key_type>& usage,
+                               PreTradeCheckResult& result) const {
+        using Key = typename Metric::key_type;
+        const auto& store = limits_.template get<Metric>();
+        size_t index = usage.find_or_add(key, [this, &key] {
+            aggregation::LimitUsage key_usage = limit_usage<Metric>(key);
+            return std::pair<double, double>{key_usage.current, key_usage.limit};
+        });
+        const auto& entry = usage.entries[index];
+        double before = entry.current + entry.accepted;
+        if (store.exceeds(before + contribution, entry.limit)) {
+            result.add_breach({
+                Metric::limit_type(),
+                detail::order_key_to_string<Key>(order),
+                entry.limit,
+                before,
+                before + contribution
+            });
+        }
+        usage.pending = index;
+        usage.pending_contribution = contribution;
+    }
+
+    template<typename T, typename = void>
+    struct scales_with_quantity : std::false_type {};
+
+    template<typename T>
+    struct scales_with_quantity<T, std::void_t<decltype(T::compute_quantity_contribution(
+        int64_t{}, fix::Side::BID, std::declval<const Instrument&>(), std::declval<const ContextType&>()))>>
+        : std::true_type {};
+
+    // Quantities [lo, hi] for which a limit holds; empty if lo > hi
+    struct QuantityRange {
+        int64_t lo = 1;
+        int64_t hi = UNLIMITED_QUANTITY;
+
+        bool empty() const { return lo > hi; }
+
+        QuantityRange intersect(const QuantityRange& other) const {
+            return {std::max(lo, other.lo), std::min(hi, other.hi)};
+        }
+    };
+
+    static constexpr QuantityRange NO_QUANTITY{1, 0};
+
+    template<typename Metric>
+    QuantityRange metric_quantity_range(const fix::NewOrderSingle& order, const OrderIds& ids,
+                                        const Instrument& instrument) const {
+        if constexpr (scales_with_quantity<Metric>::value) {
+            auto key = aggregation::KeyExtractor<typename Metric::key_type>::extract(ids, order.side);
+            aggregation::LimitUsage usage = limit_usage<Metric>(key);
+            return linear_quantity_range(limits_.template get<Metric>(), usage.current, usage.limit, [&](int64_t quantity) {
+                return static_cast<double>(
+                    Metric::compute_quantity_contribution(quantity, order.side, instrument, engine_.context()));
+            });
+        } else {
+            detail::BreachMaskSink sink;
+            check_metric_limit<Metric>(order, ids, instrument, sink);
+            return sink.mask.any() ? NO_QUANTITY : QuantityRange{};
+        }
+    }
+
+    // Whether the order for quantity stays within the metric's limit (gates
+    // are settled by metric_quantity_range)
+    template<typename Metric>
+    bool quantity_within_limit(const fix::NewOrderSingle& order, const OrderIds& ids,
+                               const Instrument& instrument, int64_t quantity) const {
+        if constexpr (scales_with_quantity<Metric>::value) {
+            auto key = aggregation::KeyExtractor<typename Metric::key_type>::extract(ids, order.side);
+            aggregation::LimitUsage usage = limit_usage<Metric>(key);
+            double contribution = static_cast<double>(
+                Metric::compute_quantity_contribution(quantity, order.side, instrument, engine_.context()));
+            return !limits_.template get<Metric>().exceeds(usage.current + contribution, usage.limit);
+        } else {
+            return true;
+        }
+    }
+
+    // Quantities q with current + contribution(q) within limit, for a
+    // contribution linear in q. Passing usage lies in [-limit, limit] under
+    // ABSOLUTE and below limit under SIGNED.
+    template<typename Store, typename Contribution>
+    static QuantityRange linear_quantity_range(const Store& store, double current, double limit,
+                                               Contribution&& contribution) {
+        double unit = contribution(1);
+        if (!(unit != 0.0)) {
+            // Usage does not move with quantity
+            return store.exceeds(current, limit) ? NO_QUANTITY : QuantityRange{};
+        }
+        double upper = limit;
+        double lower = store.comparison_mode() == LimitComparisonMode::ABSOLUTE
+                           ? -limit : -std::numeric_limits<double>::infinity();
+        double q_hi = unit > 0.0 ? (upper - current) / unit : (current - lower) / -unit;
+        double q_lo = unit > 0.0 ? (lower - current) / unit : (current - upper) / -unit;
+
+        QuantityRange range;
+        constexpr double UNLIMITED = static_cast<double>(UNLIMITED_QUANTITY);
+        if (!(q_hi >= 1.0)) return NO_QUANTITY;
+        if (q_lo >= UNLIMITED) return NO_QUANTITY;
+        range.hi = q_hi >= UNLIMITED ? UNLIMITED_QUANTITY : static_cast<int64_t>(std::floor(q_hi));
+        range.lo = q_lo > 1.0 ? static_cast<int64_t>(std::ceil(q_lo)) : 1;
+
+        // The divisions can round by an ulp; move each end to a quantity that fits
+        auto fits = [&](int64_t quantity) { return !store.exceeds(current + contribution(quantity), limit); };
+        for (int step = 0; step < 2 && range.hi != UNLIMITED_QUANTITY && !range.empty() && !fits(range.hi); ++step) {
+            --range.hi;
+        }
+        for (int step = 0; step < 2 && !range.empty() && !fits(range.lo); ++step) {
+            ++range.lo;
+        }
+        return range;
+    }
+
+    template<typename First, typename... Rest, typename Sink>
+    void check_all_limits(const fix::NewOrderSingle& order, const OrderIds& ids,
+                          const Instrument& instrument, Sink& sink) const {
+        check_metric_limit<First>(order, ids, instrument, sink);
         if constexpr (sizeof...(Rest) > 0) {
-            check_all_limits<Rest...>(order, instrument, result);
+            if (!sink.done()) {
+                check_all_limits<Rest...>(order, ids, instrument, sink);
+            }
         }
     }
 
     // Base case for empty pack
-    void check_all_limits(const fix::NewOrderSingle&, const Instrument&, PreTradeCheckResult&) const {}
+    template<typename Sink>
+    void check_all_limits(const fix::NewOrderSingle&, const OrderIds&, const Instrument&, Sink&) const {}
 
     // Recursive helper for order update limit checking
-    template<typename First, typename... Rest>
+    template<typename First, typename... Rest, typename Sink>
     void check_all_update_limits(const fix::OrderCancelReplaceRequest& update,
                                  const TrackedOrder& existing,
                                  const Instrument& instrument,
-                                 PreTradeCheckResult& result) const {
-        check_standard_update_limit<First>(update, existing, instrument, result);
+                                 Sink& sink) const {
+        check_standard_update_limit<First>(update, existing, instrument, sink);
         if constexpr (sizeof...(Rest) > 0) {
-            check_all_update_limits<Rest...>(update, existing, instrument, result);
+            if (!sink.done()) {
+                check_all_update_limits<Rest...>(update, existing, instrument, sink);
+            }
         }
     }
 
     // Base case for empty pack
+    template<typename Sink>
     void check_all_update_limits(const fix::OrderCancelReplaceRequest&,
                                  const TrackedOrder&,
                                  const Instrument&,
-                                 PreTradeCheckResult&) const {}
+                                 Sink&) const {}
 
     // Check limit for a single metric
-    template<typename Metric>
-    void check_metric_limit(const fix::NewOrderSingle& order, const Instrument& instrument, PreTradeCheckResult& result) const {
+    template<typename Metric, typename Sink>
+    void check_metric_limit(const fix::NewOrderSingle& order, const OrderIds& ids,
+                            const Instrument& instrument, Sink& sink) const {
         // Special handling for QuotedInstrumentCountMetric
         if constexpr (is_quoted_instrument_metric<Metric>::value) {
-            check_quoted_instrument_limit<Metric>(order, instrument, result);
+            check_quoted_instrument_limit<Metric>(order, ids, instrument, sink);
         } else {
-            check_standard_limit<Metric>(order, instrument, result);
+            check_standard_limit<Metric>(order, ids, instrument, sink);
         }
     }
 
     // Standard limit check for metrics with compute_order_contribution
-    template<typename Metric>
-    void check_standard_limit(const fix::NewOrderSingle& order, const Instrument& instrument, PreTradeCheckResult& result) const {
-        auto key = Metric::extract_key(order);
+    template<typename Metric, typename Sink>
+    void check_standard_limit(const fix::NewOrderSingle& order, const OrderIds& ids,
+                              const Instrument& instrument, Sink& sink) const {
+        auto key = aggregation::KeyExtractor<typename Metric::key_type>::extract(ids, order.side);
         auto contribution = Metric::compute_order_contribution(order, instrument, engine_.context());
-        auto current = static_cast<double>(engine_.template get_metric<Metric>().get(key));
+        check_key_limit<Metric>(order, key, static_cast<double>(contribution), sink);
+    }
 
+    // Current value and effective limit of a key: one probe into the metric's
+    // check table when it keeps one (see aggregation::LimitCheckTable)
+    template<typename Metric>
+    aggregation::LimitUsage limit_usage(const typename Metric::key_type& key) const {
+        const auto& metric = engine_.template get_metric<Metric>();
         const auto& store = limits_.template get<Metric>();
-        double limit = store.get_limit(key);
-        double hypothetical = current + static_cast<double>(contribution);
+        if constexpr (has_limit_usage_v<Metric>) {
+            return metric.limit_usage(key, store);
+        } else {
+            return aggregation::LimitUsage{static_cast<double>(metric.get(key)), store.get_limit(key)};
+        }
+    }
 
-        if (store.would_breach(key, current, static_cast<double>(contribution))) {
-            result.add_breach({
-                Metric::limit_type(),
-                detail::key_to_string(key),
-                limit,
-                current,
-                hypothetical
-            });
+    // Check a new order's contribution to one key against the metric's limit
+    template<typename Metric, typename Sink>
+    void check_key_limit(const fix::NewOrderSingle& order, const typename Metric::key_type& key,
+                         double contribution, Sink& sink) const {
+        using Key = typename Metric::key_type;
+        const auto& store = limits_.template get<Metric>();
+        auto usage = limit_usage<Metric>(key);
+        double hypothetical = usage.current + contribution;
+        if (store.exceeds(hypothetical, usage.limit)) {
+            sink.record(Metric::limit_type(),
+                        [&order] { return detail::order_key_to_string<Key>(order); },
+                        usage.limit,
+                        usage.current,
+                        hypothetical);
         }
     }
 
     // Standard limit check for order updates with compute_update_contribution
-    template<typename Metric>
+    template<typename Metric, typename Sink>
     void check_standard_update_limit(const fix::OrderCancelReplaceRequest& update,
                                      const TrackedOrder& existing,
                                      const Instrument& instrument,
-                                     PreTradeCheckResult& result) const {
+                                     Sink& sink) const {
         // Extract key from the existing order (not the update request)
         auto key = extract_key_from_tracked_order<Metric>(existing);
         auto contribution = Metric::compute_update_contribution(update, existing, instrument, engine_.context());
@@ -318,81 +919,48 @@ private:
             return;
         }
 
-        auto current = static_cast<double>(engine_.template get_metric<Metric>().get(key));
-
         const auto& store = limits_.template get<Metric>();
-        double limit = store.get_limit(key);
-        double hypothetical = current + static_cast<double>(contribution);
-
-        if (store.would_breach(key, current, static_cast<double>(contribution))) {
-            result.add_breach({
-                Metric::limit_type(),
-                detail::key_to_string(key),
-                limit,
-                current,
-                hypothetical
-            });
+        auto usage = limit_usage<Metric>(key);
+        double hypothetical = usage.current + static_cast<double>(contribution);
+        if (store.exceeds(hypothetical, usage.limit)) {
+            sink.record(Metric::limit_type(),
+                        [&key] { return detail::key_to_string(key); },
+                        usage.limit,
+                        usage.current,
+                        hypothetical);
         }
     }
 
     // Helper to extract metric key from a TrackedOrder
     template<typename Metric>
     typename Metric::key_type extract_key_from_tracked_order(const TrackedOrder& order) const {
-        using Key = typename Metric::key_type;
-        if constexpr (std::is_same_v<Key, aggregation::GlobalKey>) {
-            return aggregation::GlobalKey::instance();
-        } else if constexpr (std::is_same_v<Key, aggregation::UnderlyerKey>) {
-            return Key{order.underlyer};
-        } else if constexpr (std::is_same_v<Key, aggregation::InstrumentKey>) {
-            return Key{order.symbol};
-        } else if constexpr (std::is_same_v<Key, aggregation::InstrumentSideKey>) {
-            return Key{order.symbol, static_cast<int>(order.side)};
-        } else if constexpr (std::is_same_v<Key, aggregation::StrategyKey>) {
-            return Key{order.strategy_id};
-        } else if constexpr (std::is_same_v<Key, aggregation::PortfolioKey>) {
-            return Key{order.portfolio_id};
-        } else {
-            static_assert(sizeof(Key) == 0, "Unsupported key type");
-        }
+        return aggregation::KeyExtractor<typename Metric::key_type>::extract(order);
     }
 
     // Special limit check for QuotedInstrumentCountMetric
-    template<typename Metric>
-    void check_quoted_instrument_limit(const fix::NewOrderSingle& order, const Instrument& instrument, PreTradeCheckResult& result) const {
+    template<typename Metric, typename Sink>
+    void check_quoted_instrument_limit(const fix::NewOrderSingle& order, const OrderIds& ids,
+                                       const Instrument& instrument, Sink& sink) const {
         // Check if instrument already has orders - if so, won't increase quoted count
-        if (is_instrument_already_quoted(order.symbol)) {
+        if (is_instrument_already_quoted(ids.symbol)) {
             return;
         }
 
-        auto key = Metric::extract_key(order);
+        auto key = aggregation::KeyExtractor<typename Metric::key_type>::extract(ids, order.side);
         auto contribution = Metric::compute_order_contribution(order, instrument);
-        auto current = static_cast<double>(engine_.template get_metric<Metric>().get(key));
-
-        const auto& store = limits_.template get<Metric>();
-        double limit = store.get_limit(key);
-        double hypothetical = current + static_cast<double>(contribution);
-
-        if (store.would_breach(key, current, static_cast<double>(contribution))) {
-            result.add_breach({
-                Metric::limit_type(),
-                detail::key_to_string(key),
-                limit,
-                current,
-                hypothetical
-            });
-        }
+        check_key_limit<Metric>(order, key, static_cast<double>(contribution), sink);
     }
 
     // Check if instrument is already quoted by checking order counts
-    bool is_instrument_already_quoted(const std::string& symbol) const {
+    bool is_instrument_already_quoted(aggregation::InternedId symbol) const {
         return is_instrument_quoted_impl<Metrics...>(symbol);
     }
 
     template<typename First, typename... Rest>
-    bool is_instrument_quoted_impl(const std::string& symbol) const {
+    bool is_instrument_quoted_impl(aggregation::InternedId symbol) const {
         if constexpr (std::is_same_v<typename First::key_type, aggregation::InstrumentSideKey>) {
-            aggregation::InstrumentSideKey bid_key{symbol, static_cast<int>(fix::Side::BID)};
-            aggregation::InstrumentSideKey ask_key{symbol, static_cast<int>(fix::Side::ASK)};
+            auto bid_key = aggregation::InstrumentSideKey::from_id(symbol, static_cast<int>(fix::Side::BID));
+            auto ask_key = aggregation::InstrumentSideKey::from_id(symbol, static_cast<int>(fix::Side::ASK));
             auto count = engine_.template get_metric<First>().get(bid_key) +
                         engine_.template get_metric<First>().get(ask_key);
             if (count > 0) return true;
@@ -403,7 +971,7 @@ private:
         return false;
     }
 
-    bool is_instrument_quoted_impl(const std::string&) const {
+    bool is_instrument_quoted_impl(aggregation::InternedId) const {
         return false;
     }
 };
@@ -417,12 +985,21 @@ class RiskAggregationEngineWithLimits<ContextType, void, Metrics...> {
 private:
     GenericRiskAggregationEngine<ContextType, void, Metrics...> engine_;
     MetricLimitStores<Metrics...> limits_;
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    // Pre-trade checks are const; lifecycle handlers are counted by engine_
+    mutable aggregation::HandlerAllocationStats pre_trade_allocation_stats_;
+#endif
 
 public:
     using instrument_type = void;
     using context_type = ContextType;
 
-    RiskAggregationEngineWithLimits() = default;
+    explicit RiskAggregationEngineWithLimits(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : engine_(resource), limits_(resource) {}
+
+    explicit RiskAggregationEngineWithLimits(const aggregation::CapacityHints& capacity,
+                                             aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : engine_(capacity, resource), limits_(resource) {}
 
     // ========================================================================
     // Forwarding to underlying engine
@@ -432,29 +1009,47 @@ public:
     const GenericRiskAggregationEngine<ContextType, void, Metrics...>& engine() const { return engine_; }
 
     // Forward all message handlers - no instrument needed
-    void on_new_order_single(const fix::NewOrderSingle& msg) {
-        engine_.on_new_order_single(msg);
+    OrderHandle on_new_order_single(const fix::NewOrderSingle& msg) {
+        return engine_.on_new_order_single(msg);
     }
 
     void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg) {
         engine_.on_order_cancel_replace(msg);
     }
 
+    void on_order_cancel_replace(const fix::OrderCancelReplaceRequest& msg, OrderHandle handle) {
+        engine_.on_order_cancel_replace(msg, handle);
+    }
+
     void on_order_cancel_request(const fix::OrderCancelRequest& msg) {
         engine_.on_order_cancel_request(msg);
     }
 
+    void on_order_cancel_request(const fix::OrderCancelRequest& msg, OrderHandle handle) {
+        engine_.on_order_cancel_request(msg, handle);
+    }
+
     void on_execution_report(const fix::ExecutionReport& msg) {
         engine_.on_execution_report(msg);
     }
 
+    void on_execution_report(const fix::ExecutionReport& msg, OrderHandle handle) {
+        engine_.on_execution_report(msg, handle);
+    }
+
     void on_order_cancel_reject(const fix::OrderCancelReject& msg) {
         engine_.on_order_cancel_reject(msg);
     }
 
+    void on_order_cancel_reject(const fix::OrderCancelReject& msg, OrderHandle handle) {
+        engine_.on_order_cancel_reject(msg, handle);
+    }
+
     // Forward order book access
     const OrderBook& order_book() const { return engine_.order_book(); }
     size_t active_order_count() const { return engine_.active_order_count(); }
+    void set_terminal_order_retention(size_t orders) { engine_.set_terminal_order_retention(orders); }
+    void cleanup_terminal_orders() { engine_.cleanup_terminal_orders(); }
 
     void clear() {
         engine_.clear();
@@ -465,6 +1060,23 @@ public:
         limits_.reset();
     }
 
+    void reserve(const aggregation::CapacityHints& capacity) {
+        engine_.reserve(capacity);
+    }
+
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+    aggregation::HandlerAllocationStats allocation_stats() const {
+        aggregation::HandlerAllocationStats stats = engine_.allocation_stats();
+        stats.merge(pre_trade_allocation_stats_);
+        return stats;
+    }
+
+    void reset_allocation_stats() {
+        engine_.reset_allocation_stats();
+        pre_trade_allocation_stats_.reset();
+    }
+#endif
+
     // ========================================================================
     // Position management
     // ========================================================================
@@ -526,58 +1138,153 @@ public:
     // ========================================================================
 
     PreTradeCheckResult pre_trade_check(const fix::NewOrderSingle& order) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
         PreTradeCheckResult result;
-        check_all_limits<Metrics...>(order, result);
+        detail::BreachDetailSink sink{result};
+        // Resolve the order's identifiers once; every metric builds its key from them
+        const OrderIds ids = find_order_ids(order);
+        check_all_limits<Metrics...>(order, ids, sink);
         return result;
     }
 
     // Pre-trade check for order updates
     PreTradeCheckResult pre_trade_check(const fix::OrderCancelReplaceRequest& update) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
         PreTradeCheckResult result;
         auto* existing = engine_.order_book().get_order(update.orig_key);
         if (!existing) {
             return result;
         }
-        check_update_limits<Metrics...>(update, *existing, result);
+        detail::BreachDetailSink sink{result};
+        check_update_limits<Metrics...>(update, *existing, sink);
         return result;
     }
 
+    // Fast path: no heap allocation and no breach details (see the primary template)
+    bool would_pass(const fix::NewOrderSingle& order) const {
+        return check_mask(order, true).none();
+    }
+
+    bool would_pass(const fix::OrderCancelReplaceRequest& update) const {
+        return check_mask(update, true).none();
+    }
+
+    LimitTypeMask breached_limits(const fix::NewOrderSingle& order) const {
+        return check_mask(order, false);
+    }
+
+    LimitTypeMask breached_limits(const fix::OrderCancelReplaceRequest& update) const {
+        return check_mask(update, false);
+    }
+
+    // Check-and-add in one call (see the primary template); identifiers are
+    // interned only if the order passes
+    SubmitResult try_submit(const fix::NewOrderSingle& order) {
+        SubmitResult submit;
+        OrderIds ids = find_order_ids(order);
+        check_resolved(order, ids, submit.check);
+        if (!submit.check.would_breach) {
+            if (!ids.all_resolved()) {
+                ids = intern_order_ids(order);
+            }
+            submit.handle = engine_.on_new_order_single(order, ids);
+        }
+        return submit;
+    }
+
+    // Largest quantity that would pass every limit (see the primary
+    // template); count metrics are gates, so this is all or nothing
+    int64_t max_permissible_quantity(const fix::NewOrderSingle& order) const {
+        return would_pass(order) ? UNLIMITED_QUANTITY : 0;
+    }
+
+    // Batch pre-trade check with intra-batch accumulation (see the primary template)
+    BatchPreTradeCheckResult pre_trade_check_batch(const std::vector<fix::NewOrderSingle>& orders) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        BatchPreTradeCheckResult batch;
+        batch.orders.resize(orders.size());
+        BatchUsage usage;
+        detail::BatchOrderIds batch_ids;
+        for (size_t i = 0; i < orders.size(); ++i) {
+            check_batch_order(orders[i], batch_ids.resolve(orders[i]), usage, batch.orders[i],
+                              std::index_sequence_for<Metrics...>{});
+            if (!batch.orders[i].would_breach) {
+                ++batch.passed;
+            }
+        }
+        return batch;
+    }
+
 private:
-    template<typename First, typename... Rest>
+    void check_resolved(const fix::NewOrderSingle& order, const OrderIds& ids, PreTradeCheckResult& result) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        detail::BreachDetailSink sink{result};
+        check_all_limits<Metrics...>(order, ids, sink);
+    }
+
+    LimitTypeMask check_mask(const fix::NewOrderSingle& order, bool stop_at_first) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        detail::BreachMaskSink sink;
+        sink.stop_at_first = stop_at_first;
+        check_all_limits<Metrics...>(order, find_order_ids(order), sink);
+        return sink.mask;
+    }
+
+    LimitTypeMask check_mask(const fix::OrderCancelReplaceRequest& update, bool stop_at_first) const {
+        AGGREGATION_COUNT_HANDLER_ALLOCATIONS(pre_trade_allocation_stats_, PRE_TRADE_CHECK);
+        detail::BreachMaskSink sink;
+        sink.stop_at_first = stop_at_first;
+        if (const TrackedOrder* existing = engine_.order_book().get_order(update.orig_key)) {
+            check_update_limits<Metrics...>(update, *existing, sink);
+        }
+        return sink.mask;
+    }
+
+    template<typename First, typename... Rest, typename Sink>
     void check_update_limits(const fix::OrderCancelReplaceRequest& update,
                              const TrackedOrder& existing,
-                             PreTradeCheckResult& result) const {
-        check_update_metric_limit<First>(update, existing, result);
+                             Sink& sink) const {
+        check_update_metric_limit<First>(update, existing, sink);
         if constexpr (sizeof...(Rest) > 0) {
-            check_update_limits<Rest...>(update, existing, result);
+            if (!sink.done()) {
+                check_update_limits<Rest...>(update, existing, sink);
+            }
         }
     }
 
+    template<typename Sink>
     void check_update_limits(const fix::OrderCancelReplaceRequest&,
                              const TrackedOrder&,
-                             PreTradeCheckResult&) const {}
+                             Sink&) const {}
 
+    // See the primary template
     template<typename Metric>
+    aggregation::LimitUsage limit_usage(const typename Metric::key_type& key) const {
+        const auto& metric = engine_.template get_metric<Metric>();
+        const auto& store = limits_.template get<Metric>();
+        if constexpr (has_limit_usage_v<Metric>) {
+            return metric.limit_usage(key, store);
+        } else {
+            return aggregation::LimitUsage{static_cast<double>(metric.get(key)), store.get_limit(key)};
+        }
+    }
+
+    template<typename Metric, typename Sink>
     void check_update_metric_limit(const fix::OrderCancelReplaceRequest& update,
                                    const TrackedOrder& existing,
-                                   PreTradeCheckResult& result) const {
+                                   Sink& sink) const {
         // Extract key from existing order, not update request
         auto key = aggregation::KeyExtractor<typename Metric::key_type>::extract(existing);
         auto contribution = Metric::compute_update_contribution(update, existing);
-        auto current = static_cast<double>(engine_.template get_metric<Metric>().get(key));
-
         const auto& store = limits_.template get<Metric>();
-        double limit = store.get_limit(key);
-        double hypothetical = current + static_cast<double>(contribution);
-
-        if (store.would_breach(key, current, static_cast<double>(contribution))) {
-            LimitBreachInfo breach;
-            breach.type = Metric::limit_type();
-            breach.key = detail::key_to_string(key);
-            breach.limit_value = limit;
-            breach.current_usage = current;
-            breach.hypothetical_usage = hypothetical;
-            result.add_breach(breach);
+        auto usage = limit_usage<Metric>(key);
+        double hypothetical = usage.current + static_cast<double>(contribution);
+        if (store.exceeds(hypothetical, usage.limit)) {
+            sink.record(Metric::limit_type(),
+                        [&key] { return detail::key_to_string(key); },
+                        usage.limit,
+                        usage.current,
+                        hypothetical);
         }
     }
 
@@ -588,80 +1295,121 @@ private:
     template<typename... Stages>
     struct is_quoted_instrument_metric<metrics::QuotedInstrumentCountMetric<Stages...>> : std::true_type {};
 
-    template<typename First, typename... Rest>
-    void check_all_limits(const fix::NewOrderSingle& order, PreTradeCheckResult& result) const {
-        check_metric_limit<First>(order, result);
+    using BatchUsage = std::tuple<detail::BatchKeyUsage<typename Metrics::key_type>...>;
+
+    template<size_t... I>
+    void check_batch_order(const fix::NewOrderSingle& order, const OrderIds& ids, BatchUsage& usage,
+                           PreTradeCheckResult& result, std::index_sequence<I...>) const {
+        (check_batch_limit<Metrics>(order, ids, std::get<I>(usage), result), ...);
+        if (!result.would_breach) {
+            (std::get<I>(usage).commit(), ...);
+        }
+    }
+
+    template<typename Metric>
+    void check_batch_limit(const fix::NewOrderSingle& order, const OrderIds& ids,
+                           detail::BatchKeyUsage<typename Metric::key_type>& usage,
+                           PreTradeCheckResult& result) const {
+        using Key = typename Metric::key_type;
+        usage.reset_pending();
+        if constexpr (is_quoted_instrument_metric<Metric>::value) {
+            if (is_instrument_already_quoted(ids.symbol) || usage.is_quoted(ids.symbol)) {
+                return;
+            }
+            usage.pending_symbol = ids.symbol;
+        }
+        auto contribution = static_cast<double>(Metric::compute_order_contribution(order));
+        auto key = aggregation::KeyExtractor<Key>::extract(ids, order.side);
+
+        const auto& store = limits_.template get<Metric>();
+        size_t index = usage.find_or_add(key, [this, &key] {
+            aggregation::LimitUsage key_usage = limit_usage<Metric>(key);
+            return std::pair<double, double>{key_usage.current, key_usage.limit};
+        });
+        const auto& entry = usage.entries[index];
+        double before = entry.current + entry.accepted;
+        if (store.exceeds(before + contribution, entry.limit)) {
+            result.add_breach({
+                Metric::limit_type(),
+                detail::order_key_to_string<Key>(order),
+                entry.limit,
+                before,
+                before + contribution
+            });
+        }
+        usage.pending = index;
+        usage.pending_contribution = contribution;
+    }
+
+    template<typename First, typename... Rest, typename Sink>
+    void check_all_limits(const fix::NewOrderSingle& order, const OrderIds& ids, Sink& sink) const {
+        check_metric_limit<First>(order, ids, sink);
         if constexpr (sizeof...(Rest) > 0) {
-            check_all_limits<Rest...>(order, result);
+            if (!sink.done()) {
+                check_all_limits<Rest...>(order, ids, sink);
+            }
         }
     }
 
-    void check_all_limits(const fix::NewOrderSingle&, PreTradeCheckResult&) const {}
+    template<typename Sink>
+    void check_all_limits(const fix::NewOrderSingle&, const OrderIds&, Sink&) const {}
 
-    template<typename Metric>
-    void check_metric_limit(const fix::NewOrderSingle& order, PreTradeCheckResult& result) const {
+    template<typename Metric, typename Sink>
+    void check_metric_limit(const fix::NewOrderSingle& order, const OrderIds& ids, Sink& sink) const {
         if constexpr (is_quoted_instrument_metric<Metric>::value) {
-            check_quoted_instrument_limit<Metric>(order, result);
+            check_quoted_instrument_limit<Metric>(order, ids, sink);
         } else {
-            check_standard_limit<Metric>(order, result);
+            check_standard_limit<Metric>(order, ids, sink);
         }
     }
 
-    template<typename Metric>
-    void check_standard_limit(const fix::NewOrderSingle& order, PreTradeCheckResult& result) const {
-        auto key = Metric::extract_key(order);
+    template<typename Metric, typename Sink>
+    void check_standard_limit(const fix::NewOrderSingle& order, const OrderIds& ids, Sink& sink) const {
+        using Key = typename Metric::key_type;
+        auto key = aggregation::KeyExtractor<Key>::extract(ids, order.side);
         auto contribution = Metric::compute_order_contribution(order);
-        auto current = static_cast<double>(engine_.template get_metric<Metric>().get(key));
-
         const auto& store = limits_.template get<Metric>();
-        double limit = store.get_limit(key);
-        double hypothetical = current + static_cast<double>(contribution);
-
-        if (store.would_breach(key, current, static_cast<double>(contribution))) {
-            result.add_breach({
-                Metric::limit_type(),
-                detail::key_to_string(key),
-                limit,
-                current,
-                hypothetical
-            });
+        auto usage = limit_usage<Metric>(key);
+        double hypothetical = usage.current + static_cast<double>(contribution);
+        if (store.exceeds(hypothetical, usage.limit)) {
+            sink.record(Metric::limit_type(),
+                        [&order] { return detail::order_key_to_string<Key>(order); },
+                        usage.limit,
+                        usage.current,
+                        hypothetical);
         }
     }
 
-    template<typename Metric>
-    void check_quoted_instrument_limit(const fix::NewOrderSingle& order, PreTradeCheckResult& result) const {
-        if (is_instrument_already_quoted(order.symbol)) {
+    template<typename Metric, typename Sink>
+    void check_quoted_instrument_limit(const fix::NewOrderSingle& order, const OrderIds& ids, Sink& sink) const {
+        if (is_instrument_already_quoted(ids.symbol)) {
             return;
         }
 
-        auto key = Metric::extract_key(order);
+        using Key = typename Metric::key_type;
+        auto key = aggregation::KeyExtractor<Key>::extract(ids, order.side);
         auto contribution = Metric::compute_order_contribution(order);
-        auto current = static_cast<double>(engine_.template get_metric<Metric>().get(key));
-
         const auto& store = limits_.template get<Metric>();
-        double limit = store.get_limit(key);
-        double hypothetical = current + static_cast<double>(contribution);
-
-        if (store.would_breach(key, current, static_cast<double>(contribution))) {
-            result.add_breach({
-                Metric::limit_type(),
-                detail::key_to_string(key),
-                limit,
-                current,
-                hypothetical
-            });
+        auto usage = limit_usage<Metric>(key);
+        double hypothetical = usage.current + static_cast<double>(contribution);
+        if (store.exceeds(hypothetical, usage.limit)) {
+            sink.record(Metric::limit_type(),
+                        [&order] { return detail::order_key_to_string<Key>(order); },
+                        usage.limit,
+                        usage.current,
+                        hypothetical);
         }
     }
 
-    bool is_instrument_already_quoted(const std::string& symbol) const {
+    bool is_instrument_already_quoted(aggregation::InternedId symbol) const {
         return is_instrument_quoted_impl<Metrics...>(symbol);
     }
 
     template<typename First, typename... Rest>
-    bool is_instrument_quoted_impl(const std::string& symbol) const {
+    bool is_instrument_quoted_impl(aggregation::InternedId symbol) const {
         if constexpr (std::is_same_v<typename First::key_type, aggregation::InstrumentSideKey>) {
-            aggregation::InstrumentSideKey bid_key{symbol, static_cast<int>(fix::Side::BID)};
-            aggregation::InstrumentSideKey ask_key{symbol, static_cast<int>(fix::Side::ASK)};
+            auto bid_key = aggregation::InstrumentSideKey::from_id(symbol, static_cast<int>(fix::Side::BID));
+            auto ask_key = aggregation::InstrumentSideKey::from_id(symbol, static_cast<int>(fix::Side::ASK));
             auto count = engine_.template get_metric<First>().get(bid_key) +
                         engine_.template get_metric<First>().get(ask_key);
             if (count > 0) return true;
@@ -672,7 +1420,7 @@ private:
         return false;
     }
 
-    bool is_instrument_quoted_impl(const std::string&) const {
+    bool is_instrument_quoted_impl(aggregation::InternedId) const {
         return false;
     }
 };
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace fix {
+
+// ============================================================================
+// ClOrdId - Compact client order ID (tag 11 / 41)
+// ============================================================================
+//
+// Small-string representation tuned for order keys:
+// - IDs up to INLINE_CAPACITY bytes are stored inline (no heap allocation);
+//   longer IDs fall back to a heap buffer
+// - The hash is computed once at construction, so map lookups never rehash
+//   the characters
+// - Equality compares hash and length first, then the bytes
+//
+// Numeric IDs have a packed 64-bit form: an ID that is a canonical decimal
+// number (no sign, no leading zeros, fits in 64 bits) is tagged numeric and
+// keeps the number itself in place of the byte hash, so it is hashed and
+// compared as one integer. ClOrdId(uint64_t) builds one directly; text that
+// spells a canonical number is recognized at construction, so ClOrdId(42)
+// and ClOrdId("42") are the same key. The decimal digits are still kept
+// inline for view() and printing.
+//
+// Implicitly constructible from std::string, std::string_view and const char*
+// so existing code such as `key.cl_ord_id = "ORD001"` keeps working.
+//
+
+namespace detail {
+
+inline uint64_t load_word(const char* p, size_t n) {
+    uint64_t w = 0;
+    std::memcpy(&w, p, n);
+    return w;
+}
+
+// Word-at-a-time hash over the ID bytes
+inline uint64_t hash_cl_ord_id(const char* data, size_t size) {
+    constexpr uint64_t K = 0x9e3779b97f4a7c15ULL;
+    uint64_t h = static_cast<uint64_t>(size) * K;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        h = (h ^ load_word(data + i, 8)) * K;
+        h ^= h >> 29;
+    }
+    if (i < size) {
+        h = (h ^ load_word(data + i, size - i)) * K;
+    }
+    h ^= h >> 32;
+    h *= 0xd6e8feb86659fd93ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace detail
+
+class ClOrdId {
+public:
+    static constexpr size_t INLINE_CAPACITY = 23;
+
+    ClOrdId() noexcept {
+        inline_[0] = '\0';
+        hash_ = detail::hash_cl_ord_id(inline_, 0);
+    }
+
+    ClOrdId(std::string_view id) {
+        assign(id.data(), id.size());
+    }
+
+    ClOrdId(const std::string& id) {
+        assign(id.data(), id.size());
+    }
+
+    ClOrdId(const char* id) {
+        assign(id, std::strlen(id));
+    }
+
+    // Packed numeric form
+    explicit ClOrdId(uint64_t number) {
+        char digits[MAX_NUMERIC_DIGITS];
+        size_t n = 0;
+        uint64_t rest = number;
+        do {
+            digits[n++] = static_cast<char>('0' + rest % 10);
+            rest /= 10;
+        } while (rest != 0);
+        for (size_t i = 0; i < n; ++i) {
+            inline_[i] = digits[n - 1 - i];
+        }
+        inline_[n] = '\0';
+        size_ = static_cast<uint32_t>(n);
+        numeric_ = true;
+        hash_ = number;
+    }
+
+    ClOrdId(const ClOrdId& other) {
+        assign(other.data(), other.size_, other.hash_, other.numeric_);
+    }
+
+    ClOrdId(ClOrdId&& other) noexcept {
+        steal(other);
+    }
+
+    // Copies first, so a failed allocation leaves this ID unchanged
+    ClOrdId& operator=(const ClOrdId& other) {
+        if (this != &other) {
+            ClOrdId copy(other);
+            release();
+            steal(copy);
+        }
+        return *this;
+    }
+
+    ClOrdId& operator=(ClOrdId&& other) noexcept {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~ClOrdId() {
+        release();
+    }
+
+    // ========================================================================
+    // Accessors
+    // ========================================================================
+
+    const char* data() const { return is_heap() ? heap_ : inline_; }
+    const char* c_str() const { return data(); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    bool is_inline() const { return !is_heap(); }
+
+    // Precomputed hash of the ID bytes; the number itself for numeric IDs
+    size_t hash() const { return static_cast<size_t>(hash_); }
+
+    // True for the packed numeric form
+    bool is_numeric() const { return numeric_; }
+
+    std::string_view view() const { return std::string_view(data(), size_); }
+    std::string str() const { return std::string(data(), size_); }
+
+    // The number, if the ID is in packed numeric form
+    std::optional<uint64_t> numeric_value() const {
+        if (!numeric_) return std::nullopt;
+        return hash_;
+    }
+
+    // Numeric IDs compare as integers; the tag keeps a number from matching
+    // text whose byte hash happens to equal it
+    bool operator==(const ClOrdId& other) const {
+        if (hash_ != other.hash_ || numeric_ != other.numeric_) return false;
+        return numeric_ ||
+               (size_ == other.size_ && std::memcmp(data(), other.data(), size_) == 0);
+    }
+
+    bool operator!=(const ClOrdId& other) const {
+        return !(*this == other);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const ClOrdId& id) {
+        return os << id.view();
+    }
+
+private:
+    static constexpr size_t MAX_NUMERIC_DIGITS = 20;
+
+    uint64_t hash_;           // Byte hash, or the number when numeric_
+    uint32_t size_ = 0;
+    bool numeric_ = false;
+    union {
+        char inline_[INLINE_CAPACITY + 1];
+        char* heap_;
+    };
+
+    bool is_heap() const { return size_ > INLINE_CAPACITY; }
+
+    // Parse a canonical decimal number; false for anything else
+    static bool parse_numeric(const char* src, size_t n, uint64_t& value) {
+        if (n == 0 || n > MAX_NUMERIC_DIGITS || (n > 1 && src[0] == '0')) {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < n; ++i) {
+            char c = src[i];
+            if (c < '0' || c > '9') return false;
+            uint64_t digit = static_cast<uint64_t>(c - '0');
+            if (value > (UINT64_MAX - digit) / 10) return false;
+            value = value * 10 + digit;
+        }
+        return true;
+    }
+
+    void assign(const char* src, size_t n) {
+        uint64_t number = 0;
+        if (parse_numeric(src, n, number)) {
+            assign(src, n, number, true);
+        } else {
+            assign(src, n, detail::hash_cl_ord_id(src, n), false);
+        }
+    }
+
+    // Allocates before setting any field, so if new throws the ID is
+    // never left claiming a heap buffer it does not own
+    void assign(const char* src, size_t n, uint64_t hash, bool numeric) {
+        char* dst = inline_;
+        if (n > INLINE_CAPACITY) {
+            dst = new char[n + 1];
+            heap_ = dst;
+        }
+        size_ = static_cast<uint32_t>(n);
+        hash_ = hash;
+        numeric_ = numeric;
+        if (n > 0) {
+            std::memcpy(dst, src, n);
+        }
+        dst[n] = '\0';
+    }
+
+    // Take over other's contents, leaving it empty
+    void steal(ClOrdId& other) noexcept {
+        hash_ = other.hash_;
+        size_ = other.size_;
+        numeric_ = other.numeric_;
+        if (other.is_heap()) {
+            heap_ = other.heap_;
+        } else {
+            std::memcpy(inline_, other.inline_, size_ + 1);
+        }
+        other.size_ = 0;
+        other.numeric_ = false;
+        other.inline_[0] = '\0';
+        other.hash_ = detail::hash_cl_ord_id(other.inline_, 0);
+    }
+
+    void release() {
+        if (is_heap()) {
+            delete[] heap_;
+        }
+    }
+};
+
+} // namespace fix
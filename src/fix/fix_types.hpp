@@ -1,5 +1,6 @@
 #pragma once
 
+#include "cl_ord_id.hpp"
 #include <cstdint>
 #include <string>
 #include <string_view>
@@ -104,7 +105,7 @@ enum class CxlRejResponseTo : uint8_t {
 
 // Order key for tracking
 struct OrderKey {
-    std::string cl_ord_id;
+    ClOrdId cl_ord_id;
 
     bool operator==(const OrderKey& other) const {
         return cl_ord_id == other.cl_ord_id;
@@ -117,12 +118,19 @@ struct OrderKey {
 
 } // namespace fix
 
-// Hash specialization for OrderKey
+// Hash specializations for ClOrdId and OrderKey (precomputed, no rehashing)
 namespace std {
+    template<>
+    struct hash<fix::ClOrdId> {
+        size_t operator()(const fix::ClOrdId& id) const {
+            return id.hash();
+        }
+    };
+
     template<>
     struct hash<fix::OrderKey> {
         size_t operator()(const fix::OrderKey& key) const {
-            return hash<string>{}(key.cl_ord_id);
+            return key.cl_ord_id.hash();
         }
     };
 }
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+// GCC 12's AVX-512 intrinsics seed results with _mm512_undefined_pd(),
+// which -Wuninitialized reports wherever they are inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+#endif
+
+namespace instrument {
+
+// ============================================================================
+// Black-Scholes greeks - Batch delta and vega over column arrays
+// ============================================================================
+//
+// compute_black_scholes() evaluates delta and vega for a batch of European
+// options given as columns (one array per input). The kernel is written
+// once against a small set of lane operations and instantiated for:
+//   - AVX-512F: 8 options per step (when built with -mavx512f)
+//   - AVX2:     4 options per step (when built with -mavx2, plus -mfma)
+//   - scalar:   the remainder of a batch, and everything otherwise
+// The widest instruction set enabled at compile time is used; there is no
+// runtime dispatch.
+//
+// exp and log are evaluated with branch-free polynomials (accurate to a
+// few ulp), and the normal CDF with Abramowitz & Stegun 26.2.17 (absolute
+// error below 1e-7), identically in every lane width.
+//
+// Conventions match the Context accessors: delta per unit of underlyer,
+// and vega per unit of volatility relative to the underlyer spot, so that
+// quantity * vega * contract_size * underlyer_spot * fx_rate (see
+// compute_vega_exposure) is the money vega.
+//
+
+// Inputs and outputs of one batch; every array holds count elements
+struct BlackScholesBatch {
+    const double* spot = nullptr;            // Underlyer spot
+    const double* strike = nullptr;          // > 0
+    const double* expiry = nullptr;          // Years to expiry; <= 0 means expired
+    const double* volatility = nullptr;      // Annualized, > 0
+    const double* rate = nullptr;            // Continuously compounded
+    const double* dividend_yield = nullptr;  // Continuously compounded
+    const double* put = nullptr;             // 1.0 for puts, 0.0 for calls
+    double* delta = nullptr;
+    double* vega = nullptr;
+    size_t count = 0;
+};
+
+namespace simd {
+
+// Constants shared by every lane width
+struct BlackScholesConstants {
+    static constexpr double LOG2E = 1.4426950408889634074;
+    static constexpr double LN2_HI = 6.93147180369123816490e-01;
+    static constexpr double LN2_LO = 1.90821492927058770002e-10;
+    static constexpr double SQRT2 = 1.41421356237309504880;
+    static constexpr double INV_SQRT_2PI = 0.39894228040143267794;
+    static constexpr double EXP_MAX = 708.0;
+    static constexpr double TWO_52 = 4503599627370496.0;
+    static constexpr double MIN_STDDEV = 1e-12;  // Floors vol * sqrt(T) for expired options
+
+    // log(1 + f) = f - hfsq + s * (hfsq + R(s^2)), s = f / (2 + f) (fdlibm)
+    static constexpr double LG1 = 6.666666666666735130e-01;
+    static constexpr double LG2 = 3.999999999940941908e-01;
+    static constexpr double LG3 = 2.857142874366239149e-01;
+    static constexpr double LG4 = 2.222219843214978396e-01;
+    static constexpr double LG5 = 1.818357216161805012e-01;
+    static constexpr double LG6 = 1.531383769920937332e-01;
+    static constexpr double LG7 = 1.479819860511658591e-01;
+
+    // 1 - N(x) = pdf(x) * t * P(t), t = 1 / (1 + CDF_P * x), x >= 0
+    static constexpr double CDF_P = 0.2316419;
+    static constexpr double CDF_B1 = 0.319381530;
+    static constexpr double CDF_B2 = -0.356563782;
+    static constexpr double CDF_B3 = 1.781477937;
+    static constexpr double CDF_B4 = -1.821255978;
+    static constexpr double CDF_B5 = 1.330274429;
+};
+
+// ----------------------------------------------------------------------------
+// Lane operations
+// ----------------------------------------------------------------------------
+//
+// Each provides V (a vector of WIDTH doubles), Mask, and element-wise
+// arithmetic, comparison and select, plus:
+//   round(x)     nearest integer
+//   pow2(n)      2^n for integral n in [-1022, 1023]
+//   exponent(x)  unbiased binary exponent of a positive normal x
+//   mantissa(x)  x scaled into [1, 2)
+//
+
+struct ScalarLanes {
+    using V = double;
+    using Mask = bool;
+    static constexpr size_t WIDTH = 1;
+
+    static V load(const double* p) { return *p; }
+    static void store(double* p, V v) { *p = v; }
+    static V set1(double x) { return x; }
+    static V add(V a, V b) { return a + b; }
+    static V sub(V a, V b) { return a - b; }
+    static V mul(V a, V b) { return a * b; }
+    static V div(V a, V b) { return a / b; }
+    static V fmadd(V a, V b, V c) { return a * b + c; }
+    static V sqrt(V a) { return std::sqrt(a); }
+    static V min(V a, V b) { return a < b ? a : b; }
+    static V max(V a, V b) { return a > b ? a : b; }
+    static V abs(V a) { return std::fabs(a); }
+    static Mask ge(V a, V b) { return a >= b; }
+    static Mask gt(V a, V b) { return a > b; }
+    static V select(Mask m, V a, V b) { return m ? a : b; }
+    static V round(V x) { return std::nearbyint(x); }
+
+    static V pow2(V n) {
+        double biased = n + (BlackScholesConstants::TWO_52 + 1023.0);
+        uint64_t bits;
+        std::memcpy(&bits, &biased, sizeof(bits));
+        bits <<= 52;
+        double result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+    static V exponent(V x) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        return static_cast<double>(static_cast<int>(bits >> 52) - 1023);
+    }
+
+    static V mantissa(V x) {
+        uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+        double result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+};
+
+#if defined(__AVX2__)
+struct Avx2Lanes {
+    using V = __m256d;
+    using Mask = __m256d;
+    static constexpr size_t WIDTH = 4;
+
+    static V load(const double* p) { return _mm256_loadu_pd(p); }
+    static void store(double* p, V v) { _mm256_storeu_pd(p, v); }
+    static V set1(double x) { return _mm256_set1_pd(x); }
+    static V add(V a, V b) { return _mm256_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm256_div_pd(a, b); }
+#if defined(__FMA__)
+    static V fmadd(V a, V b, V c) { return _mm256_fmadd_pd(a, b, c); }
+#else
+    static V fmadd(V a, V b, V c) { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+#endif
+    static V sqrt(V a) { return _mm256_sqrt_pd(a); }
+    static V min(V a, V b) { return _mm256_min_pd(a, b); }
+    static V max(V a, V b) { return _mm256_max_pd(a, b); }
+    static V abs(V a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    static Mask ge(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+    static Mask gt(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static V select(Mask m, V a, V b) { return _mm256_blendv_pd(b, a, m); }
+    static V round(V x) { return _mm256_round_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+
+    static V pow2(V n) {
+        __m256i biased = _mm256_castpd_si256(_mm256_add_pd(n, _mm256_set1_pd(BlackScholesConstants::TWO_52 + 1023.0)));
+        return _mm256_castsi256_pd(_mm256_slli_epi64(biased, 52));
+    }
+
+    static V exponent(V x) {
+        // Biased exponent as a double: OR it into the mantissa of 2^52
+        __m256i biased = _mm256_srli_epi64(_mm256_castpd_si256(x), 52);
+        V as_double = _mm256_castsi256_pd(_mm256_or_si256(biased, _mm256_castpd_si256(_mm256_set1_pd(BlackScholesConstants::TWO_52))));
+        return _mm256_sub_pd(as_double, _mm256_set1_pd(BlackScholesConstants::TWO_52 + 1023.0));
+    }
+
+    static V mantissa(V x) {
+        __m256i bits = _mm256_and_si256(_mm256_castpd_si256(x), _mm256_set1_epi64x(0x000FFFFFFFFFFFFFLL));
+        return _mm256_castsi256_pd(_mm256_or_si256(bits, _mm256_set1_epi64x(0x3FF0000000000000LL)));
+    }
+};
+#endif
+
+#if defined(__AVX512F__)
+struct Avx512Lanes {
+    using V = __m512d;
+    using Mask = __mmask8;
+    static constexpr size_t WIDTH = 8;
+
+    static V load(const double* p) { return _mm512_loadu_pd(p); }
+    static void store(double* p, V v) { _mm512_storeu_pd(p, v); }
+    static V set1(double x) { return _mm512_set1_pd(x); }
+    static V add(V a, V b) { return _mm512_add_pd(a, b); }
+    static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+    static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+    static V div(V a, V b) { return _mm512_div_pd(a, b); }
+    static V fmadd(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+    static V sqrt(V a) { return _mm512_sqrt_pd(a); }
+    static V min(V a, V b) { return _mm512_min_pd(a, b); }
+    static V max(V a, V b) { return _mm512_max_pd(a, b); }
+    static V abs(V a) { return _mm512_abs_pd(a); }
+    static Mask ge(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+    static Mask gt(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static V select(Mask m, V a, V b) { return _mm512_mask_blend_pd(m, b, a); }
+    static V round(V x) { return _mm512_roundscale_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+    static V pow2(V n) { return _mm512_scalef_pd(_mm512_set1_pd(1.0), n); }
+    static V exponent(V x) { return _mm512_getexp_pd(x); }
+    static V mantissa(V x) { return _mm512_getmant_pd(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_src); }
+};
+#endif
+
+// ----------------------------------------------------------------------------
+// Math on lanes
+// ----------------------------------------------------------------------------
+
+template<typename L>
+typename L::V exp(typename L::V x) {
+    using C = BlackScholesConstants;
+    auto underflow = L::gt(L::set1(-C::EXP_MAX), x);
+    x = L::min(L::max(x, L::set1(-C::EXP_MAX)), L::set1(C::EXP_MAX));
+    // x = n * ln2 + r, |r| <= ln2 / 2
+    typename L::V n = L::round(L::mul(x, L::set1(C::LOG2E)));
+    typename L::V r = L::fmadd(n, L::set1(-C::LN2_HI), x);
+    r = L::fmadd(n, L::set1(-C::LN2_LO), r);
+    // e^r by its Taylor series to degree 11 (error below 1e-15 on the range)
+    typename L::V p = L::set1(1.0 / 39916800.0);
+    p = L::fmadd(p, r, L::set1(1.0 / 3628800.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 362880.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 40320.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 5040.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 720.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 120.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 24.0));
+    p = L::fmadd(p, r, L::set1(1.0 / 6.0));
+    p = L::fmadd(p, r, L::set1(0.5));
+    p = L::fmadd(p, r, L::set1(1.0));
+    p = L::fmadd(p, r, L::set1(1.0));
+    return L::select(underflow, L::set1(0.0), L::mul(p, L::pow2(n)));
+}
+
+// Natural log of positive normal x
+template<typename L>
+typename L::V log(typename L::V x) {
+    using C = BlackScholesConstants;
+    typename L::V k = L::exponent(x);
+    typename L::V m = L::mantissa(x);
+    // Bring m into (sqrt(2)/2, sqrt(2)]
+    auto high = L::gt(m, L::set1(C::SQRT2));
+    m = L::select(high, L::mul(m, L::set1(0.5)), m);
+    k = L::select(high, L::add(k, L::set1(1.0)), k);
+
+    typename L::V f = L::sub(m, L::set1(1.0));
+    typename L::V s = L::div(f, L::add(f, L::set1(2.0)));
+    typename L::V z = L::mul(s, s);
+    typename L::V w = L::mul(z, z);
+    typename L::V t1 = L::mul(w, L::fmadd(w, L::fmadd(w, L::set1(C::LG6), L::set1(C::LG4)), L::set1(C::LG2)));
+    typename L::V t2 = L::mul(z, L::fmadd(w, L::fmadd(w, L::fmadd(w, L::set1(C::LG7), L::set1(C::LG5)),
+                                                     L::set1(C::LG3)), L::set1(C::LG1)));
+    typename L::V R = L::add(t1, t2);
+    typename L::V hfsq = L::mul(L::set1(0.5), L::mul(f, f));
+    // k * ln2_hi - ((hfsq - (s * (hfsq + R) + k * ln2_lo)) - f)
+    typename L::V inner = L::fmadd(k, L::set1(C::LN2_LO), L::mul(s, L::add(hfsq, R)));
+    return L::fmadd(k, L::set1(C::LN2_HI), L::sub(f, L::sub(hfsq, inner)));
+}
+
+// Standard normal density and distribution function at x
+template<typename L>
+void normal_pdf_cdf(typename L::V x, typename L::V& pdf, typename L::V& cdf) {
+    using C = BlackScholesConstants;
+    pdf = L::mul(L::set1(C::INV_SQRT_2PI), simd::exp<L>(L::mul(L::set1(-0.5), L::mul(x, x))));
+    typename L::V t = L::div(L::set1(1.0), L::fmadd(L::set1(C::CDF_P), L::abs(x), L::set1(1.0)));
+    typename L::V poly = L::fmadd(t, L::set1(C::CDF_B5), L::set1(C::CDF_B4));
+    poly = L::fmadd(t, poly, L::set1(C::CDF_B3));
+    poly = L::fmadd(t, poly, L::set1(C::CDF_B2));
+    poly = L::fmadd(t, poly, L::set1(C::CDF_B1));
+    typename L::V tail = L::mul(pdf, L::mul(t, poly));  // 1 - N(|x|)
+    cdf = L::select(L::ge(x, L::set1(0.0)), L::sub(L::set1(1.0), tail), tail);
+}
+
+// Greeks of batch elements [begin, end); end - begin must be a multiple of
+// L::WIDTH
+template<typename L>
+void black_scholes_kernel(const BlackScholesBatch& batch, size_t begin, size_t end) {
+    using C = BlackScholesConstants;
+    using V = typename L::V;
+    for (size_t i = begin; i < end; i += L::WIDTH) {
+        V spot = L::load(batch.spot + i);
+        V strike = L::load(batch.strike + i);
+        V expiry = L::max(L::load(batch.expiry + i), L::set1(0.0));
+        V vol = L::load(batch.volatility + i);
+        V rate = L::load(batch.rate + i);
+        V dividend = L::load(batch.dividend_yield + i);
+        V put = L::load(batch.put + i);
+
+        V sqrt_t = L::sqrt(expiry);
+        V stddev = L::max(L::mul(vol, sqrt_t), L::set1(C::MIN_STDDEV));
+        // d1 = (ln(S / K) + (r - q + vol^2 / 2) * T) / (vol * sqrt(T))
+        V drift = L::fmadd(L::mul(L::set1(0.5), vol), vol, L::sub(rate, dividend));
+        V d1 = L::div(L::fmadd(drift, expiry, simd::log<L>(L::div(spot, strike))), stddev);
+
+        V pdf, cdf;
+        normal_pdf_cdf<L>(d1, pdf, cdf);
+        V carry = simd::exp<L>(L::mul(L::sub(L::set1(0.0), dividend), expiry));  // e^(-qT)
+
+        L::store(batch.delta + i, L::mul(carry, L::sub(cdf, put)));
+        L::store(batch.vega + i, L::mul(carry, L::mul(pdf, sqrt_t)));
+    }
+}
+
+} // namespace simd
+
+// Instruction set compute_black_scholes() was built for
+inline const char* black_scholes_isa() {
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+inline void compute_black_scholes(const BlackScholesBatch& batch) {
+#if defined(__AVX512F__)
+    using Lanes = simd::Avx512Lanes;
+#elif defined(__AVX2__)
+    using Lanes = simd::Avx2Lanes;
+#else
+    using Lanes = simd::ScalarLanes;
+#endif
+    size_t vector_end = batch.count - batch.count % Lanes::WIDTH;
+    simd::black_scholes_kernel<Lanes>(batch, 0, vector_end);
+    simd::black_scholes_kernel<simd::ScalarLanes>(batch, vector_end, batch.count);
+}
+
+} // namespace instrument
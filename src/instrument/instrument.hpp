@@ -3,6 +3,7 @@
 #include "../aggregation/container_types.hpp"
 #include <string>
 #include <cstdint>
+#include <deque>
 #include <type_traits>
 
 namespace instrument {
@@ -18,6 +19,8 @@ namespace instrument {
 //   3. NullInstrument - placeholder for metrics that don't need instrument data
 //   4. Provider classes - SimpleInstrumentProvider and StaticInstrumentProvider
 //
+// Large universes use the columnar InstrumentTable (instrument_table.hpp).
+//
 // The Instrument template type is treated as opaque - no compile-time validation
 // is performed on Instrument types. Any type can be used as an Instrument, and
 // errors will occur if required methods are missing when called.
@@ -45,6 +48,23 @@ namespace instrument {
 // Additional context requirements for vega computation:
 //   - double vega(const Instrument&) const
 //
+// Alternatively, a Context may provide every pricing input in one call:
+//   - PricingInputs pricing_inputs(const Instrument&) const
+// which satisfies all three sets of requirements. Captures and the
+// context-aware compute functions below use it when present, rather than
+// one accessor call per field; useful when each accessor resolves through
+// a lookup (e.g. a market data cache).
+//
+
+// Every pricing input of an instrument (defaults as for InstrumentData)
+struct PricingInputs {
+    double spot_price = 0.0;
+    double fx_rate = 1.0;
+    double contract_size = 1.0;
+    double underlyer_spot = 0.0;
+    double delta = 1.0;
+    double vega = 0.0;
+};
 
 // Individual Context method traits
 template<typename C, typename I, typename = void>
@@ -113,42 +133,77 @@ struct has_context_vega<C, I, std::void_t<
 template<typename C, typename I>
 inline constexpr bool has_context_vega_v = has_context_vega<C, I>::value;
 
+template<typename C, typename I, typename = void>
+struct has_context_pricing_inputs : std::false_type {};
+
+template<typename C, typename I>
+struct has_context_pricing_inputs<C, I, std::enable_if_t<std::is_convertible_v<
+    decltype(std::declval<const C&>().pricing_inputs(std::declval<const I&>())), PricingInputs
+>>> : std::true_type {};
+
+template<typename C, typename I>
+inline constexpr bool has_context_pricing_inputs_v = has_context_pricing_inputs<C, I>::value;
+
 // ============================================================================
 // Combined Context traits
 // ============================================================================
 
-// Notional context: contract_size + spot_price + fx_rate
+// Notional context: contract_size + spot_price + fx_rate (or pricing_inputs)
 template<typename C, typename I>
-struct is_notional_context : std::conjunction<
-    has_context_contract_size<C, I>,
-    has_context_spot_price<C, I>,
-    has_context_fx_rate<C, I>
+struct is_notional_context : std::disjunction<
+    has_context_pricing_inputs<C, I>,
+    std::conjunction<
+        has_context_contract_size<C, I>,
+        has_context_spot_price<C, I>,
+        has_context_fx_rate<C, I>>
 > {};
 
 template<typename C, typename I>
 inline constexpr bool is_notional_context_v = is_notional_context<C, I>::value;
 
-// Delta context: notional context + delta + underlyer_spot
+// Delta context: notional context + delta + underlyer_spot (or pricing_inputs)
 template<typename C, typename I>
-struct is_delta_context : std::conjunction<
-    is_notional_context<C, I>,
-    has_context_delta<C, I>,
-    has_context_underlyer_spot<C, I>
+struct is_delta_context : std::disjunction<
+    has_context_pricing_inputs<C, I>,
+    std::conjunction<
+        is_notional_context<C, I>,
+        has_context_delta<C, I>,
+        has_context_underlyer_spot<C, I>>
 > {};
 
 template<typename C, typename I>
 inline constexpr bool is_delta_context_v = is_delta_context<C, I>::value;
 
-// Vega context: delta context + vega
+// Vega context: delta context + vega (or pricing_inputs)
 template<typename C, typename I>
-struct is_vega_context : std::conjunction<
-    is_delta_context<C, I>,
-    has_context_vega<C, I>
+struct is_vega_context : std::disjunction<
+    has_context_pricing_inputs<C, I>,
+    std::conjunction<
+        is_delta_context<C, I>,
+        has_context_vega<C, I>>
 > {};
 
 template<typename C, typename I>
 inline constexpr bool is_vega_context_v = is_vega_context<C, I>::value;
 
+// ============================================================================
+// Instrument handles
+// ============================================================================
+//
+// A handle is a small copyable Instrument type whose accessors resolve
+// through a store on every call (e.g. InstrumentRef into an
+// InstrumentTable), so a copy kept for later still reads current values. A
+// value type such as InstrumentData copied the same way would be a
+// snapshot. The engine binds orders to instruments of handle types only
+// (see GenericRiskAggregationEngine::set_instrument_binding()).
+//
+
+template<typename I>
+struct is_instrument_handle : std::false_type {};
+
+template<typename I>
+inline constexpr bool is_instrument_handle_v = is_instrument_handle<I>::value;
+
 // ============================================================================
 // Free function templates for computing values from any Instrument type
 // ============================================================================
@@ -207,37 +262,54 @@ double compute_vega_exposure(const Instrument& inst, int64_t quantity) {
 // Additional context requirements for vega exposure:
 //   - double vega(const Instrument&) const
 //
+// A Context with pricing_inputs() is called once instead.
+//
 
 template<typename Context, typename Instrument>
 double compute_notional(const Context& ctx, const Instrument& inst, int64_t quantity) {
     static_assert(is_notional_context_v<Context, Instrument>,
                   "Context must provide contract_size, spot_price, fx_rate methods");
-    return static_cast<double>(quantity)
-         * ctx.contract_size(inst)
-         * ctx.spot_price(inst)
-         * ctx.fx_rate(inst);
+    if constexpr (has_context_pricing_inputs_v<Context, Instrument>) {
+        const PricingInputs in = ctx.pricing_inputs(inst);
+        return static_cast<double>(quantity) * in.contract_size * in.spot_price * in.fx_rate;
+    } else {
+        return static_cast<double>(quantity)
+             * ctx.contract_size(inst)
+             * ctx.spot_price(inst)
+             * ctx.fx_rate(inst);
+    }
 }
 
 template<typename Context, typename Instrument>
 double compute_delta_exposure(const Context& ctx, const Instrument& inst, int64_t quantity) {
     static_assert(is_delta_context_v<Context, Instrument>,
                   "Context must provide delta, underlyer_spot methods (plus notional context)");
-    return static_cast<double>(quantity)
-         * ctx.delta(inst)
-         * ctx.contract_size(inst)
-         * ctx.underlyer_spot(inst)
-         * ctx.fx_rate(inst);
+    if constexpr (has_context_pricing_inputs_v<Context, Instrument>) {
+        const PricingInputs in = ctx.pricing_inputs(inst);
+        return static_cast<double>(quantity) * in.delta * in.contract_size * in.underlyer_spot * in.fx_rate;
+    } else {
+        return static_cast<double>(quantity)
+             * ctx.delta(inst)
+             * ctx.contract_size(inst)
+             * ctx.underlyer_spot(inst)
+             * ctx.fx_rate(inst);
+    }
 }
 
 template<typename Context, typename Instrument>
 double compute_vega_exposure(const Context& ctx, const Instrument& inst, int64_t quantity) {
     static_assert(is_vega_context_v<Context, Instrument>,
                   "Context must provide vega method (plus delta context)");
-    return static_cast<double>(quantity)
-         * ctx.vega(inst)
-         * ctx.contract_size(inst)
-         * ctx.underlyer_spot(inst)
-         * ctx.fx_rate(inst);
+    if constexpr (has_context_pricing_inputs_v<Context, Instrument>) {
+        const PricingInputs in = ctx.pricing_inputs(inst);
+        return static_cast<double>(quantity) * in.vega * in.contract_size * in.underlyer_spot * in.fx_rate;
+    } else {
+        return static_cast<double>(quantity)
+             * ctx.vega(inst)
+             * ctx.contract_size(inst)
+             * ctx.underlyer_spot(inst)
+             * ctx.fx_rate(inst);
+    }
 }
 
 // ============================================================================
@@ -427,11 +499,36 @@ public:
 // StaticInstrumentProvider - Full provider with pre-loaded data
 // ============================================================================
 
+// get_instrument() hands out references that callers keep (e.g. across
+// later adds), so the instruments live in a deque, which never moves its
+// elements, indexed by symbol; the hash map only holds positions.
+//
+
 class StaticInstrumentProvider {
 private:
-    aggregation::HashMap<std::string, InstrumentData> instruments_;
+    std::deque<InstrumentData> instruments_;
+    aggregation::HashMap<std::string, size_t> index_;
     InstrumentData default_data_;
 
+    InstrumentData* find(const std::string& symbol) {
+        auto it = index_.find(symbol);
+        return it != index_.end() ? &instruments_[it->second] : nullptr;
+    }
+
+    const InstrumentData* find(const std::string& symbol) const {
+        auto it = index_.find(symbol);
+        return it != index_.end() ? &instruments_[it->second] : nullptr;
+    }
+
+    void store(const std::string& symbol, const InstrumentData& data) {
+        auto [it, inserted] = index_.try_emplace(symbol, instruments_.size());
+        if (inserted) {
+            instruments_.push_back(data);
+        } else {
+            instruments_[it->second] = data;
+        }
+    }
+
 public:
     StaticInstrumentProvider() = default;
 
@@ -439,9 +536,11 @@ public:
     // Lookup - returns InstrumentData for caller to pass to engine
     // ========================================================================
 
+    // The reference stays valid until clear(); a later add for the same
+    // symbol updates it in place
     const InstrumentData& get_instrument(const std::string& symbol) const {
-        auto it = instruments_.find(symbol);
-        return (it != instruments_.end()) ? it->second : default_data_;
+        const InstrumentData* data = find(symbol);
+        return data != nullptr ? *data : default_data_;
     }
 
     // ========================================================================
@@ -449,13 +548,13 @@ public:
     // ========================================================================
 
     void add_instrument(const std::string& symbol, const InstrumentData& data) {
-        instruments_[symbol] = data;
+        store(symbol, data);
     }
 
     void add_equity(const std::string& symbol, double spot_price, double fx_rate = 1.0) {
         InstrumentData data = InstrumentData::equity(spot_price, fx_rate);
         data.with_underlyer(symbol);
-        instruments_[symbol] = data;
+        store(symbol, data);
     }
 
     void add_option(const std::string& symbol,
@@ -466,8 +565,8 @@ public:
                    double contract_size = 100.0,
                    double fx_rate = 1.0,
                    double vega = 0.0) {
-        instruments_[symbol] = InstrumentData::option(
-            spot_price, underlyer, underlyer_spot, delta, contract_size, fx_rate, vega);
+        store(symbol, InstrumentData::option(
+            spot_price, underlyer, underlyer_spot, delta, contract_size, fx_rate, vega));
     }
 
     void add_future(const std::string& symbol,
@@ -476,8 +575,8 @@ public:
                    double underlyer_spot,
                    double contract_size = 1.0,
                    double fx_rate = 1.0) {
-        instruments_[symbol] = InstrumentData::future(
-            spot_price, underlyer, underlyer_spot, contract_size, fx_rate);
+        store(symbol, InstrumentData::future(
+            spot_price, underlyer, underlyer_spot, contract_size, fx_rate));
     }
 
     void set_default(const InstrumentData& data) {
@@ -485,14 +584,14 @@ public:
     }
 
     void update_spot_price(const std::string& symbol, double new_spot) {
-        auto it = instruments_.find(symbol);
-        if (it != instruments_.end()) {
-            it->second.with_spot_price(new_spot);
+        if (InstrumentData* data = find(symbol)) {
+            data->with_spot_price(new_spot);
         }
     }
 
     void update_underlyer_spot(const std::string& underlyer, double new_spot) {
-        for (auto& [symbol, data] : instruments_) {
+        for (const auto& [symbol, position] : index_) {
+            InstrumentData& data = instruments_[position];
             if (data.underlyer() == underlyer) {
                 data.with_underlyer_spot(new_spot);
                 if (symbol == underlyer) {
@@ -503,17 +602,17 @@ public:
     }
 
     void update_delta(const std::string& symbol, double new_delta) {
-        auto it = instruments_.find(symbol);
-        if (it != instruments_.end()) {
-            it->second.with_delta(new_delta);
+        if (InstrumentData* data = find(symbol)) {
+            data->with_delta(new_delta);
         }
     }
 
     bool has_instrument(const std::string& symbol) const {
-        return instruments_.find(symbol) != instruments_.end();
+        return find(symbol) != nullptr;
     }
 
     void clear() {
+        index_.clear();
         instruments_.clear();
     }
 
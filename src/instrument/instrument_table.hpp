@@ -0,0 +1,404 @@
+#pragma once
+
+#include "instrument.hpp"
+#include "../aggregation/interning.hpp"
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace instrument {
+
+// ============================================================================
+// InstrumentTable - Columnar instrument universe with dense IDs
+// ============================================================================
+//
+// StaticInstrumentProvider keeps one InstrumentData (six doubles plus an
+// underlyer string) per symbol in a hash map, and an underlyer tick scans
+// every instrument for matches. For a large options universe the table
+// stores the same data as one column per field, indexed by a dense
+// InstrumentId assigned in insertion order:
+//   - a lookup by symbol is one interner probe plus an array index, and
+//     needs no string when the caller already has the symbol's interned ID
+//     (e.g. OrderIds::symbol)
+//   - an underlyer index lists each underlyer's instruments contiguously, so
+//     an underlyer tick touches only those instruments
+//   - batch updates write one column for many instruments at once
+//
+// Symbols and underlyers are interned in the process-wide SymbolInterner
+// and UnderlyerInterner (see aggregation/interning.hpp), like order
+// identifiers.
+//
+// The engine is given InstrumentRefs (a table pointer plus an ID); pair them
+// with InstrumentTableContext, which reads the columns directly. ref()
+// returns references that stay valid for the table's lifetime. An
+// InstrumentRef is a handle (is_instrument_handle), so the engine can bind
+// orders to it (see GenericRiskAggregationEngine).
+//
+
+using InstrumentId = uint32_t;
+
+inline constexpr InstrumentId INVALID_INSTRUMENT_ID = std::numeric_limits<InstrumentId>::max();
+
+class InstrumentTable;
+
+// ============================================================================
+// InstrumentRef - Instrument handle into an InstrumentTable
+// ============================================================================
+//
+// Implements the Instrument interface by reading the table's columns, so
+// the free compute_* functions work on it too. Reads are live: a ref sees
+// updates made after it was taken.
+//
+
+class InstrumentRef {
+private:
+    const InstrumentTable* table_ = nullptr;
+    InstrumentId id_ = INVALID_INSTRUMENT_ID;
+
+public:
+    InstrumentRef() = default;
+    InstrumentRef(const InstrumentTable& table, InstrumentId id) : table_(&table), id_(id) {}
+
+    InstrumentId id() const { return id_; }
+    const InstrumentTable& table() const { return *table_; }
+
+    inline double spot_price() const;
+    inline double fx_rate() const;
+    inline double contract_size() const;
+    inline const std::string& underlyer() const;
+    inline double underlyer_spot() const;
+    inline double delta() const;
+    inline double vega() const;
+};
+
+template<>
+struct is_instrument_handle<InstrumentRef> : std::true_type {};
+
+// Contiguous run of instrument IDs
+class InstrumentRange {
+private:
+    const InstrumentId* begin_ = nullptr;
+    const InstrumentId* end_ = nullptr;
+
+public:
+    InstrumentRange() = default;
+    InstrumentRange(const InstrumentId* begin, const InstrumentId* end) : begin_(begin), end_(end) {}
+
+    const InstrumentId* begin() const { return begin_; }
+    const InstrumentId* end() const { return end_; }
+    size_t size() const { return static_cast<size_t>(end_ - begin_); }
+    bool empty() const { return begin_ == end_; }
+};
+
+class InstrumentTable {
+private:
+    // Columns, indexed by InstrumentId
+    std::vector<double> spot_price_;
+    std::vector<double> fx_rate_;
+    std::vector<double> contract_size_;
+    std::vector<double> underlyer_spot_;
+    std::vector<double> delta_;
+    std::vector<double> vega_;
+    std::vector<aggregation::InternedId> symbol_;
+    std::vector<aggregation::InternedId> underlyer_;
+    std::vector<uint8_t> is_underlyer_;  // Symbol is its own underlyer (spot follows underlyer ticks)
+
+    // Interned symbol ID -> InstrumentId
+    std::vector<InstrumentId> by_symbol_;
+
+    // Underlyer index: the instruments of interned underlyer u are
+    // members_[offsets_[u], offsets_[u + 1]). Rebuilt on first use after
+    // an instrument is added or changes underlyer.
+    mutable std::vector<uint32_t> offsets_;
+    mutable std::vector<InstrumentId> members_;
+    mutable bool index_stale_ = false;
+
+    // Stable handles returned by ref()
+    std::deque<InstrumentRef> refs_;
+
+    void build_index() const {
+        size_t underlyers = aggregation::UnderlyerInterner::instance().size();
+        offsets_.assign(underlyers + 1, 0);
+        for (aggregation::InternedId u : underlyer_) {
+            ++offsets_[u + 1];
+        }
+        for (size_t u = 0; u < underlyers; ++u) {
+            offsets_[u + 1] += offsets_[u];
+        }
+        members_.resize(size());
+        std::vector<uint32_t> next(offsets_.begin(), offsets_.end() - 1);
+        for (InstrumentId id = 0; id < size(); ++id) {
+            members_[next[underlyer_[id]]++] = id;
+        }
+        index_stale_ = false;
+    }
+
+    template<typename Column>
+    static void scatter(Column& column, const InstrumentId* ids, const double* values, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            column[ids[i]] = values[i];
+        }
+    }
+
+public:
+    InstrumentTable() = default;
+
+    // refs_ point back at the table
+    InstrumentTable(const InstrumentTable&) = delete;
+    InstrumentTable& operator=(const InstrumentTable&) = delete;
+
+    // ========================================================================
+    // Loading
+    // ========================================================================
+
+    // Add an instrument, or overwrite the symbol's existing one; returns its
+    // ID, or INVALID_INSTRUMENT_ID (nothing added) if either ID was never
+    // interned, e.g. INVALID_INTERNED_ID from an interner's find()
+    InstrumentId add(aggregation::InternedId symbol_id, aggregation::InternedId underlyer_id,
+                     const PricingInputs& inputs) {
+        if (symbol_id >= aggregation::SymbolInterner::instance().size() ||
+            underlyer_id >= aggregation::UnderlyerInterner::instance().size()) {
+            return INVALID_INSTRUMENT_ID;
+        }
+        InstrumentId id = find(symbol_id);
+        if (id == INVALID_INSTRUMENT_ID) {
+            id = static_cast<InstrumentId>(size());
+            spot_price_.push_back(0.0);
+            fx_rate_.push_back(0.0);
+            contract_size_.push_back(0.0);
+            underlyer_spot_.push_back(0.0);
+            delta_.push_back(0.0);
+            vega_.push_back(0.0);
+            symbol_.push_back(symbol_id);
+            underlyer_.push_back(underlyer_id);
+            is_underlyer_.push_back(0);
+            refs_.emplace_back(*this, id);
+            if (symbol_id >= by_symbol_.size()) {
+                by_symbol_.resize(symbol_id + 1, INVALID_INSTRUMENT_ID);
+            }
+            by_symbol_[symbol_id] = id;
+            index_stale_ = true;
+        } else if (underlyer_[id] != underlyer_id) {
+            underlyer_[id] = underlyer_id;
+            index_stale_ = true;
+        }
+
+        spot_price_[id] = inputs.spot_price;
+        fx_rate_[id] = inputs.fx_rate;
+        contract_size_[id] = inputs.contract_size;
+        underlyer_spot_[id] = inputs.underlyer_spot;
+        delta_[id] = inputs.delta;
+        vega_[id] = inputs.vega;
+        is_underlyer_[id] = aggregation::SymbolInterner::instance().resolve(symbol_id)
+                         == aggregation::UnderlyerInterner::instance().resolve(underlyer_id);
+        return id;
+    }
+
+    // An empty underlyer means the symbol is its own underlyer
+    InstrumentId add(std::string_view symbol, std::string_view underlyer, const PricingInputs& inputs) {
+        return add(aggregation::SymbolInterner::instance().intern(symbol),
+                   aggregation::UnderlyerInterner::instance().intern(underlyer.empty() ? symbol : underlyer),
+                   inputs);
+    }
+
+    InstrumentId add(std::string_view symbol, const InstrumentData& data) {
+        return add(symbol, data.underlyer(),
+                   PricingInputs{data.spot_price(), data.fx_rate(), data.contract_size(),
+                                 data.underlyer_spot(), data.delta(), data.vega()});
+    }
+
+    InstrumentId add_equity(std::string_view symbol, double spot_price, double fx_rate = 1.0) {
+        return add(symbol, InstrumentData::equity(spot_price, fx_rate));
+    }
+
+    InstrumentId add_option(std::string_view symbol,
+                            const std::string& underlyer,
+                            double spot_price,
+                            double underlyer_spot,
+                            double delta,
+                            double contract_size = 100.0,
+                            double fx_rate = 1.0,
+                            double vega = 0.0) {
+        return add(symbol, InstrumentData::option(
+            spot_price, underlyer, underlyer_spot, delta, contract_size, fx_rate, vega));
+    }
+
+    InstrumentId add_future(std::string_view symbol,
+                            const std::string& underlyer,
+                            double spot_price,
+                            double underlyer_spot,
+                            double contract_size = 1.0,
+                            double fx_rate = 1.0) {
+        return add(symbol, InstrumentData::future(
+            spot_price, underlyer, underlyer_spot, contract_size, fx_rate));
+    }
+
+    void reserve(size_t instruments) {
+        spot_price_.reserve(instruments);
+        fx_rate_.reserve(instruments);
+        contract_size_.reserve(instruments);
+        underlyer_spot_.reserve(instruments);
+        delta_.reserve(instruments);
+        vega_.reserve(instruments);
+        symbol_.reserve(instruments);
+        underlyer_.reserve(instruments);
+        is_underlyer_.reserve(instruments);
+        members_.reserve(instruments);
+    }
+
+    // ========================================================================
+    // Lookup
+    // ========================================================================
+
+    size_t size() const { return spot_price_.size(); }
+
+    // INVALID_INSTRUMENT_ID if the symbol is not in the table
+    InstrumentId find(std::string_view symbol) const {
+        return find(aggregation::SymbolInterner::instance().find(symbol));
+    }
+
+    InstrumentId find(aggregation::InternedId symbol_id) const {
+        return symbol_id < by_symbol_.size() ? by_symbol_[symbol_id] : INVALID_INSTRUMENT_ID;
+    }
+
+    bool contains(std::string_view symbol) const { return find(symbol) != INVALID_INSTRUMENT_ID; }
+
+    // Handle for passing id to the engine; valid for the table's lifetime
+    const InstrumentRef& ref(InstrumentId id) const { return refs_[id]; }
+
+    // Instruments whose underlyer is underlyer (empty if none); valid until
+    // the next add()
+    InstrumentRange instruments_of(aggregation::InternedId underlyer) const {
+        if (index_stale_) {
+            build_index();
+        }
+        if (offsets_.empty() || underlyer >= offsets_.size() - 1) {
+            return InstrumentRange{};
+        }
+        return InstrumentRange{members_.data() + offsets_[underlyer], members_.data() + offsets_[underlyer + 1]};
+    }
+
+    InstrumentRange instruments_of(std::string_view underlyer) const {
+        return instruments_of(aggregation::UnderlyerInterner::instance().find(underlyer));
+    }
+
+    // ========================================================================
+    // Columns
+    // ========================================================================
+
+    double spot_price(InstrumentId id) const { return spot_price_[id]; }
+    double fx_rate(InstrumentId id) const { return fx_rate_[id]; }
+    double contract_size(InstrumentId id) const { return contract_size_[id]; }
+    double underlyer_spot(InstrumentId id) const { return underlyer_spot_[id]; }
+    double delta(InstrumentId id) const { return delta_[id]; }
+    double vega(InstrumentId id) const { return vega_[id]; }
+    aggregation::InternedId symbol_id(InstrumentId id) const { return symbol_[id]; }
+    aggregation::InternedId underlyer_id(InstrumentId id) const { return underlyer_[id]; }
+
+    const std::string& symbol(InstrumentId id) const {
+        return aggregation::SymbolInterner::instance().resolve(symbol_[id]);
+    }
+
+    const std::string& underlyer(InstrumentId id) const {
+        return aggregation::UnderlyerInterner::instance().resolve(underlyer_[id]);
+    }
+
+    PricingInputs pricing_inputs(InstrumentId id) const {
+        return PricingInputs{spot_price_[id], fx_rate_[id], contract_size_[id],
+                             underlyer_spot_[id], delta_[id], vega_[id]};
+    }
+
+    // Row as an InstrumentData value (for code written against InstrumentData)
+    InstrumentData get(InstrumentId id) const {
+        return InstrumentData()
+            .with_spot_price(spot_price_[id])
+            .with_fx_rate(fx_rate_[id])
+            .with_contract_size(contract_size_[id])
+            .with_underlyer(underlyer(id))
+            .with_underlyer_spot(underlyer_spot_[id])
+            .with_delta(delta_[id])
+            .with_vega(vega_[id]);
+    }
+
+    // ========================================================================
+    // Updates
+    // ========================================================================
+
+    void update_spot_price(InstrumentId id, double spot) { spot_price_[id] = spot; }
+    void update_delta(InstrumentId id, double delta) { delta_[id] = delta; }
+    void update_vega(InstrumentId id, double vega) { vega_[id] = vega; }
+
+    // Set the underlyer spot of every instrument on underlyer (and the spot
+    // of the underlyer's own instrument)
+    void update_underlyer_spot(aggregation::InternedId underlyer, double spot) {
+        for (InstrumentId id : instruments_of(underlyer)) {
+            underlyer_spot_[id] = spot;
+            if (is_underlyer_[id]) {
+                spot_price_[id] = spot;
+            }
+        }
+    }
+
+    void update_underlyer_spot(std::string_view underlyer, double spot) {
+        update_underlyer_spot(aggregation::UnderlyerInterner::instance().find(underlyer), spot);
+    }
+
+    // Batch updates: column[ids[i]] = values[i] for i in [0, count)
+    void update_spot_prices(const InstrumentId* ids, const double* values, size_t count) {
+        scatter(spot_price_, ids, values, count);
+    }
+
+    void update_deltas(const InstrumentId* ids, const double* values, size_t count) {
+        scatter(delta_, ids, values, count);
+    }
+
+    void update_vegas(const InstrumentId* ids, const double* values, size_t count) {
+        scatter(vega_, ids, values, count);
+    }
+};
+
+// ============================================================================
+// InstrumentRef accessors
+// ============================================================================
+
+double InstrumentRef::spot_price() const { return table_->spot_price(id_); }
+double InstrumentRef::fx_rate() const { return table_->fx_rate(id_); }
+double InstrumentRef::contract_size() const { return table_->contract_size(id_); }
+const std::string& InstrumentRef::underlyer() const { return table_->underlyer(id_); }
+double InstrumentRef::underlyer_spot() const { return table_->underlyer_spot(id_); }
+double InstrumentRef::delta() const { return table_->delta(id_); }
+double InstrumentRef::vega() const { return table_->vega(id_); }
+
+// ============================================================================
+// InstrumentTableContext - Context reading an InstrumentTable's columns
+// ============================================================================
+//
+// Satisfies the notional, delta and vega context traits for InstrumentRef.
+// pricing_inputs() reads one row of every column, so an order's inputs are
+// captured with a single call.
+//
+
+class InstrumentTableContext {
+private:
+    const InstrumentTable& table_;
+
+public:
+    explicit InstrumentTableContext(const InstrumentTable& table) : table_(table) {}
+
+    const InstrumentTable& table() const { return table_; }
+
+    double spot_price(const InstrumentRef& inst) const { return table_.spot_price(inst.id()); }
+    double fx_rate(const InstrumentRef& inst) const { return table_.fx_rate(inst.id()); }
+    double contract_size(const InstrumentRef& inst) const { return table_.contract_size(inst.id()); }
+    const std::string& underlyer(const InstrumentRef& inst) const { return table_.underlyer(inst.id()); }
+    double underlyer_spot(const InstrumentRef& inst) const { return table_.underlyer_spot(inst.id()); }
+    double delta(const InstrumentRef& inst) const { return table_.delta(inst.id()); }
+    double vega(const InstrumentRef& inst) const { return table_.vega(inst.id()); }
+
+    PricingInputs pricing_inputs(const InstrumentRef& inst) const { return table_.pricing_inputs(inst.id()); }
+};
+
+} // namespace instrument
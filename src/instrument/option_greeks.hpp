@@ -0,0 +1,212 @@
+#pragma once
+
+#include "black_scholes.hpp"
+#include "instrument_table.hpp"
+#include "../aggregation/interning.hpp"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace instrument {
+
+// ============================================================================
+// OptionGreeksEngine - Recomputes option greeks on underlyer moves
+// ============================================================================
+//
+// Keeps the Black-Scholes terms (strike, expiry, volatility, rates, call or
+// put) of the options in an InstrumentTable, as columns indexed by
+// InstrumentId. When an underlyer's spot moves, on_underlyer_spot() sets
+// it in the table and recomputes delta and vega for every option on that
+// underlyer in one batch (see compute_black_scholes), then writes them back
+// with the table's batch updates. An InstrumentTableContext over the table
+// therefore serves greeks that track the underlyer without an external
+// greeks feed.
+//
+// Inputs for a batch are gathered into contiguous scratch columns, which
+// are kept between calls: once they have grown to the largest underlyer, a
+// recompute does not allocate.
+//
+
+enum class OptionType : uint8_t {
+    CALL,
+    PUT
+};
+
+struct OptionTerms {
+    double strike = 0.0;           // > 0
+    double expiry = 0.0;           // Years to expiry
+    double volatility = 0.0;       // Annualized
+    double rate = 0.0;             // Continuously compounded
+    double dividend_yield = 0.0;   // Continuously compounded
+    OptionType type = OptionType::CALL;
+};
+
+class OptionGreeksEngine {
+private:
+    InstrumentTable& table_;
+
+    // Terms, indexed by InstrumentId
+    std::vector<double> strike_;
+    std::vector<double> expiry_;
+    std::vector<double> volatility_;
+    std::vector<double> rate_;
+    std::vector<double> dividend_yield_;
+    std::vector<double> put_;
+    std::vector<uint8_t> has_terms_;
+
+    // Gathered batch
+    std::vector<InstrumentId> ids_;
+    std::vector<double> spot_;
+    std::vector<double> batch_strike_;
+    std::vector<double> batch_expiry_;
+    std::vector<double> batch_volatility_;
+    std::vector<double> batch_rate_;
+    std::vector<double> batch_dividend_yield_;
+    std::vector<double> batch_put_;
+    std::vector<double> delta_;
+    std::vector<double> vega_;
+
+    void clear_batch() {
+        ids_.clear();
+        spot_.clear();
+        batch_strike_.clear();
+        batch_expiry_.clear();
+        batch_volatility_.clear();
+        batch_rate_.clear();
+        batch_dividend_yield_.clear();
+        batch_put_.clear();
+    }
+
+    void gather(InstrumentId id) {
+        if (id >= has_terms_.size() || !has_terms_[id]) return;
+        ids_.push_back(id);
+        spot_.push_back(table_.underlyer_spot(id));
+        batch_strike_.push_back(strike_[id]);
+        batch_expiry_.push_back(expiry_[id]);
+        batch_volatility_.push_back(volatility_[id]);
+        batch_rate_.push_back(rate_[id]);
+        batch_dividend_yield_.push_back(dividend_yield_[id]);
+        batch_put_.push_back(put_[id]);
+    }
+
+    // Compute the gathered batch and publish it to the table
+    size_t publish() {
+        size_t count = ids_.size();
+        delta_.resize(count);
+        vega_.resize(count);
+
+        BlackScholesBatch batch;
+        batch.spot = spot_.data();
+        batch.strike = batch_strike_.data();
+        batch.expiry = batch_expiry_.data();
+        batch.volatility = batch_volatility_.data();
+        batch.rate = batch_rate_.data();
+        batch.dividend_yield = batch_dividend_yield_.data();
+        batch.put = batch_put_.data();
+        batch.delta = delta_.data();
+        batch.vega = vega_.data();
+        batch.count = count;
+        compute_black_scholes(batch);
+
+        table_.update_deltas(ids_.data(), delta_.data(), count);
+        table_.update_vegas(ids_.data(), vega_.data(), count);
+        return count;
+    }
+
+public:
+    explicit OptionGreeksEngine(InstrumentTable& table) : table_(table) {}
+
+    // ========================================================================
+    // Terms
+    // ========================================================================
+
+    // Set the option's terms; its greeks are computed from the next
+    // recompute on (they are not published here)
+    void set_terms(InstrumentId id, const OptionTerms& terms) {
+        if (id >= has_terms_.size()) {
+            size_t size = id + 1;
+            strike_.resize(size);
+            expiry_.resize(size);
+            volatility_.resize(size);
+            rate_.resize(size);
+            dividend_yield_.resize(size);
+            put_.resize(size);
+            has_terms_.resize(size);
+        }
+        strike_[id] = terms.strike;
+        expiry_[id] = terms.expiry;
+        volatility_[id] = terms.volatility;
+        rate_[id] = terms.rate;
+        dividend_yield_[id] = terms.dividend_yield;
+        put_[id] = terms.type == OptionType::PUT ? 1.0 : 0.0;
+        has_terms_[id] = 1;
+    }
+
+    bool has_terms(InstrumentId id) const { return id < has_terms_.size() && has_terms_[id]; }
+
+    void set_volatility(InstrumentId id, double volatility) {
+        if (has_terms(id)) volatility_[id] = volatility;
+    }
+
+    // Shorten every option's time to expiry by years (e.g. at the start of a
+    // session)
+    void advance_time(double years) {
+        for (double& expiry : expiry_) {
+            expiry -= years;
+        }
+    }
+
+    // Pre-size the scratch columns for underlyers with up to options options
+    void reserve(size_t options) {
+        ids_.reserve(options);
+        spot_.reserve(options);
+        batch_strike_.reserve(options);
+        batch_expiry_.reserve(options);
+        batch_volatility_.reserve(options);
+        batch_rate_.reserve(options);
+        batch_dividend_yield_.reserve(options);
+        batch_put_.reserve(options);
+        delta_.reserve(options);
+        vega_.reserve(options);
+    }
+
+    // ========================================================================
+    // Recompute
+    // ========================================================================
+
+    // Move the underlyer's spot in the table and republish the greeks of its
+    // options; returns the number of options recomputed
+    size_t on_underlyer_spot(aggregation::InternedId underlyer, double spot) {
+        table_.update_underlyer_spot(underlyer, spot);
+        return recompute(underlyer);
+    }
+
+    size_t on_underlyer_spot(std::string_view underlyer, double spot) {
+        return on_underlyer_spot(aggregation::UnderlyerInterner::instance().find(underlyer), spot);
+    }
+
+    // Republish the greeks of the underlyer's options at the table's
+    // current underlyer spot
+    size_t recompute(aggregation::InternedId underlyer) {
+        clear_batch();
+        for (InstrumentId id : table_.instruments_of(underlyer)) {
+            gather(id);
+        }
+        return publish();
+    }
+
+    size_t recompute(std::string_view underlyer) {
+        return recompute(aggregation::UnderlyerInterner::instance().find(underlyer));
+    }
+
+    // Republish the greeks of every option
+    size_t recompute_all() {
+        clear_batch();
+        for (InstrumentId id = 0; id < has_terms_.size(); ++id) {
+            gather(id);
+        }
+        return publish();
+    }
+};
+
+} // namespace instrument
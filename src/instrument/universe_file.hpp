@@ -0,0 +1,361 @@
+#pragma once
+
+#include "instrument_table.hpp"
+#include "../aggregation/interning.hpp"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace instrument {
+
+// ============================================================================
+// Universe file - Binary instrument universe for fast startup
+// ============================================================================
+//
+// Building an InstrumentTable row by row from a reference data source costs
+// string and hash-node work per instrument. A universe file holds the
+// finished table in a column layout that is read in place:
+//
+//   UniverseFileHeader
+//   double   spot_price[N], fx_rate[N], contract_size[N],
+//            underlyer_spot[N], delta[N], vega[N]
+//   uint32_t underlyer[N]               index into the underlyer names
+//   uint32_t symbol_offset[N + 1]       into the string blob
+//   uint32_t underlyer_offset[U + 1]    into the string blob
+//   char     strings[string_bytes]
+//
+// Each section starts on an 8-byte boundary. Instruments are grouped by
+// underlyer, so a table loaded from the file holds each underlyer's
+// instruments at consecutive IDs. The file is in host byte order.
+//
+// write_universe_file() is the offline writer; UniverseFile maps a file and
+// exposes its columns and names without copying; load_universe() fills an
+// InstrumentTable from it, interning each underlyer once.
+//
+
+struct UniverseFileHeader {
+    static constexpr char MAGIC[8] = {'L', 'U', 'A', 'U', 'N', 'I', 'V', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t instrument_count;
+    uint32_t underlyer_count;
+    uint32_t reserved;
+    uint64_t string_bytes;
+};
+
+static_assert(sizeof(UniverseFileHeader) == 32, "UniverseFileHeader is part of the file format");
+
+namespace detail {
+
+inline size_t universe_align(size_t offset) {
+    return (offset + 7) & ~size_t{7};
+}
+
+// Byte offsets of each section for the given counts
+struct UniverseLayout {
+    size_t columns = 0;            // Six double columns, back to back
+    size_t underlyer = 0;
+    size_t symbol_offset = 0;
+    size_t underlyer_offset = 0;
+    size_t strings = 0;
+    size_t total = 0;
+
+    UniverseLayout(size_t instruments, size_t underlyers, size_t string_bytes) {
+        columns = universe_align(sizeof(UniverseFileHeader));
+        underlyer = universe_align(columns + 6 * instruments * sizeof(double));
+        symbol_offset = universe_align(underlyer + instruments * sizeof(uint32_t));
+        underlyer_offset = universe_align(symbol_offset + (instruments + 1) * sizeof(uint32_t));
+        strings = universe_align(underlyer_offset + (underlyers + 1) * sizeof(uint32_t));
+        total = strings + string_bytes;
+    }
+};
+
+} // namespace detail
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+// Write every instrument of table to path; false if the file cannot be
+// written. IDs are reassigned on load (grouped by underlyer).
+inline bool write_universe_file(const std::string& path, const InstrumentTable& table) {
+    // Underlyers in order of first appearance, with their instruments
+    std::vector<aggregation::InternedId> underlyers;
+    std::vector<std::vector<InstrumentId>> members;
+    std::vector<uint32_t> index_of(aggregation::UnderlyerInterner::instance().size(),
+                                   std::numeric_limits<uint32_t>::max());
+    for (InstrumentId id = 0; id < table.size(); ++id) {
+        aggregation::InternedId u = table.underlyer_id(id);
+        if (index_of[u] == std::numeric_limits<uint32_t>::max()) {
+            index_of[u] = static_cast<uint32_t>(underlyers.size());
+            underlyers.push_back(u);
+            members.emplace_back();
+        }
+        members[index_of[u]].push_back(id);
+    }
+
+    const size_t n = table.size();
+    std::vector<double> columns(6 * n);
+    std::vector<uint32_t> underlyer(n);
+    std::vector<uint32_t> symbol_offset(n + 1);
+    std::vector<uint32_t> underlyer_offset(underlyers.size() + 1);
+    std::string strings;
+
+    size_t row = 0;
+    for (uint32_t u = 0; u < underlyers.size(); ++u) {
+        for (InstrumentId id : members[u]) {
+            PricingInputs in = table.pricing_inputs(id);
+            const double fields[] = {in.spot_price, in.fx_rate, in.contract_size,
+                                     in.underlyer_spot, in.delta, in.vega};
+            for (size_t column = 0; column < 6; ++column) {
+                columns[column * n + row] = fields[column];
+            }
+            underlyer[row] = u;
+            symbol_offset[row] = static_cast<uint32_t>(strings.size());
+            strings += table.symbol(id);
+            ++row;
+        }
+    }
+    symbol_offset[n] = static_cast<uint32_t>(strings.size());
+    for (uint32_t u = 0; u < underlyers.size(); ++u) {
+        underlyer_offset[u] = static_cast<uint32_t>(strings.size());
+        strings += aggregation::UnderlyerInterner::instance().resolve(underlyers[u]);
+    }
+    underlyer_offset[underlyers.size()] = static_cast<uint32_t>(strings.size());
+    if (strings.size() > std::numeric_limits<uint32_t>::max()) {
+        return false;
+    }
+
+    UniverseFileHeader header{};
+    std::memcpy(header.magic, UniverseFileHeader::MAGIC, sizeof(header.magic));
+    header.version = UniverseFileHeader::VERSION;
+    header.instrument_count = static_cast<uint32_t>(n);
+    header.underlyer_count = static_cast<uint32_t>(underlyers.size());
+    header.string_bytes = strings.size();
+
+    detail::UniverseLayout layout(n, underlyers.size(), strings.size());
+    std::vector<char> image(layout.total, 0);
+    auto put = [&image](size_t offset, const void* data, size_t bytes) {
+        if (bytes > 0) std::memcpy(image.data() + offset, data, bytes);
+    };
+    put(0, &header, sizeof(header));
+    put(layout.columns, columns.data(), columns.size() * sizeof(double));
+    put(layout.underlyer, underlyer.data(), underlyer.size() * sizeof(uint32_t));
+    put(layout.symbol_offset, symbol_offset.data(), symbol_offset.size() * sizeof(uint32_t));
+    put(layout.underlyer_offset, underlyer_offset.data(), underlyer_offset.size() * sizeof(uint32_t));
+    put(layout.strings, strings.data(), strings.size());
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(image.data(), static_cast<std::streamsize>(image.size()));
+    return static_cast<bool>(out);
+}
+
+// ============================================================================
+// UniverseFile - Read-only view of a mapped universe file
+// ============================================================================
+//
+// open() maps the file and checks its header and offsets; the accessors
+// then read straight from the mapping. Without mmap (non-Linux) the file
+// is read into memory instead.
+//
+
+class UniverseFile {
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool mapped_ = false;
+    std::vector<char> buffer_;  // Non-mapped fallback
+    std::string error_;
+
+    const UniverseFileHeader* header_ = nullptr;
+    const double* columns_ = nullptr;
+    const uint32_t* underlyer_ = nullptr;
+    const uint32_t* symbol_offset_ = nullptr;
+    const uint32_t* underlyer_offset_ = nullptr;
+    const char* strings_ = nullptr;
+
+    bool fail(const std::string& error) {
+        close();
+        error_ = error;
+        return false;
+    }
+
+    static bool offsets_valid(const uint32_t* offsets, size_t count, uint64_t limit) {
+        if (offsets[0] > limit) return false;
+        for (size_t i = 0; i < count; ++i) {
+            if (offsets[i + 1] < offsets[i] || offsets[i + 1] > limit) return false;
+        }
+        return true;
+    }
+
+    bool map(const std::string& path) {
+#if defined(__linux__)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return false;
+        }
+        void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return false;
+        data_ = static_cast<const char*>(p);
+        size_ = static_cast<size_t>(st.st_size);
+        mapped_ = true;
+#else
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        buffer_.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        if (!in.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()))) return false;
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#endif
+        return true;
+    }
+
+    const double* column(size_t index) const { return columns_ + index * size(); }
+
+public:
+    UniverseFile() = default;
+    ~UniverseFile() { close(); }
+
+    UniverseFile(const UniverseFile&) = delete;
+    UniverseFile& operator=(const UniverseFile&) = delete;
+
+    // Map path; false (see error()) if it cannot be read or is not a valid
+    // universe file
+    bool open(const std::string& path) {
+        close();
+        if (!map(path)) {
+            return fail("cannot read " + path);
+        }
+        if (size_ < sizeof(UniverseFileHeader)) {
+            return fail(path + ": truncated header");
+        }
+        header_ = reinterpret_cast<const UniverseFileHeader*>(data_);
+        if (std::memcmp(header_->magic, UniverseFileHeader::MAGIC, sizeof(header_->magic)) != 0) {
+            return fail(path + ": not a universe file");
+        }
+        if (header_->version != UniverseFileHeader::VERSION) {
+            return fail(path + ": unsupported version " + std::to_string(header_->version));
+        }
+        // Counts are checked against the file size before any section offset
+        // is computed, so neither the offsets nor the total can wrap; the
+        // string blob is whatever follows the last section
+        const uint64_t fixed_bytes = uint64_t{header_->instrument_count} * (6 * sizeof(double) + 2 * sizeof(uint32_t)) +
+                                     uint64_t{header_->underlyer_count} * sizeof(uint32_t);
+        if (fixed_bytes > size_) {
+            return fail(path + ": size does not match header");
+        }
+        detail::UniverseLayout layout(header_->instrument_count, header_->underlyer_count, 0);
+        if (layout.strings > size_ || header_->string_bytes != size_ - layout.strings) {
+            return fail(path + ": size does not match header");
+        }
+        const size_t string_bytes = size_ - layout.strings;
+        columns_ = reinterpret_cast<const double*>(data_ + layout.columns);
+        underlyer_ = reinterpret_cast<const uint32_t*>(data_ + layout.underlyer);
+        symbol_offset_ = reinterpret_cast<const uint32_t*>(data_ + layout.symbol_offset);
+        underlyer_offset_ = reinterpret_cast<const uint32_t*>(data_ + layout.underlyer_offset);
+        strings_ = data_ + layout.strings;
+
+        if (!offsets_valid(symbol_offset_, size(), string_bytes) ||
+            !offsets_valid(underlyer_offset_, underlyer_count(), string_bytes)) {
+            return fail(path + ": string offset out of range");
+        }
+        for (size_t i = 0; i < size(); ++i) {
+            if (underlyer_[i] >= underlyer_count()) {
+                return fail(path + ": underlyer index out of range");
+            }
+        }
+        return true;
+    }
+
+    void close() {
+#if defined(__linux__)
+        if (mapped_) ::munmap(const_cast<char*>(data_), size_);
+#endif
+        buffer_.clear();
+        data_ = nullptr;
+        size_ = 0;
+        mapped_ = false;
+        header_ = nullptr;
+        error_.clear();
+    }
+
+    bool is_open() const { return header_ != nullptr; }
+    const std::string& error() const { return error_; }
+
+    // ========================================================================
+    // Zero-copy access (rows in file order)
+    // ========================================================================
+
+    size_t size() const { return header_ ? header_->instrument_count : 0; }
+    size_t underlyer_count() const { return header_ ? header_->underlyer_count : 0; }
+
+    const double* spot_prices() const { return column(0); }
+    const double* fx_rates() const { return column(1); }
+    const double* contract_sizes() const { return column(2); }
+    const double* underlyer_spots() const { return column(3); }
+    const double* deltas() const { return column(4); }
+    const double* vegas() const { return column(5); }
+
+    std::string_view symbol(size_t row) const {
+        return std::string_view(strings_ + symbol_offset_[row], symbol_offset_[row + 1] - symbol_offset_[row]);
+    }
+
+    // Index of the row's underlyer in [0, underlyer_count())
+    uint32_t underlyer_index(size_t row) const { return underlyer_[row]; }
+
+    std::string_view underlyer_name(uint32_t index) const {
+        return std::string_view(strings_ + underlyer_offset_[index],
+                                underlyer_offset_[index + 1] - underlyer_offset_[index]);
+    }
+
+    std::string_view underlyer(size_t row) const { return underlyer_name(underlyer_[row]); }
+
+    double contract_size(size_t row) const { return contract_sizes()[row]; }
+
+    PricingInputs pricing_inputs(size_t row) const {
+        return PricingInputs{spot_prices()[row], fx_rates()[row], contract_sizes()[row],
+                             underlyer_spots()[row], deltas()[row], vegas()[row]};
+    }
+};
+
+// ============================================================================
+// Loader
+// ============================================================================
+
+// Add every instrument of file to table; rows keep the file's order, so a
+// table empty beforehand gets InstrumentId == row
+inline void load_universe(const UniverseFile& file, InstrumentTable& table) {
+    auto& symbols = aggregation::SymbolInterner::instance();
+    auto& underlyer_names = aggregation::UnderlyerInterner::instance();
+
+    std::vector<aggregation::InternedId> underlyers(file.underlyer_count());
+    for (uint32_t u = 0; u < underlyers.size(); ++u) {
+        underlyers[u] = underlyer_names.intern(file.underlyer_name(u));
+    }
+
+    table.reserve(table.size() + file.size());
+    for (size_t row = 0; row < file.size(); ++row) {
+        table.add(symbols.intern(file.symbol(row)), underlyers[file.underlyer_index(row)],
+                  file.pricing_inputs(row));
+    }
+}
+
+} // namespace instrument
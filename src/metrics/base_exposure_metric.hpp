@@ -4,13 +4,17 @@
 #include "../aggregation/aggregation_core.hpp"
 #include "../aggregation/key_extractors.hpp"
 #include "../aggregation/container_types.hpp"
+#include "../aggregation/order_slot_table.hpp"
+#include "../aggregation/limit_check_table.hpp"
 #include "../fix/fix_messages.hpp"
 #include "metric_policies.hpp"
+#include "order_input_table.hpp"
 #include <cmath>
 
 // Forward declarations
 namespace engine {
     struct TrackedOrder;
+    struct OrderIds;
     enum class OrderState;
     enum class LimitType;
 }
@@ -28,11 +32,15 @@ namespace metrics {
 //   Key: The grouping key type (GlobalKey, UnderlyerKey, etc.)
 //   Context: Type providing accessor methods for instrument properties
 //   Instrument: The instrument type
-//   InputPolicy: Defines StoredInputs and capture/compute methods
+//   InputPolicy: Defines the inputs it reads and how exposure is computed
 //   ValuePolicy: Defines how to derive final value (gross vs net)
 //   LimitTypeVal: The engine::LimitType value for this metric
 //   Stages...: Stage types to track (PositionStage, OpenStage, InFlightStage, or AllStages)
 //
+// Inputs captured per order live in the engine's OrderInputTable, shared by
+// all exposure metrics of the engine and bound at construction; a metric
+// must be bound before it handles events.
+//
 
 template<typename Key, typename Context, typename Instrument,
          typename InputPolicy, typename ValuePolicy,
@@ -47,9 +55,6 @@ public:
     using value_policy = ValuePolicy;
     using Config = aggregation::StageConfig<Stages...>;
 
-    // Type alias for stored inputs from the input policy
-    using StoredInputs = typename InputPolicy::StoredInputs;
-
     // ========================================================================
     // Static methods for pre-trade limit checking
     // ========================================================================
@@ -59,8 +64,17 @@ public:
     static double compute_order_contribution(const fix::NewOrderSingle& order,
                                              const Inst& instrument,
                                              const Ctx& context) {
-        double exposure = InputPolicy::compute_from_context(context, instrument, order.quantity, order.side);
-        return ValuePolicy::compute_from_exposure(exposure, order.side);
+        return compute_quantity_contribution(order.quantity, order.side, instrument, context);
+    }
+
+    // Contribution of an order for quantity on side; linear in quantity, so
+    // limits can be solved for the largest quantity that fits
+    template<typename Ctx, typename Inst>
+    static double compute_quantity_contribution(int64_t quantity, fix::Side side,
+                                                const Inst& instrument,
+                                                const Ctx& context) {
+        double exposure = InputPolicy::compute_from_context(context, instrument, quantity, side);
+        return ValuePolicy::compute_from_exposure(exposure, side);
     }
 
     // Compute the contribution for an order update (new - old)
@@ -79,20 +93,20 @@ public:
         return new_value - old_value;
     }
 
-    // Extract the key from a NewOrderSingle
+    // Extract the key from a NewOrderSingle (lookup only, never interns)
     static Key extract_key(const fix::NewOrderSingle& order) {
         if constexpr (std::is_same_v<Key, aggregation::GlobalKey>) {
             return aggregation::GlobalKey::instance();
         } else if constexpr (std::is_same_v<Key, aggregation::UnderlyerKey>) {
-            return Key{order.underlyer};
+            return Key::lookup(order.underlyer);
         } else if constexpr (std::is_same_v<Key, aggregation::InstrumentKey>) {
-            return Key{order.symbol};
+            return Key::lookup(order.symbol);
         } else if constexpr (std::is_same_v<Key, aggregation::StrategyKey>) {
-            return Key{order.strategy_id};
+            return Key::lookup(order.strategy_id);
         } else if constexpr (std::is_same_v<Key, aggregation::PortfolioKey>) {
-            return Key{order.portfolio_id};
+            return Key::lookup(order.portfolio_id);
         } else if constexpr (std::is_same_v<Key, aggregation::PortfolioInstrumentKey>) {
-            return Key{order.portfolio_id, order.symbol};
+            return Key::lookup(order.portfolio_id, order.symbol);
         } else {
             static_assert(sizeof(Key) == 0, "Unsupported key type for BaseExposureMetric");
         }
@@ -103,32 +117,111 @@ public:
         return LimitTypeVal;
     }
 
+    // ========================================================================
+    // Prepared new orders (combined check-and-add, see has_prepare_order)
+    // ========================================================================
+
+    // Key and value of a new order; value is both the contribution checked
+    // against the limit and what on_order_added() adds. The inputs are
+    // captured once for all metrics by the engine (see OrderInputTable).
+    struct PreparedOrder {
+        Key key;
+        double value;
+    };
+
+    static PreparedOrder prepare_order(const fix::NewOrderSingle& order,
+                                       const engine::OrderIds& ids,
+                                       const InputSnapshot& inputs) {
+        return PreparedOrder{aggregation::KeyExtractor<Key>::extract(ids, order.side),
+                             compute_value(inputs, order.quantity, order.side)};
+    }
+
 private:
+    // Per-stage bookkeeping; the values themselves are co-located per key
+    // in values_
     struct StageData {
-        aggregation::AggregationBucket<Key, aggregation::SumCombiner<double>> value;
-        // Track quantities per instrument for position recomputation (only for notional)
-        aggregation::HashMap<std::string, int64_t> instrument_quantities;
-        // cl_ord_id -> (key, stored_inputs) for drift-free removal
-        aggregation::HashMap<std::string, std::pair<Key, StoredInputs>> order_inputs;
+        // Track quantities per instrument (interned symbol) for position recomputation (only for notional)
+        aggregation::HashMap<aggregation::InternedId, int64_t> instrument_quantities;
+        // order slot -> key of the orders in this stage; their inputs are
+        // in the OrderInputTable
+        aggregation::OrderSlotTable<Key> order_keys;
+
+        explicit StageData(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+            : instrument_quantities(resource), order_keys(resource) {}
+
+        void reserve(const aggregation::CapacityHints& hints) {
+            order_keys.reserve(hints.orders);
+        }
 
         void clear() {
-            value.clear();
             instrument_quantities.clear();
-            order_inputs.clear();
+            order_keys.clear();
         }
     };
 
     using Storage = aggregation::StagedMetric<StageData, Stages...>;
 
     Storage storage_;
+    // All stage values of a key in one record, plus its cached limit
+    aggregation::LimitCheckTable<Key, double, Stages...> values_;
+    OrderInputTable* inputs_ = nullptr;
 
     Key extract_order_key(const engine::TrackedOrder& order) const {
         return aggregation::KeyExtractor<Key>::extract(order);
     }
 
-    // Compute value from stored inputs using the value policy
-    double compute_value(const StoredInputs& inputs) const {
-        return ValuePolicy::compute(inputs);
+    // Index of the order in StageData::order_keys and the OrderInputTable
+    static uint32_t order_slot(const engine::TrackedOrder& order) {
+        return order.handle.index;
+    }
+
+    // Drop a previous order in this slot from any stage (it was cleaned up
+    // without being removed from every stage); returns the stage new orders
+    // go to, if tracked
+    StageData* claim_order_slot(const engine::TrackedOrder& order) {
+        uint32_t slot = order_slot(order);
+        storage_.for_each_stage([slot](aggregation::OrderStage /*stage*/, StageData& data) {
+            data.order_keys.reset(slot);
+        });
+        return storage_.get_stage(aggregation::OrderStage::IN_FLIGHT);
+    }
+
+    // Take old_val out of old_stage and put new_val into new_stage (each if
+    // applicable); one record update when both apply
+    void shift_value(const Key& key,
+                     bool has_old, aggregation::OrderStage old_stage, double old_val,
+                     bool has_new, aggregation::OrderStage new_stage, double new_val) {
+        if (has_old && has_new) {
+            values_.move(key, old_stage, old_val, new_stage, new_val);
+        } else if (has_old) {
+            values_.remove(old_stage, key, old_val);
+        } else if (has_new) {
+            values_.add(new_stage, key, new_val);
+        }
+    }
+
+    // Inputs the order was stored with, if this metric holds it in data's stage
+    const OrderInputs* stored_inputs(const StageData& data, uint32_t slot) const {
+        return data.order_keys.find(slot) != nullptr ? inputs_->stored(slot) : nullptr;
+    }
+
+    // Value of the stored order, or of quantity of it
+    double stored_value(const OrderInputs& stored) const {
+        return compute_value(inputs_->snapshot(stored), stored.quantity, stored.side);
+    }
+
+    double stored_value(const OrderInputs& stored, int64_t quantity) const {
+        return compute_value(inputs_->snapshot(stored), quantity, stored.side);
+    }
+
+    // Value at the event's current inputs
+    double current_value(const Context& ctx, const Instrument& inst, int64_t quantity, fix::Side side) {
+        return compute_value(inputs_->current(ctx, inst), quantity, side);
+    }
+
+    // Compute value from captured inputs using the value policy
+    static double compute_value(const InputSnapshot& inputs, int64_t quantity, fix::Side side) {
+        return ValuePolicy::compute_from_exposure(InputPolicy::compute_exposure(inputs, quantity), side);
     }
 
     // Compute value from context (fallback)
@@ -139,36 +232,62 @@ private:
     }
 
 public:
-    BaseExposureMetric() = default;
+    explicit BaseExposureMetric(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : storage_(resource), values_(resource) {}
+
+    // Pre-size buckets and stored inputs (see aggregation/capacity_hints.hpp)
+    void reserve(const aggregation::CapacityHints& hints) {
+        storage_.reserve(hints);
+        values_.reserve(hints);
+    }
+
+    // Per-order inputs are kept by the engine for all exposure metrics
+    using order_inputs_type = OrderInputTable;
+
+    void bind_order_inputs(OrderInputTable& inputs) {
+        inputs_ = &inputs;
+        inputs_->require(InputPolicy::fields);
+    }
+
+    // Metrics with the same Key share one values table per engine, one
+    // column each (see GenericRiskAggregationEngine); bound at construction
+    using shared_table_type = typename aggregation::LimitCheckTable<Key, double, Stages...>::table_type;
+
+    void bind_shared_table(shared_table_type& table) {
+        values_.bind(table);
+    }
 
     // ========================================================================
     // Accessors
     // ========================================================================
 
+    // Sum over all tracked stages - one lookup
     double get(const Key& key) const {
-        double total = 0.0;
-        storage_.for_each_stage([&key, &total](aggregation::OrderStage /*stage*/, const StageData& data) {
-            total += data.value.get(key);
-        });
-        return total;
+        return values_.total(key);
+    }
+
+    // get(key) and the key's limit in limits, in one probe (see LimitCheckTable)
+    template<typename Limits>
+    aggregation::LimitUsage limit_usage(const Key& key, const Limits& limits) const {
+        return values_.usage(key, limits, Config::track_position, Config::track_open, Config::track_in_flight);
     }
 
     template<typename Dummy = void>
     std::enable_if_t<Storage::Config::track_open && std::is_void_v<Dummy>, double>
     get_open(const Key& key) const {
-        return storage_.open().value.get(key);
+        return values_.get(aggregation::OrderStage::OPEN, key);
     }
 
     template<typename Dummy = void>
     std::enable_if_t<Storage::Config::track_in_flight && std::is_void_v<Dummy>, double>
     get_in_flight(const Key& key) const {
-        return storage_.in_flight().value.get(key);
+        return values_.get(aggregation::OrderStage::IN_FLIGHT, key);
     }
 
     template<typename Dummy = void>
     std::enable_if_t<Storage::Config::track_position && std::is_void_v<Dummy>, double>
     get_position(const Key& key) const {
-        return storage_.position().value.get(key);
+        return values_.get(aggregation::OrderStage::POSITION, key);
     }
 
     // ========================================================================
@@ -184,21 +303,22 @@ public:
         Key key = aggregation::GlobalKey::instance();
         auto* pos_data = storage_.get_stage(aggregation::OrderStage::POSITION);
         if (!pos_data) return;
+        aggregation::InternedId symbol_id = aggregation::SymbolInterner::instance().intern(symbol);
 
         // Remove old contribution if exists
-        auto it = pos_data->instrument_quantities.find(symbol);
+        auto it = pos_data->instrument_quantities.find(symbol_id);
         if (it != pos_data->instrument_quantities.end()) {
             // Compute old value based on ValuePolicy type
             fix::Side old_side = (it->second >= 0) ? fix::Side::BID : fix::Side::ASK;
             double old_val = compute_value_from_context(context, instrument, std::abs(it->second), old_side);
-            pos_data->value.remove(key, old_val);
+            values_.remove(aggregation::OrderStage::POSITION, key, old_val);
         }
 
         // Add new contribution
         fix::Side new_side = (signed_quantity >= 0) ? fix::Side::BID : fix::Side::ASK;
         double new_val = compute_value_from_context(context, instrument, std::abs(signed_quantity), new_side);
-        pos_data->value.add(key, new_val);
-        pos_data->instrument_quantities[symbol] = signed_quantity;
+        values_.add(aggregation::OrderStage::POSITION, key, new_val);
+        pos_data->instrument_quantities[symbol_id] = signed_quantity;
     }
 
     // ========================================================================
@@ -207,14 +327,21 @@ public:
 
     void on_order_added(const engine::TrackedOrder& order, const Instrument& instrument, const Context& context) {
         if (!aggregation::KeyExtractor<Key>::is_applicable(order)) return;
-        Key key = extract_order_key(order);
-        auto* stage_data = storage_.get_stage(aggregation::OrderStage::IN_FLIGHT);
-        if (stage_data) {
-            // Capture and store inputs for drift-free removal
-            StoredInputs inputs = InputPolicy::capture(context, instrument, order.leaves_qty, order.side);
-            double val = compute_value(inputs);
-            stage_data->value.add(key, val);
-            stage_data->order_inputs[order.key.cl_ord_id] = {key, inputs};
+        if (auto* stage_data = claim_order_slot(order)) {
+            // Inputs are stored by the engine for drift-free removal
+            Key key = extract_order_key(order);
+            values_.add(aggregation::OrderStage::IN_FLIGHT, key,
+                        current_value(context, instrument, order.leaves_qty, order.side));
+            stage_data->order_keys.assign(order_slot(order), key);
+        }
+    }
+
+    // Same as above, with the key and value from prepare_order()
+    void on_order_added(const engine::TrackedOrder& order, const PreparedOrder& prepared) {
+        if (!aggregation::KeyExtractor<Key>::is_applicable(order)) return;
+        if (auto* stage_data = claim_order_slot(order)) {
+            values_.add(aggregation::OrderStage::IN_FLIGHT, prepared.key, prepared.value);
+            stage_data->order_keys.assign(order_slot(order), prepared.key);
         }
     }
 
@@ -228,12 +355,11 @@ public:
         if (!stage_data) return;
 
         // Use stored inputs for drift-free removal
-        auto it = stage_data->order_inputs.find(order.key.cl_ord_id);
-        if (it != stage_data->order_inputs.end()) {
-            Key key = it->second.first;
-            double val = compute_value(it->second.second);
-            stage_data->value.remove(key, val);
-            stage_data->order_inputs.erase(it);
+        uint32_t slot = order_slot(order);
+        if (auto* key = stage_data->order_keys.find(slot)) {
+            double val = stored_value(*inputs_->stored(slot));
+            values_.remove(stage, *key, val);
+            stage_data->order_keys.reset(slot);
         }
     }
 
@@ -246,23 +372,20 @@ public:
 
         Key key = extract_order_key(order);
 
-        // Remove old contribution using stored inputs (or fallback to old_qty if key changed)
-        auto it = stage_data->order_inputs.find(order.key.cl_ord_id);
-        if (it != stage_data->order_inputs.end()) {
-            double old_val = compute_value(it->second.second);
-            stage_data->value.remove(key, old_val);
-            stage_data->order_inputs.erase(it);
+        // Old contribution from stored inputs (the slot survives a ClOrdID
+        // change); fall back to old_qty if nothing was stored
+        uint32_t slot = order_slot(order);
+        double old_val;
+        if (auto* stored = stored_inputs(*stage_data, slot)) {
+            old_val = stored_value(*stored);
         } else {
-            // Fallback for key change during replace: use old_qty with current context
-            double old_val = compute_value_from_context(context, instrument, old_qty, order.side);
-            stage_data->value.remove(key, old_val);
+            old_val = compute_value_from_context(context, instrument, old_qty, order.side);
         }
 
-        // Add new contribution with current inputs
-        StoredInputs new_inputs = InputPolicy::capture(context, instrument, order.leaves_qty, order.side);
-        double new_val = compute_value(new_inputs);
-        stage_data->value.add(key, new_val);
-        stage_data->order_inputs[order.key.cl_ord_id] = {key, new_inputs};
+        // Swap in the new contribution with current inputs
+        double new_val = current_value(context, instrument, order.leaves_qty, order.side);
+        values_.move(key, stage, old_val, stage, new_val);
+        stage_data->order_keys.assign(slot, key);
     }
 
     void on_partial_fill(const engine::TrackedOrder& order, const Instrument& instrument, const Context& context, int64_t filled_qty) {
@@ -271,23 +394,19 @@ public:
 
         auto* open_data = storage_.get_stage(aggregation::OrderStage::OPEN);
         if (open_data) {
-            // Use stored inputs for drift-free removal (proportional)
-            auto it = open_data->order_inputs.find(order.key.cl_ord_id);
-            if (it != open_data->order_inputs.end()) {
-                StoredInputs& stored = it->second.second;
-                StoredInputs filled_inputs = stored.with_quantity(filled_qty);
-                double filled_val = compute_value(filled_inputs);
-                open_data->value.remove(key, filled_val);
-                stored.quantity -= filled_qty;  // Update stored quantity
+            // Use stored inputs for drift-free removal (proportional); the
+            // engine takes the fill off the stored quantity afterwards
+            if (auto* stored = stored_inputs(*open_data, order_slot(order))) {
+                double filled_val = stored_value(*stored, filled_qty);
+                values_.remove(aggregation::OrderStage::OPEN, key, filled_val);
             }
         }
 
         auto* pos_data = storage_.get_stage(aggregation::OrderStage::POSITION);
         if (pos_data) {
             // Add to position with CURRENT inputs
-            StoredInputs pos_inputs = InputPolicy::capture(context, instrument, filled_qty, order.side);
-            double pos_val = compute_value(pos_inputs);
-            pos_data->value.add(key, pos_val);
+            double pos_val = current_value(context, instrument, filled_qty, order.side);
+            values_.add(aggregation::OrderStage::POSITION, key, pos_val);
         }
     }
 
@@ -298,9 +417,8 @@ public:
         auto* pos_data = storage_.get_stage(aggregation::OrderStage::POSITION);
         if (pos_data) {
             // Add to position with CURRENT inputs
-            StoredInputs pos_inputs = InputPolicy::capture(context, instrument, filled_qty, order.side);
-            double filled_val = compute_value(pos_inputs);
-            pos_data->value.add(key, filled_val);
+            double filled_val = current_value(context, instrument, filled_qty, order.side);
+            values_.add(aggregation::OrderStage::POSITION, key, filled_val);
         }
     }
 
@@ -320,23 +438,26 @@ public:
         auto* old_data = storage_.get_stage(old_stage);
         auto* new_data = storage_.get_stage(new_stage);
 
+        uint32_t slot = order_slot(order);
+
         // Remove from old stage using stored inputs
+        bool has_old = false;
+        double old_val = 0.0;
         if (old_data) {
-            auto it = old_data->order_inputs.find(order.key.cl_ord_id);
-            if (it != old_data->order_inputs.end()) {
-                double old_val = compute_value(it->second.second);
-                old_data->value.remove(key, old_val);
-                old_data->order_inputs.erase(it);
+            if (auto* stored = stored_inputs(*old_data, slot)) {
+                old_val = stored_value(*stored);
+                old_data->order_keys.reset(slot);
+                has_old = true;
             }
         }
 
         // Add to new stage with CURRENT inputs
+        double new_val = 0.0;
         if (new_data) {
-            StoredInputs new_inputs = InputPolicy::capture(context, instrument, order.leaves_qty, order.side);
-            double new_val = compute_value(new_inputs);
-            new_data->value.add(key, new_val);
-            new_data->order_inputs[order.key.cl_ord_id] = {key, new_inputs};
+            new_val = current_value(context, instrument, order.leaves_qty, order.side);
+            new_data->order_keys.assign(slot, key);
         }
+        shift_value(key, has_old, old_stage, old_val, new_data != nullptr, new_stage, new_val);
     }
 
     void on_order_updated_with_state_change(const engine::TrackedOrder& order,
@@ -354,31 +475,31 @@ public:
         auto* old_data = storage_.get_stage(old_stage);
         auto* new_data = storage_.get_stage(new_stage);
 
-        // Remove from old stage using stored inputs (or fallback to old_qty if key changed)
+        uint32_t slot = order_slot(order);
+
+        // Remove from old stage using stored inputs (or fallback to old_qty if nothing was stored)
+        double old_val = 0.0;
         if (old_data) {
-            auto it = old_data->order_inputs.find(order.key.cl_ord_id);
-            if (it != old_data->order_inputs.end()) {
-                double old_val = compute_value(it->second.second);
-                old_data->value.remove(key, old_val);
-                old_data->order_inputs.erase(it);
+            if (auto* stored = stored_inputs(*old_data, slot)) {
+                old_val = stored_value(*stored);
+                old_data->order_keys.reset(slot);
             } else {
-                // Fallback for key change during replace: use old_qty with current context
-                double old_val = compute_value_from_context(context, instrument, old_qty, order.side);
-                old_data->value.remove(key, old_val);
+                old_val = compute_value_from_context(context, instrument, old_qty, order.side);
             }
         }
 
         // Add to new stage with CURRENT inputs
+        double new_val = 0.0;
         if (new_data) {
-            StoredInputs new_inputs = InputPolicy::capture(context, instrument, order.leaves_qty, order.side);
-            double new_val = compute_value(new_inputs);
-            new_data->value.add(key, new_val);
-            new_data->order_inputs[order.key.cl_ord_id] = {key, new_inputs};
+            new_val = current_value(context, instrument, order.leaves_qty, order.side);
+            new_data->order_keys.assign(slot, key);
         }
+        shift_value(key, old_data != nullptr, old_stage, old_val, new_data != nullptr, new_stage, new_val);
     }
 
     void clear() {
         storage_.clear();
+        values_.clear();
     }
 };
 
@@ -8,12 +8,70 @@
 namespace metrics {
 
 // ============================================================================
-// Input Policies - Define how to capture and compute exposure from context
+// InputSnapshot - Pricing inputs of an instrument at one point in time
+// ============================================================================
+//
+// One record holds everything any InputPolicy reads, so exposure metrics of
+// different kinds (delta, vega, notional; gross and net) share the inputs
+// captured for an order instead of each keeping their own copy. Orders refer
+// to an interned snapshot rather than holding one (see OrderInputTable).
+// Only the fields in the given mask are read from the context, in one
+// pricing_inputs() call if it has one (see instrument::PricingInputs); the
+// others stay zero.
+//
+
+struct InputSnapshot {
+    // Field mask bits
+    static constexpr uint8_t CONTRACT_SIZE = 1 << 0;
+    static constexpr uint8_t SPOT_PRICE = 1 << 1;
+    static constexpr uint8_t UNDERLYER_SPOT = 1 << 2;
+    static constexpr uint8_t FX_RATE = 1 << 3;
+    static constexpr uint8_t DELTA = 1 << 4;
+    static constexpr uint8_t VEGA = 1 << 5;
+
+    double contract_size = 0.0;
+    double spot_price = 0.0;
+    double underlyer_spot = 0.0;
+    double fx_rate = 0.0;
+    double delta = 0.0;
+    double vega = 0.0;
+
+    template<typename Context, typename Instrument>
+    static InputSnapshot capture(const Context& ctx, const Instrument& inst, uint8_t fields) {
+        InputSnapshot inputs;
+        if constexpr (instrument::has_context_pricing_inputs_v<Context, Instrument>) {
+            const instrument::PricingInputs in = ctx.pricing_inputs(inst);
+            if (fields & CONTRACT_SIZE) inputs.contract_size = in.contract_size;
+            if (fields & SPOT_PRICE) inputs.spot_price = in.spot_price;
+            if (fields & FX_RATE) inputs.fx_rate = in.fx_rate;
+            if (fields & UNDERLYER_SPOT) inputs.underlyer_spot = in.underlyer_spot;
+            if (fields & DELTA) inputs.delta = in.delta;
+            if (fields & VEGA) inputs.vega = in.vega;
+        } else {
+            if (fields & CONTRACT_SIZE) inputs.contract_size = ctx.contract_size(inst);
+            if (fields & SPOT_PRICE) inputs.spot_price = ctx.spot_price(inst);
+            if (fields & FX_RATE) inputs.fx_rate = ctx.fx_rate(inst);
+            if constexpr (instrument::has_context_underlyer_spot_v<Context, Instrument>) {
+                if (fields & UNDERLYER_SPOT) inputs.underlyer_spot = ctx.underlyer_spot(inst);
+            }
+            if constexpr (instrument::has_context_delta_v<Context, Instrument>) {
+                if (fields & DELTA) inputs.delta = ctx.delta(inst);
+            }
+            if constexpr (instrument::has_context_vega_v<Context, Instrument>) {
+                if (fields & VEGA) inputs.vega = ctx.vega(inst);
+            }
+        }
+        return inputs;
+    }
+};
+
+// ============================================================================
+// Input Policies - Define how to compute exposure from inputs or context
 // ============================================================================
 //
 // Each InputPolicy defines:
-// - StoredInputs: what to capture from context (for drift-free tracking)
-// - capture(): how to build StoredInputs from context
+// - fields: the InputSnapshot fields it reads
+// - compute_exposure(): exposure of a quantity at captured inputs (for drift-free tracking)
 // - compute_from_context(): fallback computation using current context values
 // - supports_position_set: whether set_instrument_position is supported (default false)
 //
@@ -25,34 +83,11 @@ namespace metrics {
 template<typename Context, typename Instrument>
 struct DeltaInputPolicy {
     static constexpr bool supports_position_set = false;
+    static constexpr uint8_t fields =
+        InputSnapshot::DELTA | InputSnapshot::CONTRACT_SIZE | InputSnapshot::UNDERLYER_SPOT | InputSnapshot::FX_RATE;
 
-    struct StoredInputs {
-        int64_t quantity;
-        double delta;
-        double contract_size;
-        double underlyer_spot;
-        double fx_rate;
-        fix::Side side;
-
-        double compute_exposure() const {
-            return static_cast<double>(quantity) * delta * contract_size * underlyer_spot * fx_rate;
-        }
-
-        StoredInputs with_quantity(int64_t new_qty) const {
-            return StoredInputs{new_qty, delta, contract_size, underlyer_spot, fx_rate, side};
-        }
-    };
-
-    static StoredInputs capture(const Context& ctx, const Instrument& inst,
-                                int64_t quantity, fix::Side side) {
-        return StoredInputs{
-            quantity,
-            ctx.delta(inst),
-            ctx.contract_size(inst),
-            ctx.underlyer_spot(inst),
-            ctx.fx_rate(inst),
-            side
-        };
+    static double compute_exposure(const InputSnapshot& in, int64_t quantity) {
+        return static_cast<double>(quantity) * in.delta * in.contract_size * in.underlyer_spot * in.fx_rate;
     }
 
     static double compute_from_context(const Context& ctx, const Instrument& inst,
@@ -68,34 +103,11 @@ struct DeltaInputPolicy {
 template<typename Context, typename Instrument>
 struct VegaInputPolicy {
     static constexpr bool supports_position_set = false;
+    static constexpr uint8_t fields =
+        InputSnapshot::VEGA | InputSnapshot::CONTRACT_SIZE | InputSnapshot::UNDERLYER_SPOT | InputSnapshot::FX_RATE;
 
-    struct StoredInputs {
-        int64_t quantity;
-        double vega;
-        double contract_size;
-        double underlyer_spot;
-        double fx_rate;
-        fix::Side side;
-
-        double compute_exposure() const {
-            return static_cast<double>(quantity) * vega * contract_size * underlyer_spot * fx_rate;
-        }
-
-        StoredInputs with_quantity(int64_t new_qty) const {
-            return StoredInputs{new_qty, vega, contract_size, underlyer_spot, fx_rate, side};
-        }
-    };
-
-    static StoredInputs capture(const Context& ctx, const Instrument& inst,
-                                int64_t quantity, fix::Side side) {
-        return StoredInputs{
-            quantity,
-            ctx.vega(inst),
-            ctx.contract_size(inst),
-            ctx.underlyer_spot(inst),
-            ctx.fx_rate(inst),
-            side
-        };
+    static double compute_exposure(const InputSnapshot& in, int64_t quantity) {
+        return static_cast<double>(quantity) * in.vega * in.contract_size * in.underlyer_spot * in.fx_rate;
     }
 
     static double compute_from_context(const Context& ctx, const Instrument& inst,
@@ -115,32 +127,11 @@ struct VegaInputPolicy {
 template<typename Context, typename Instrument>
 struct NotionalInputPolicy {
     static constexpr bool supports_position_set = true;
+    static constexpr uint8_t fields =
+        InputSnapshot::CONTRACT_SIZE | InputSnapshot::SPOT_PRICE | InputSnapshot::FX_RATE;
 
-    struct StoredInputs {
-        int64_t quantity;
-        double contract_size;
-        double spot_price;
-        double fx_rate;
-        fix::Side side;
-
-        double compute_exposure() const {
-            return static_cast<double>(quantity) * contract_size * spot_price * fx_rate;
-        }
-
-        StoredInputs with_quantity(int64_t new_qty) const {
-            return StoredInputs{new_qty, contract_size, spot_price, fx_rate, side};
-        }
-    };
-
-    static StoredInputs capture(const Context& ctx, const Instrument& inst,
-                                int64_t quantity, fix::Side side) {
-        return StoredInputs{
-            quantity,
-            ctx.contract_size(inst),
-            ctx.spot_price(inst),
-            ctx.fx_rate(inst),
-            side
-        };
+    static double compute_exposure(const InputSnapshot& in, int64_t quantity) {
+        return static_cast<double>(quantity) * in.contract_size * in.spot_price * in.fx_rate;
     }
 
     static double compute_from_context(const Context& ctx, const Instrument& inst,
@@ -155,12 +146,6 @@ struct NotionalInputPolicy {
 
 // GrossValuePolicy - Returns absolute value of exposure
 struct GrossValuePolicy {
-    template<typename StoredInputs>
-    static double compute(const StoredInputs& inputs) {
-        return std::abs(inputs.compute_exposure());
-    }
-
-    // For pre-trade check contribution calculation
     static double compute_from_exposure(double exposure, fix::Side /*side*/) {
         return std::abs(exposure);
     }
@@ -168,13 +153,6 @@ struct GrossValuePolicy {
 
 // NetValuePolicy - Returns signed value based on side (BID = positive, ASK = negative)
 struct NetValuePolicy {
-    template<typename StoredInputs>
-    static double compute(const StoredInputs& inputs) {
-        double exp = inputs.compute_exposure();
-        return (inputs.side == fix::Side::BID) ? exp : -exp;
-    }
-
-    // For pre-trade check contribution calculation
     static double compute_from_exposure(double exposure, fix::Side side) {
         return (side == fix::Side::BID) ? exposure : -exposure;
     }
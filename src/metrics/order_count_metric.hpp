@@ -4,8 +4,8 @@
 #include "../aggregation/aggregation_core.hpp"
 #include "../aggregation/key_extractors.hpp"
 #include "../aggregation/container_types.hpp"
+#include "../aggregation/limit_check_table.hpp"
 #include "../fix/fix_types.hpp"
-#include <unordered_set>
 
 // Forward declarations
 namespace engine {
@@ -94,20 +94,20 @@ public:
         return 0;
     }
 
-    // Extract the key from a NewOrderSingle
+    // Extract the key from a NewOrderSingle (lookup only, never interns)
     static Key extract_key(const fix::NewOrderSingle& order) {
         if constexpr (std::is_same_v<Key, aggregation::InstrumentSideKey>) {
-            return Key{order.symbol, static_cast<int>(order.side)};
+            return Key::lookup(order.symbol, static_cast<int>(order.side));
         } else if constexpr (std::is_same_v<Key, aggregation::InstrumentKey>) {
-            return Key{order.symbol};
+            return Key::lookup(order.symbol);
         } else if constexpr (std::is_same_v<Key, aggregation::GlobalKey>) {
             return aggregation::GlobalKey::instance();
         } else if constexpr (std::is_same_v<Key, aggregation::UnderlyerKey>) {
-            return Key{order.underlyer};
+            return Key::lookup(order.underlyer);
         } else if constexpr (std::is_same_v<Key, aggregation::StrategyKey>) {
-            return Key{order.strategy_id};
+            return Key::lookup(order.strategy_id);
         } else if constexpr (std::is_same_v<Key, aggregation::PortfolioKey>) {
-            return Key{order.portfolio_id};
+            return Key::lookup(order.portfolio_id);
         } else {
             static_assert(sizeof(Key) == 0, "Unsupported key type for OrderCountMetric");
         }
@@ -119,12 +119,24 @@ public:
     }
 
 private:
-    using Bucket = aggregation::AggregationBucket<Key, aggregation::CountCombiner>;
-    using Storage = aggregation::StagedMetric<Bucket, Stages...>;
-
-    Storage storage_;
+    // All stage counts of a key in one record, plus its cached limit
+    aggregation::LimitCheckTable<Key, int64_t, Stages...> counts_;
 
 public:
+    explicit OrderCountMetric(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : counts_(resource) {}
+
+    void reserve(const aggregation::CapacityHints& hints) {
+        counts_.reserve(hints);
+    }
+
+    // Shared with other order counts of the same Key (see BaseExposureMetric)
+    using shared_table_type = typename aggregation::LimitCheckTable<Key, int64_t, Stages...>::table_type;
+
+    void bind_shared_table(shared_table_type& table) {
+        counts_.bind(table);
+    }
+
     // ========================================================================
     // Configuration info
     // ========================================================================
@@ -143,67 +155,37 @@ public:
 
     // Get count for a key (combined open + in-flight, excluding position)
     int64_t get(const Key& key) const {
-        int64_t total = 0;
-        if constexpr (Config::track_open) {
-            total += storage_.open().get(key);
-        }
-        if constexpr (Config::track_in_flight) {
-            total += storage_.in_flight().get(key);
-        }
-        return total;
+        return counts_.sum(key, false, Config::track_open, Config::track_in_flight);
+    }
+
+    // get(key) and the key's limit in limits, in one probe (see LimitCheckTable)
+    template<typename Limits>
+    aggregation::LimitUsage limit_usage(const Key& key, const Limits& limits) const {
+        return counts_.usage(key, limits, false, Config::track_open, Config::track_in_flight);
     }
 
     // Get count including all tracked stages
     int64_t get_total(const Key& key) const {
-        int64_t total = 0;
-        if constexpr (Config::track_position) {
-            total += storage_.position().get(key);
-        }
-        if constexpr (Config::track_open) {
-            total += storage_.open().get(key);
-        }
-        if constexpr (Config::track_in_flight) {
-            total += storage_.in_flight().get(key);
-        }
-        return total;
+        return counts_.total(key);
     }
 
     // Per-stage accessors
     template<typename Dummy = void>
     std::enable_if_t<Config::track_position && std::is_void_v<Dummy>, int64_t>
     get_position(const Key& key) const {
-        return storage_.position().get(key);
+        return counts_.get(aggregation::OrderStage::POSITION, key);
     }
 
     template<typename Dummy = void>
     std::enable_if_t<Config::track_open && std::is_void_v<Dummy>, int64_t>
     get_open(const Key& key) const {
-        return storage_.open().get(key);
+        return counts_.get(aggregation::OrderStage::OPEN, key);
     }
 
     template<typename Dummy = void>
     std::enable_if_t<Config::track_in_flight && std::is_void_v<Dummy>, int64_t>
     get_in_flight(const Key& key) const {
-        return storage_.in_flight().get(key);
-    }
-
-    // Access the underlying bucket for a stage
-    template<typename Dummy = void>
-    std::enable_if_t<Config::track_position && std::is_void_v<Dummy>, const Bucket&>
-    position_bucket() const {
-        return storage_.position();
-    }
-
-    template<typename Dummy = void>
-    std::enable_if_t<Config::track_open && std::is_void_v<Dummy>, const Bucket&>
-    open_bucket() const {
-        return storage_.open();
-    }
-
-    template<typename Dummy = void>
-    std::enable_if_t<Config::track_in_flight && std::is_void_v<Dummy>, const Bucket&>
-    in_flight_bucket() const {
-        return storage_.in_flight();
+        return counts_.get(aggregation::OrderStage::IN_FLIGHT, key);
     }
 
     // ========================================================================
@@ -215,7 +197,7 @@ public:
         if constexpr (Config::track_in_flight) {
             if (aggregation::KeyExtractor<Key>::is_applicable(order)) {
                 Key key = aggregation::KeyExtractor<Key>::extract(order);
-                storage_.in_flight().add(key, 1);
+                counts_.add(aggregation::OrderStage::IN_FLIGHT, key, 1);
             }
         }
     }
@@ -225,11 +207,7 @@ public:
             return;
         }
         Key key = aggregation::KeyExtractor<Key>::extract(order);
-        auto stage = aggregation::stage_from_order_state(order.state);
-        auto* bucket = storage_.get_stage(stage);
-        if (bucket) {
-            bucket->remove(key, 1);
-        }
+        counts_.remove(aggregation::stage_from_order_state(order.state), key, 1);
     }
 
     void on_order_updated(const engine::TrackedOrder& /*order*/, int64_t /*old_qty*/) {
@@ -253,15 +231,9 @@ public:
         auto old_stage = aggregation::stage_from_order_state(old_state);
         auto new_stage = aggregation::stage_from_order_state(new_state);
         if (old_stage != new_stage && aggregation::is_active_order_state(new_state)) {
+            // One record update; untracked stages are skipped
             Key key = aggregation::KeyExtractor<Key>::extract(order);
-            auto* old_bucket = storage_.get_stage(old_stage);
-            if (old_bucket) {
-                old_bucket->remove(key, 1);
-            }
-            auto* new_bucket = storage_.get_stage(new_stage);
-            if (new_bucket) {
-                new_bucket->add(key, 1);
-            }
+            counts_.move(key, old_stage, 1, new_stage, 1);
         }
     }
 
@@ -355,7 +327,7 @@ public:
     }
 
     void clear() {
-        storage_.clear();
+        counts_.clear();
     }
 };
 
@@ -418,9 +390,9 @@ public:
         return 0;
     }
 
-    // Extract the key from a NewOrderSingle
+    // Extract the key from a NewOrderSingle (lookup only, never interns)
     static key_type extract_key(const fix::NewOrderSingle& order) {
-        return aggregation::UnderlyerKey{order.underlyer};
+        return aggregation::UnderlyerKey::lookup(order.underlyer);
     }
 
     // Get the limit type for this metric
@@ -431,36 +403,38 @@ public:
 private:
     // Per-stage data structure
     struct StageData {
-        // Map from underlyer to set of instruments that have orders
-        aggregation::HashMap<std::string, std::unordered_set<std::string>> instruments_per_underlyer;
+        // (underlyer ID, instrument ID) pairs that have orders, packed into one
+        // 64-bit key so membership is a single flat lookup
+        aggregation::HashMap<uint64_t, uint8_t> quoted_instruments;
         // Count bucket
         aggregation::AggregationBucket<aggregation::UnderlyerKey, aggregation::CountCombiner> count;
 
-        void add(const std::string& symbol, const std::string& underlyer) {
-            auto& instruments = instruments_per_underlyer[underlyer];
-            if (instruments.find(symbol) == instruments.end()) {
-                instruments.insert(symbol);
-                count.add(aggregation::UnderlyerKey{underlyer}, 1);
+        explicit StageData(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+            : quoted_instruments(resource), count(resource) {}
+
+        void reserve(const aggregation::CapacityHints& hints) {
+            quoted_instruments.reserve(hints.instruments);
+            count.reserve(hints);
+        }
+
+        static uint64_t pair_key(aggregation::InternedId symbol, aggregation::InternedId underlyer) {
+            return (static_cast<uint64_t>(underlyer) << 32) | symbol;
+        }
+
+        void add(aggregation::InternedId symbol, aggregation::InternedId underlyer) {
+            if (quoted_instruments.try_emplace(pair_key(symbol, underlyer), uint8_t{1}).second) {
+                count.add(aggregation::UnderlyerKey::from_id(underlyer), 1);
             }
         }
 
-        void remove(const std::string& symbol, const std::string& underlyer) {
-            auto it = instruments_per_underlyer.find(underlyer);
-            if (it != instruments_per_underlyer.end()) {
-                auto& instruments = it->second;
-                if (instruments.erase(symbol) > 0) {
-                    count.remove(aggregation::UnderlyerKey{underlyer}, 1);
-                }
-                if (instruments.empty()) {
-                    instruments_per_underlyer.erase(it);
-                }
+        void remove(aggregation::InternedId symbol, aggregation::InternedId underlyer) {
+            if (quoted_instruments.erase(pair_key(symbol, underlyer)) > 0) {
+                count.remove(aggregation::UnderlyerKey::from_id(underlyer), 1);
             }
         }
 
-        bool has_instrument(const std::string& symbol, const std::string& underlyer) const {
-            auto it = instruments_per_underlyer.find(underlyer);
-            if (it == instruments_per_underlyer.end()) return false;
-            return it->second.find(symbol) != it->second.end();
+        bool has_instrument(aggregation::InternedId symbol, aggregation::InternedId underlyer) const {
+            return quoted_instruments.find(pair_key(symbol, underlyer)) != quoted_instruments.end();
         }
 
         int64_t get(const aggregation::UnderlyerKey& key) const {
@@ -468,7 +442,7 @@ private:
         }
 
         void clear() {
-            instruments_per_underlyer.clear();
+            quoted_instruments.clear();
             count.clear();
         }
     };
@@ -476,10 +450,18 @@ private:
     using Storage = aggregation::StagedMetric<StageData, Stages...>;
     Storage storage_;
 
-    // Track orders per instrument-side to know when to remove from quoted count
-    aggregation::HashMap<std::string, int> order_count_per_instrument_;
+    // Track orders per instrument (symbol ID) to know when to remove from quoted count
+    aggregation::HashMap<aggregation::InternedId, int> order_count_per_instrument_;
 
 public:
+    explicit QuotedInstrumentCountMetric(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : storage_(resource), order_count_per_instrument_(resource) {}
+
+    void reserve(const aggregation::CapacityHints& hints) {
+        storage_.reserve(hints);
+        order_count_per_instrument_.reserve(hints.instruments);
+    }
+
     // ========================================================================
     // Configuration info
     // ========================================================================
@@ -540,7 +522,12 @@ public:
     }
 
     // Check if instrument is quoted (has any orders) in any tracked stage
-    bool is_instrument_quoted(const std::string& symbol, const std::string& underlyer) const {
+    bool is_instrument_quoted(const std::string& symbol_name, const std::string& underlyer_name) const {
+        aggregation::InternedId symbol = aggregation::SymbolInterner::instance().find(symbol_name);
+        aggregation::InternedId underlyer = aggregation::UnderlyerInterner::instance().find(underlyer_name);
+        if (symbol == aggregation::INVALID_INTERNED_ID || underlyer == aggregation::INVALID_INTERNED_ID) {
+            return false;
+        }
         bool quoted = false;
         if constexpr (Config::track_position) {
             quoted = quoted || storage_.position().has_instrument(symbol, underlyer);
@@ -561,13 +548,13 @@ public:
     // Overloads without instrument (for void specialization)
     void on_order_added(const engine::TrackedOrder& order) {
         if constexpr (Config::track_in_flight) {
-            storage_.in_flight().add(order.symbol, order.underlyer);
+            storage_.in_flight().add(order.ids.symbol, order.ids.underlyer);
         }
-        order_count_per_instrument_[order.symbol]++;
+        order_count_per_instrument_[order.ids.symbol]++;
     }
 
     void on_order_removed(const engine::TrackedOrder& order) {
-        auto it = order_count_per_instrument_.find(order.symbol);
+        auto it = order_count_per_instrument_.find(order.ids.symbol);
         if (it != order_count_per_instrument_.end()) {
             it->second--;
             if (it->second <= 0) {
@@ -575,7 +562,7 @@ public:
                 auto stage = aggregation::stage_from_order_state(order.state);
                 auto* stage_data = storage_.get_stage(stage);
                 if (stage_data) {
-                    stage_data->remove(order.symbol, order.underlyer);
+                    stage_data->remove(order.ids.symbol, order.ids.underlyer);
                 }
             }
         }
@@ -602,10 +589,10 @@ public:
             auto* old_stage_data = storage_.get_stage(old_stage);
             auto* new_stage_data = storage_.get_stage(new_stage);
             if (old_stage_data) {
-                old_stage_data->remove(order.symbol, order.underlyer);
+                old_stage_data->remove(order.ids.symbol, order.ids.underlyer);
             }
             if (new_stage_data) {
-                new_stage_data->add(order.symbol, order.underlyer);
+                new_stage_data->add(order.ids.symbol, order.ids.underlyer);
             }
         }
     }
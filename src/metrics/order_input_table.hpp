@@ -0,0 +1,267 @@
+#pragma once
+
+#include "metric_policies.hpp"
+#include "../aggregation/capacity_hints.hpp"
+#include "../aggregation/container_types.hpp"
+#include "../aggregation/memory_resource.hpp"
+#include "../aggregation/order_slot_table.hpp"
+#include "../aggregation/order_stage.hpp"
+#include "../engine/order_state.hpp"
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <vector>
+
+namespace metrics {
+
+// Bitwise equality: snapshots that compare equal price every order alike
+// (NaN inputs included)
+inline bool operator==(const InputSnapshot& a, const InputSnapshot& b) {
+    return std::memcmp(&a, &b, sizeof(InputSnapshot)) == 0;
+}
+
+inline bool operator!=(const InputSnapshot& a, const InputSnapshot& b) {
+    return !(a == b);
+}
+
+} // namespace metrics
+
+namespace std {
+    template<>
+    struct hash<metrics::InputSnapshot> {
+        size_t operator()(const metrics::InputSnapshot& snapshot) const {
+            const double fields[] = {snapshot.contract_size, snapshot.spot_price, snapshot.underlyer_spot,
+                                     snapshot.fx_rate, snapshot.delta, snapshot.vega};
+            static_assert(sizeof(fields) == sizeof(metrics::InputSnapshot), "InputSnapshot holds six doubles");
+            uint64_t h = 0;
+            for (double field : fields) {
+                uint64_t bits;
+                std::memcpy(&bits, &field, sizeof(bits));
+                h = (h ^ bits) * 0x9E3779B97F4A7C15ULL;
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+}
+
+namespace metrics {
+
+// ============================================================================
+// InputSnapshotPool - Interned, reference-counted InputSnapshots
+// ============================================================================
+//
+// Orders on one instrument captured between two market data changes have
+// identical inputs. The pool keeps one copy of each distinct snapshot,
+// identified by a dense id, and counts the orders referring to it; a
+// snapshot is dropped (and its id reused) when its last order lets go.
+// Snapshots are immutable once interned, so an order's stored inputs never
+// change under it.
+//
+
+class InputSnapshotPool {
+private:
+    struct Entry {
+        InputSnapshot snapshot;
+        uint32_t refs = 0;
+    };
+
+    std::pmr::vector<Entry> entries_;
+    std::pmr::vector<uint32_t> free_ids_;
+    aggregation::HashMap<InputSnapshot, uint32_t> ids_;
+
+public:
+    explicit InputSnapshotPool(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : entries_(resource), free_ids_(resource), ids_(resource) {}
+
+    // Id of snapshot, interning it if new; the caller holds one reference
+    uint32_t acquire(const InputSnapshot& snapshot) {
+        auto it = ids_.find(snapshot);
+        if (it != ids_.end()) {
+            ++entries_[it->second].refs;
+            return it->second;
+        }
+        uint32_t id;
+        if (!free_ids_.empty()) {
+            id = free_ids_.back();
+            free_ids_.pop_back();
+        } else {
+            id = static_cast<uint32_t>(entries_.size());
+            entries_.emplace_back();
+        }
+        entries_[id] = Entry{snapshot, 1};
+        ids_.try_emplace(snapshot, id);
+        return id;
+    }
+
+    void release(uint32_t id) {
+        Entry& entry = entries_[id];
+        if (--entry.refs == 0) {
+            ids_.erase(entry.snapshot);
+            free_ids_.push_back(id);
+        }
+    }
+
+    const InputSnapshot& get(uint32_t id) const { return entries_[id].snapshot; }
+
+    uint32_t refs(uint32_t id) const { return entries_[id].refs; }
+
+    // Distinct snapshots referred to by at least one order
+    size_t size() const { return ids_.size(); }
+
+    void reserve(size_t n) {
+        entries_.reserve(n);
+        free_ids_.reserve(n);
+        ids_.reserve(n);
+    }
+
+    void clear() {
+        entries_.clear();
+        free_ids_.clear();
+        ids_.clear();
+    }
+};
+
+// ============================================================================
+// OrderInputs - What an order was captured with
+// ============================================================================
+
+struct OrderInputs {
+    int64_t quantity = 0;
+    fix::Side side = fix::Side::BID;
+    uint32_t snapshot = 0;  // Id in the InputSnapshotPool
+};
+
+// ============================================================================
+// OrderInputTable - Engine-level inputs per order, shared by exposure metrics
+// ============================================================================
+//
+// Exposure metrics remove an order with the inputs captured when it entered
+// its stage, not current ones, so removal is drift-free. An order is in one
+// stage at a time and every metric captures at the same events, so one
+// record per order serves them all: metrics only remember which of their
+// stages hold the order, under which key. The record is a quantity, a side
+// and a reference to an interned InputSnapshot.
+//
+// The engine owns the table and drives its updates (see
+// GenericRiskAggregationEngine):
+//   - begin_event() before dispatching an event to the metrics
+//   - on_stage_entered(order) after an event that (re)captured the order's
+//     inputs: an add, a stage change or a replace
+//   - on_partial_fill(order, qty) after a partial fill
+//   - on_order_removed(order) once the metrics are done with the order
+// Metrics read the record with stored(slot) while the event is dispatched,
+// so they all see the inputs from before the event. current() captures the
+// inputs for the event once, on the first metric that asks; the fields
+// captured are those any bound metric's InputPolicy reads.
+//
+// Records are indexed by order slot (see aggregation::OrderSlotTable).
+//
+
+class OrderInputTable {
+private:
+    aggregation::OrderSlotTable<OrderInputs> stored_;
+    InputSnapshotPool snapshots_;
+    InputSnapshot current_;
+    uint8_t fields_ = 0;
+    bool captured_ = false;
+
+    void store(const engine::TrackedOrder& order, const InputSnapshot& snapshot) {
+        uint32_t slot = order.handle.index;
+        if (slot == aggregation::OrderSlotTable<OrderInputs>::INVALID_SLOT) return;
+        // Acquire before releasing: the order may keep its snapshot
+        uint32_t id = snapshots_.acquire(snapshot);
+        release(slot);
+        stored_.assign(slot, OrderInputs{order.leaves_qty, order.side, id});
+    }
+
+    void release(uint32_t slot) {
+        if (auto* stored = stored_.find(slot)) {
+            snapshots_.release(stored->snapshot);
+            stored_.reset(slot);
+        }
+    }
+
+public:
+    using record_type = InputSnapshot;
+
+    explicit OrderInputTable(aggregation::MemoryResource* resource = aggregation::default_memory_resource())
+        : stored_(resource), snapshots_(resource) {}
+
+    // Add fields a bound metric reads
+    void require(uint8_t fields) { fields_ |= fields; }
+
+    uint8_t fields() const { return fields_; }
+
+    const InputSnapshotPool& snapshots() const { return snapshots_; }
+
+    // ========================================================================
+    // Metric side
+    // ========================================================================
+
+    // Inputs stored when the order entered its current stage
+    const OrderInputs* stored(uint32_t slot) const { return stored_.find(slot); }
+
+    const InputSnapshot& snapshot(const OrderInputs& inputs) const { return snapshots_.get(inputs.snapshot); }
+
+    // Current inputs, captured once per event
+    template<typename Context, typename Instrument>
+    const InputSnapshot& current(const Context& ctx, const Instrument& inst) {
+        if (!captured_) {
+            current_ = InputSnapshot::capture(ctx, inst, fields_);
+            captured_ = true;
+        }
+        return current_;
+    }
+
+    // Current inputs outside an event (for prepared orders)
+    template<typename Context, typename Instrument>
+    InputSnapshot capture(const Context& ctx, const Instrument& inst) const {
+        return InputSnapshot::capture(ctx, inst, fields_);
+    }
+
+    // ========================================================================
+    // Engine side
+    // ========================================================================
+
+    void begin_event() { captured_ = false; }
+
+    // Store the event's inputs for the order's remaining quantity, if a
+    // metric captured them
+    void on_stage_entered(const engine::TrackedOrder& order) {
+        if (captured_) {
+            store(order, current_);
+        }
+    }
+
+    // Store inputs captured by capture() for a new order
+    void on_stage_entered(const engine::TrackedOrder& order, const InputSnapshot& snapshot) {
+        store(order, snapshot);
+    }
+
+    // Metrics take fills out of the open stage only, so only an open
+    // order's stored quantity shrinks
+    void on_partial_fill(const engine::TrackedOrder& order, int64_t filled_qty) {
+        if (aggregation::stage_from_order_state(order.state) != aggregation::OrderStage::OPEN) return;
+        if (auto* stored = stored_.find(order.handle.index)) {
+            stored->quantity -= filled_qty;
+        }
+    }
+
+    void on_order_removed(const engine::TrackedOrder& order) {
+        release(order.handle.index);
+    }
+
+    void reserve(const aggregation::CapacityHints& hints) {
+        stored_.reserve(hints.orders);
+        snapshots_.reserve(hints.instruments);
+    }
+
+    void clear() {
+        stored_.clear();
+        snapshots_.clear();
+        captured_ = false;
+    }
+};
+
+} // namespace metrics
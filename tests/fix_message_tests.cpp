@@ -49,6 +49,52 @@ TEST(OrderKeyTest, HashMapUsage) {
     EXPECT_EQ(map[OrderKey{"ORD002"}], 2);
 }
 
+TEST(ClOrdIdTest, InlineAndHeapStorage) {
+    ClOrdId short_id{"ORD001"};
+    ClOrdId long_id{std::string("GATEWAY-01-SESSION-42-ORDER-0000001")};
+
+    EXPECT_TRUE(short_id.is_inline());
+    EXPECT_FALSE(long_id.is_inline());
+    EXPECT_EQ(short_id.view(), "ORD001");
+    EXPECT_EQ(long_id.str(), "GATEWAY-01-SESSION-42-ORDER-0000001");
+
+    ClOrdId copy = long_id;
+    ClOrdId moved = std::move(copy);
+    EXPECT_EQ(moved, long_id);
+    EXPECT_EQ(std::hash<ClOrdId>{}(moved), std::hash<ClOrdId>{}(long_id));
+}
+
+TEST(ClOrdIdTest, NumericForm) {
+    ClOrdId packed{uint64_t{1234567890}};
+    EXPECT_TRUE(packed.is_numeric());
+    EXPECT_EQ(packed.view(), "1234567890");
+    EXPECT_EQ(packed.numeric_value(), uint64_t{1234567890});
+    EXPECT_EQ(packed.hash(), size_t{1234567890});
+
+    // Text spelling a canonical number is packed too, so both forms are one key
+    ClOrdId text{"1234567890"};
+    EXPECT_TRUE(text.is_numeric());
+    EXPECT_EQ(packed, text);
+    EXPECT_EQ(std::hash<OrderKey>{}(OrderKey{packed}), std::hash<OrderKey>{}(OrderKey{text}));
+
+    ClOrdId largest{"18446744073709551615"};
+    EXPECT_EQ(largest.numeric_value(), UINT64_MAX);
+    EXPECT_EQ(largest, ClOrdId{UINT64_MAX});
+
+    // Not canonical numbers: kept as text
+    EXPECT_FALSE(ClOrdId{"ORD001"}.numeric_value().has_value());
+    EXPECT_FALSE(ClOrdId{"007"}.is_numeric());
+    EXPECT_FALSE(ClOrdId{"18446744073709551616"}.is_numeric());
+    EXPECT_FALSE(ClOrdId{""}.is_numeric());
+    EXPECT_NE(ClOrdId{"007"}, ClOrdId{uint64_t{7}});
+
+    ClOrdId copy = packed;
+    ClOrdId moved = std::move(copy);
+    EXPECT_TRUE(moved.is_numeric());
+    EXPECT_EQ(moved, packed);
+    EXPECT_FALSE(copy.is_numeric());
+}
+
 // ============================================================================
 // ExecutionReport report_type() Tests
 // ============================================================================
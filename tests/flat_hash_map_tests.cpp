@@ -0,0 +1,328 @@
+#include <gtest/gtest.h>
+#include "../src/aggregation/flat_hash_map.hpp"
+#include "../src/aggregation/interning.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace aggregation;
+
+// ============================================================================
+// Test Helpers
+// ============================================================================
+
+namespace {
+
+// Every key hashes alike: all entries share one probe sequence, so lookups
+// walk past full groups and erases leave tombstones
+struct CollidingHash {
+    size_t operator()(uint64_t) const { return 0; }
+};
+
+// Counts allocations made through it (forwarding to the default resource)
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t deallocations = 0;
+    size_t bytes_in_use = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        bytes_in_use += bytes;
+        return std::pmr::get_default_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++deallocations;
+        bytes_in_use -= bytes;
+        std::pmr::get_default_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+template<typename Map>
+void expect_same_contents(const Map& map, const std::unordered_map<uint64_t, uint64_t>& reference) {
+    ASSERT_EQ(map.size(), reference.size());
+    size_t visited = 0;
+    for (const auto& [key, value] : map) {
+        auto it = reference.find(key);
+        ASSERT_NE(it, reference.end()) << "unexpected key " << key;
+        EXPECT_EQ(value, it->second);
+        ++visited;
+    }
+    EXPECT_EQ(visited, reference.size());
+}
+
+// Random insert/erase/find against std::unordered_map, keys drawn from a
+// small range so hits, misses and re-inserts of erased keys all occur
+template<typename Map>
+void run_differential(Map& map, uint32_t seed, size_t operations, uint64_t key_range) {
+    std::unordered_map<uint64_t, uint64_t> reference;
+    std::mt19937_64 rng(seed);
+
+    for (size_t i = 0; i < operations; ++i) {
+        uint64_t key = rng() % key_range;
+        switch (rng() % 4) {
+            case 0: {
+                auto [it, inserted] = map.try_emplace(key, i);
+                auto [ref_it, ref_inserted] = reference.try_emplace(key, i);
+                ASSERT_EQ(inserted, ref_inserted);
+                ASSERT_EQ(it->second, ref_it->second);
+                break;
+            }
+            case 1:
+                map.insert_or_assign(key, i);
+                reference.insert_or_assign(key, i);
+                break;
+            case 2:
+                ASSERT_EQ(map.erase(key), reference.erase(key));
+                break;
+            default: {
+                auto it = map.find(key);
+                auto ref_it = reference.find(key);
+                ASSERT_EQ(it == map.end(), ref_it == reference.end());
+                if (ref_it != reference.end()) {
+                    ASSERT_EQ(it->first, key);
+                    ASSERT_EQ(it->second, ref_it->second);
+                }
+                break;
+            }
+        }
+        ASSERT_EQ(map.size(), reference.size());
+    }
+    expect_same_contents(map, reference);
+}
+
+} // namespace
+
+// ============================================================================
+// Differential Tests
+// ============================================================================
+
+TEST(FlatHashMapTest, RandomOperationsMatchUnorderedMap) {
+    for (uint64_t key_range : {16u, 1000u, 100000u}) {
+        FlatHashMap<uint64_t, uint64_t> map;
+        run_differential(map, static_cast<uint32_t>(key_range), 200000, key_range);
+    }
+}
+
+TEST(FlatHashMapTest, RandomOperationsWithCollidingHashMatchUnorderedMap) {
+    // One probe sequence for every key: exercises group-to-group probing
+    // and tombstone reuse on every operation
+    FlatHashMap<uint64_t, uint64_t, CollidingHash> map;
+    run_differential(map, 7, 20000, 64);
+}
+
+TEST(FlatHashMapTest, EraseDuringIterationVisitsEveryOtherEntryOnce) {
+    FlatHashMap<uint64_t, uint64_t> map;
+    for (uint64_t i = 0; i < 1000; ++i) {
+        map.try_emplace(i, i);
+    }
+
+    size_t visited = 0;
+    for (auto it = map.begin(); it != map.end();) {
+        ++visited;
+        it = (it->first % 2 == 0) ? map.erase(it) : std::next(it);
+    }
+
+    EXPECT_EQ(visited, 1000u);
+    EXPECT_EQ(map.size(), 500u);
+    for (uint64_t i = 0; i < 1000; ++i) {
+        EXPECT_EQ(map.contains(i), i % 2 == 1);
+    }
+}
+
+// ============================================================================
+// Tombstones and Rehash
+// ============================================================================
+
+TEST(FlatHashMapTest, SparseEraseReinsertLeavesNoTombstones) {
+    // In a sparse table every erased slot has an empty slot within one group
+    // on both sides (was_never_full), so it is freed outright: churn never
+    // reaches the load limit and never rehashes
+    CountingResource resource;
+    FlatHashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                std::pmr::polymorphic_allocator<std::pair<uint64_t, uint64_t>>> map(64, &resource);
+    size_t capacity = map.capacity();
+    size_t allocations = resource.allocations;
+
+    for (uint64_t i = 0; i < 100000; ++i) {
+        map.try_emplace(i, i);
+        if (i >= 4) {
+            ASSERT_EQ(map.erase(i - 4), 1u);
+        }
+    }
+
+    EXPECT_EQ(map.size(), 4u);
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_EQ(resource.allocations, allocations);
+}
+
+TEST(FlatHashMapTest, TombstonesAtLoadLimitRehashInPlace) {
+    // Colliding keys fill whole groups, so erasing them leaves tombstones.
+    // Once live entries plus tombstones reach the load limit the next insert
+    // rebuilds the table at the same capacity (not doubled), because the
+    // live entries alone would fit in half of it
+    CountingResource resource;
+    FlatHashMap<uint64_t, uint64_t, CollidingHash, std::equal_to<uint64_t>,
+                std::pmr::polymorphic_allocator<std::pair<uint64_t, uint64_t>>> map(14, &resource);
+    size_t capacity = map.capacity();
+    for (uint64_t i = 0; i < 14; ++i) {
+        map.try_emplace(i, i);
+    }
+    for (uint64_t i = 0; i < 10; ++i) {
+        ASSERT_EQ(map.erase(i), 1u);
+    }
+    size_t allocations = resource.allocations;
+
+    map.try_emplace(100, 100);
+
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_GT(resource.allocations, allocations) << "expected an in-place rehash";
+    EXPECT_EQ(map.size(), 5u);
+    for (uint64_t key : {10u, 11u, 12u, 13u, 100u}) {
+        auto it = map.find(key);
+        ASSERT_NE(it, map.end());
+        EXPECT_EQ(it->second, key);
+    }
+
+    // Churn at this size keeps reusing the table's capacity
+    for (uint64_t i = 0; i < 5000; ++i) {
+        map.try_emplace(1000 + i, i);
+        ASSERT_EQ(map.erase(1000 + i), 1u);
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_EQ(map.size(), 5u);
+}
+
+TEST(FlatHashMapTest, RehashShrinksAndKeepsEntries) {
+    FlatHashMap<uint64_t, uint64_t> map;
+    for (uint64_t i = 0; i < 10000; ++i) {
+        map.try_emplace(i, i * 3);
+    }
+    size_t grown = map.capacity();
+    for (uint64_t i = 0; i < 10000; ++i) {
+        if (i % 100 != 0) map.erase(i);
+    }
+
+    map.rehash(0);
+
+    EXPECT_LT(map.capacity(), grown);
+    EXPECT_EQ(map.size(), 100u);
+    for (uint64_t i = 0; i < 10000; i += 100) {
+        EXPECT_EQ(map.at(i), i * 3);
+    }
+}
+
+TEST(FlatHashMapTest, ReserveAvoidsGrowth) {
+    FlatHashMap<uint64_t, uint64_t> map;
+    map.reserve(1000);
+    size_t capacity = map.capacity();
+
+    for (uint64_t i = 0; i < 1000; ++i) {
+        map.try_emplace(i, i);
+    }
+
+    EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST(FlatHashMapTest, GrowthMovesEntries) {
+    // Unlike std::unordered_map, a growing insert relocates every entry:
+    // addresses taken before it are not valid afterwards
+    FlatHashMap<uint64_t, uint64_t> map;
+    map.try_emplace(0, 42);
+    const uint64_t* before = &map.at(0);
+    size_t capacity = map.capacity();
+
+    for (uint64_t i = 1; map.capacity() == capacity; ++i) {
+        map.try_emplace(i, i);
+    }
+
+    EXPECT_NE(&map.at(0), before);
+    EXPECT_EQ(map.at(0), 42u);
+}
+
+// ============================================================================
+// Heterogeneous Lookup
+// ============================================================================
+
+TEST(FlatHashMapTest, TransparentLookupWithStringView) {
+    FlatHashMap<std::string, int, TransparentStringHash, TransparentStringEqual> map;
+    map.try_emplace("a-symbol-name-longer-than-sso", 1);
+    map.try_emplace("MSFT", 2);
+
+    std::string_view key = "a-symbol-name-longer-than-sso";
+    auto it = map.find(key);
+    ASSERT_NE(it, map.end());
+    EXPECT_EQ(it->second, 1);
+    EXPECT_TRUE(map.contains(std::string_view("MSFT")));
+    EXPECT_FALSE(map.contains(std::string_view("GOOG")));
+
+    const auto& const_map = map;
+    EXPECT_NE(const_map.find("MSFT"), const_map.end());
+}
+
+// ============================================================================
+// Allocator Propagation
+// ============================================================================
+
+using PmrMap = FlatHashMap<uint64_t, std::pmr::vector<int>, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                           std::pmr::polymorphic_allocator<std::pair<uint64_t, std::pmr::vector<int>>>>;
+
+TEST(FlatHashMapTest, AllocatesTableAndValuesFromResource) {
+    CountingResource resource;
+    {
+        PmrMap map(&resource);
+        EXPECT_EQ(map.get_allocator().resource(), &resource);
+
+        // Uses-allocator construction hands the resource to the values too
+        map[1].push_back(10);
+        EXPECT_EQ(map.at(1).get_allocator().resource(), &resource);
+        EXPECT_GT(resource.allocations, 0u);
+    }
+    EXPECT_EQ(resource.bytes_in_use, 0u);
+    EXPECT_EQ(resource.allocations, resource.deallocations);
+}
+
+TEST(FlatHashMapTest, CopyAndMovePropagateAllocatorLikePmrContainers) {
+    CountingResource resource;
+    CountingResource other_resource;
+    PmrMap map(&resource);
+    for (uint64_t i = 0; i < 100; ++i) {
+        map[i].push_back(static_cast<int>(i));
+    }
+
+    // Copy construction: polymorphic_allocator selects the default resource
+    PmrMap copy(map);
+    EXPECT_EQ(copy.get_allocator().resource(), std::pmr::get_default_resource());
+    EXPECT_EQ(copy.size(), 100u);
+
+    // Explicit allocator on copy
+    PmrMap copy_in_other(map, &other_resource);
+    EXPECT_EQ(copy_in_other.get_allocator().resource(), &other_resource);
+    EXPECT_GT(other_resource.allocations, 0u);
+
+    // Move construction keeps the source's resource and steals its table
+    size_t allocations = resource.allocations;
+    PmrMap moved(std::move(map));
+    EXPECT_EQ(moved.get_allocator().resource(), &resource);
+    EXPECT_EQ(resource.allocations, allocations);
+    EXPECT_EQ(moved.size(), 100u);
+
+    // Move assignment across resources does not propagate: entries are
+    // moved element-wise into the target's own resource
+    PmrMap target(&other_resource);
+    target = std::move(moved);
+    EXPECT_EQ(target.get_allocator().resource(), &other_resource);
+    EXPECT_EQ(target.size(), 100u);
+    EXPECT_EQ(target.at(42).front(), 42);
+    EXPECT_EQ(target.at(42).get_allocator().resource(), &other_resource);
+}
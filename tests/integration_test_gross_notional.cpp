@@ -4,6 +4,7 @@
 #include "../src/instrument/instrument.hpp"
 #include "../src/fix/fix_messages.hpp"
 #include <memory>
+#include <stdexcept>
 
 using namespace engine;
 using namespace fix;
@@ -281,6 +282,91 @@ TEST_F(GrossOpenNotionalTest, LimitEnforcement) {
     EXPECT_DOUBLE_EQ(breach->limit_value, 100000.0);
 }
 
+TEST_F(GrossOpenNotionalTest, TrySubmitAddsOnlyOrdersWithinLimit) {
+    // $75,000 of AAPL: within the $100,000 limit, so it is added
+    auto order1 = create_order("ORD001", "AAPL", Side::BID, 150.0, 500);
+    auto aapl_inst = get_instrument("AAPL");
+    SubmitResult submit1 = engine->try_submit(order1, aapl_inst);
+    ASSERT_TRUE(submit1.accepted());
+    EXPECT_FALSE(submit1.check.would_breach);
+    EXPECT_EQ(engine->order_book().get_order(submit1.handle), engine->order_book().get_order(order1.key));
+    EXPECT_DOUBLE_EQ(gross_notional(), 75000.0);
+
+    // The added order behaves like one from on_new_order_single()
+    engine->on_execution_report(create_ack("ORD001", 500), aapl_inst);
+    EXPECT_DOUBLE_EQ(gross_notional(), 75000.0);
+
+    // +$30,000 would breach: rejected with details, engine unchanged
+    auto order2 = create_order("ORD002", "MSFT", Side::BID, 300.0, 100);
+    SubmitResult submit2 = engine->try_submit(order2, get_instrument("MSFT"));
+    EXPECT_FALSE(submit2.accepted());
+    EXPECT_TRUE(submit2.check.has_breach(LimitType::GLOBAL_GROSS_NOTIONAL));
+    const auto* breach = submit2.check.get_breach(LimitType::GLOBAL_GROSS_NOTIONAL);
+    ASSERT_NE(breach, nullptr);
+    EXPECT_DOUBLE_EQ(breach->hypothetical_usage, 105000.0);
+    EXPECT_EQ(engine->order_book().get_order(order2.key), nullptr);
+    EXPECT_EQ(engine->active_order_count(), 1u);
+    EXPECT_DOUBLE_EQ(gross_notional(), 75000.0);
+
+    // Filling the first order frees the notional, removed via the stored inputs
+    engine->on_execution_report(create_fill("ORD001", 500, 0, 150.0), aapl_inst);
+    EXPECT_DOUBLE_EQ(gross_notional(), 0.0);
+}
+
+TEST_F(GrossOpenNotionalTest, BatchCheckAccumulatesWithinBatch) {
+    // $15,000 already open
+    auto order1 = create_order("ORD001", "AAPL", Side::BID, 150.0, 100);
+    engine->on_new_order_single(order1, get_instrument("AAPL"));
+
+    // Each order passes on its own; together the third one breaches
+    std::vector<NewOrderSingle> orders = {
+        create_order("B1", "MSFT", Side::BID, 300.0, 100),  // +$30,000 -> 45,000
+        create_order("B2", "GOOG", Side::ASK, 100.0, 300),  // +$30,000 -> 75,000
+        create_order("B3", "TSLA", Side::BID, 200.0, 150),  // +$30,000 -> 105,000 (breach)
+        create_order("B4", "AAPL", Side::ASK, 150.0, 100),  // +$15,000 -> 90,000 (B3 not counted)
+    };
+    std::vector<InstrumentData> instruments;
+    for (const auto& order : orders) {
+        EXPECT_FALSE(engine->pre_trade_check(order, get_instrument(order.symbol)).would_breach);
+        instruments.push_back(get_instrument(order.symbol));
+    }
+    std::vector<const InstrumentData*> instrument_ptrs;
+    for (const auto& inst : instruments) {
+        instrument_ptrs.push_back(&inst);
+    }
+
+    BatchPreTradeCheckResult batch = engine->pre_trade_check_batch(orders, instrument_ptrs);
+    ASSERT_EQ(batch.size(), 4u);
+    EXPECT_EQ(batch.passed, 3u);
+    EXPECT_FALSE(batch.all_passed());
+    EXPECT_FALSE(batch[0].would_breach);
+    EXPECT_FALSE(batch[1].would_breach);
+    EXPECT_TRUE(batch[2].has_breach(LimitType::GLOBAL_GROSS_NOTIONAL));
+    EXPECT_FALSE(batch[3].would_breach);
+
+    const auto* breach = batch[2].get_breach(LimitType::GLOBAL_GROSS_NOTIONAL);
+    ASSERT_NE(breach, nullptr);
+    EXPECT_DOUBLE_EQ(breach->current_usage, 75000.0);
+    EXPECT_DOUBLE_EQ(breach->hypothetical_usage, 105000.0);
+
+    // The check does not change the engine
+    EXPECT_DOUBLE_EQ(gross_notional(), 15000.0);
+}
+
+TEST_F(GrossOpenNotionalTest, BatchCheckRejectsMismatchedInstruments) {
+    std::vector<NewOrderSingle> orders = {
+        create_order("B1", "MSFT", Side::BID, 300.0, 100),
+        create_order("B2", "GOOG", Side::ASK, 100.0, 300),
+    };
+    auto msft = get_instrument("MSFT");
+
+    std::vector<const InstrumentData*> too_few = {&msft};
+    EXPECT_THROW(engine->pre_trade_check_batch(orders, too_few), std::invalid_argument);
+
+    std::vector<const InstrumentData*> with_null = {&msft, nullptr};
+    EXPECT_THROW(engine->pre_trade_check_batch(orders, with_null), std::invalid_argument);
+}
+
 TEST_F(GrossOpenNotionalTest, NackFreesNotional) {
     auto order = create_order("ORD001", "AAPL", Side::BID, 150.0, 100);
     auto inst = get_instrument(order.symbol);
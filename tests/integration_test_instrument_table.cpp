@@ -0,0 +1,587 @@
+#include <gtest/gtest.h>
+#include "../src/engine/risk_engine_with_limits.hpp"
+#include "../src/metrics/notional_metric.hpp"
+#include "../src/metrics/delta_metric.hpp"
+#include "../src/instrument/instrument_table.hpp"
+#include "../src/instrument/option_greeks.hpp"
+#include "../src/instrument/universe_file.hpp"
+#include "../src/fix/fix_messages.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace engine;
+using namespace fix;
+using namespace aggregation;
+using namespace metrics;
+using namespace instrument;
+
+// ============================================================================
+// Helper functions
+// ============================================================================
+
+namespace {
+
+NewOrderSingle create_order(const std::string& cl_ord_id, const std::string& symbol,
+                             const std::string& underlyer, Side side, int64_t qty) {
+    NewOrderSingle order;
+    order.key.cl_ord_id = cl_ord_id;
+    order.symbol = symbol;
+    order.underlyer = underlyer;
+    order.side = side;
+    order.price = 10.0;
+    order.quantity = qty;
+    order.strategy_id = "STRAT1";
+    order.portfolio_id = "PORT1";
+    return order;
+}
+
+ExecutionReport create_ack(const std::string& cl_ord_id, int64_t leaves_qty) {
+    ExecutionReport report;
+    report.key.cl_ord_id = cl_ord_id;
+    report.order_id = "EX" + cl_ord_id;
+    report.ord_status = OrdStatus::NEW;
+    report.exec_type = ExecType::NEW;
+    report.leaves_qty = leaves_qty;
+    report.cum_qty = 0;
+    report.is_unsolicited = false;
+    return report;
+}
+
+ExecutionReport create_fill(const std::string& cl_ord_id, int64_t fill_qty, int64_t leaves_qty, double price) {
+    ExecutionReport report;
+    report.key.cl_ord_id = cl_ord_id;
+    report.order_id = "EX" + cl_ord_id;
+    report.ord_status = leaves_qty > 0 ? OrdStatus::PARTIALLY_FILLED : OrdStatus::FILLED;
+    report.exec_type = leaves_qty > 0 ? ExecType::PARTIAL_FILL : ExecType::FILL;
+    report.leaves_qty = leaves_qty;
+    report.cum_qty = fill_qty;
+    report.last_qty = fill_qty;
+    report.last_px = price;
+    report.is_unsolicited = false;
+    return report;
+}
+
+}  // namespace
+
+// ============================================================================
+// Test: StaticInstrumentProvider references
+// ============================================================================
+
+TEST(StaticInstrumentProviderTest, ReferencesSurviveLaterAdds) {
+    StaticInstrumentProvider provider;
+    provider.add_equity("AAPL", 150.0);
+    provider.add_option("AAPL_C150", "AAPL", 5.0, 150.0, 0.5);
+    const InstrumentData& aapl = provider.get_instrument("AAPL");
+    const InstrumentData& call = provider.get_instrument("AAPL_C150");
+
+    for (int i = 0; i < 1000; ++i) {
+        provider.add_equity("EQ" + std::to_string(i), 1.0 + i);
+    }
+    EXPECT_DOUBLE_EQ(aapl.spot_price(), 150.0);
+    EXPECT_DOUBLE_EQ(call.delta(), 0.5);
+    EXPECT_DOUBLE_EQ(provider.get_instrument("EQ999").spot_price(), 1000.0);
+
+    // Updates and re-adds land in the referenced entry
+    provider.update_underlyer_spot("AAPL", 155.0);
+    EXPECT_DOUBLE_EQ(aapl.spot_price(), 155.0);
+    EXPECT_DOUBLE_EQ(call.underlyer_spot(), 155.0);
+    provider.add_equity("AAPL", 160.0);
+    EXPECT_EQ(&provider.get_instrument("AAPL"), &aapl);
+    EXPECT_DOUBLE_EQ(aapl.spot_price(), 160.0);
+}
+
+// ============================================================================
+// Test: InstrumentTable columns and underlyer index
+// ============================================================================
+
+class InstrumentTableTest : public ::testing::Test {
+protected:
+    InstrumentTable table;
+    InstrumentId aapl = INVALID_INSTRUMENT_ID;
+    InstrumentId aapl_call = INVALID_INSTRUMENT_ID;
+    InstrumentId aapl_put = INVALID_INSTRUMENT_ID;
+    InstrumentId msft_call = INVALID_INSTRUMENT_ID;
+
+    void SetUp() override {
+        aapl = table.add_equity("AAPL", 100.0);
+        aapl_call = table.add_option("AAPL_C100", "AAPL", 10.0, 100.0, 0.5, 100.0, 1.0, 0.2);
+        msft_call = table.add_option("MSFT_C300", "MSFT", 20.0, 300.0, 0.4);
+        aapl_put = table.add_option("AAPL_P100", "AAPL", 8.0, 100.0, -0.45);
+    }
+
+    std::vector<InstrumentId> members(const std::string& underlyer) const {
+        InstrumentRange range = table.instruments_of(underlyer);
+        return std::vector<InstrumentId>(range.begin(), range.end());
+    }
+};
+
+TEST_F(InstrumentTableTest, DenseIdsAndLookup) {
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_EQ(aapl, 0u);
+    EXPECT_EQ(aapl_put, 3u);
+    EXPECT_EQ(table.find("AAPL_C100"), aapl_call);
+    EXPECT_EQ(table.find(SymbolInterner::instance().find("MSFT_C300")), msft_call);
+    EXPECT_EQ(table.find("UNKNOWN_SYMBOL"), INVALID_INSTRUMENT_ID);
+    EXPECT_EQ(table.symbol(aapl_call), "AAPL_C100");
+    EXPECT_EQ(table.underlyer(aapl_call), "AAPL");
+    EXPECT_EQ(table.underlyer(aapl), "AAPL") << "Equities are their own underlyer";
+
+    PricingInputs in = table.pricing_inputs(aapl_call);
+    EXPECT_DOUBLE_EQ(in.spot_price, 10.0);
+    EXPECT_DOUBLE_EQ(in.contract_size, 100.0);
+    EXPECT_DOUBLE_EQ(in.underlyer_spot, 100.0);
+    EXPECT_DOUBLE_EQ(in.delta, 0.5);
+    EXPECT_DOUBLE_EQ(in.vega, 0.2);
+
+    // Re-adding a symbol overwrites its row
+    EXPECT_EQ(table.add_option("AAPL_C100", "AAPL", 11.0, 100.0, 0.55), aapl_call);
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_DOUBLE_EQ(table.delta(aapl_call), 0.55);
+}
+
+TEST_F(InstrumentTableTest, AddRejectsIdsNeverInterned) {
+    const InternedId unseen = UnderlyerInterner::instance().find("UNSEEN_TABLE_UNDERLYER");
+    ASSERT_EQ(unseen, INVALID_INTERNED_ID);
+    InternedId symbol = SymbolInterner::instance().intern("TABLE_ORPHAN");
+
+    EXPECT_EQ(table.add(symbol, unseen, PricingInputs{}), INVALID_INSTRUMENT_ID);
+    EXPECT_EQ(table.add(INVALID_INTERNED_ID, UnderlyerInterner::instance().intern("AAPL"), PricingInputs{}),
+              INVALID_INSTRUMENT_ID);
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_EQ(table.find(symbol), INVALID_INSTRUMENT_ID);
+
+    // The underlyer index and the writer still see only valid rows
+    EXPECT_EQ(members("AAPL"), (std::vector<InstrumentId>{aapl, aapl_call, aapl_put}));
+    std::string path = ::testing::TempDir() + "orphan_universe.bin";
+    EXPECT_TRUE(write_universe_file(path, table));
+    std::remove(path.c_str());
+}
+
+TEST_F(InstrumentTableTest, UnderlyerTickTouchesOnlyItsInstruments) {
+    EXPECT_EQ(members("AAPL"), (std::vector<InstrumentId>{aapl, aapl_call, aapl_put}));
+    EXPECT_EQ(members("MSFT"), (std::vector<InstrumentId>{msft_call}));
+    EXPECT_TRUE(table.instruments_of("NO_SUCH_UNDERLYER").empty());
+
+    table.update_underlyer_spot("AAPL", 110.0);
+    EXPECT_DOUBLE_EQ(table.underlyer_spot(aapl_call), 110.0);
+    EXPECT_DOUBLE_EQ(table.underlyer_spot(aapl_put), 110.0);
+    EXPECT_DOUBLE_EQ(table.spot_price(aapl), 110.0) << "The underlyer's own spot follows";
+    EXPECT_DOUBLE_EQ(table.spot_price(aapl_call), 10.0) << "Option premium unchanged";
+    EXPECT_DOUBLE_EQ(table.underlyer_spot(msft_call), 300.0);
+
+    // Changing an instrument's underlyer moves it in the index
+    table.add_option("MSFT_C300", "AAPL", 20.0, 110.0, 0.4);
+    EXPECT_EQ(members("AAPL").size(), 4u);
+    EXPECT_TRUE(members("MSFT").empty());
+}
+
+TEST_F(InstrumentTableTest, BatchUpdatesWriteColumns) {
+    const InstrumentId ids[] = {aapl_call, aapl_put, msft_call};
+    const double deltas[] = {0.6, -0.35, 0.45};
+    const double vegas[] = {0.25, 0.3, 0.15};
+    const double spots[] = {12.0, 6.5, 21.0};
+    table.update_deltas(ids, deltas, 3);
+    table.update_vegas(ids, vegas, 3);
+    table.update_spot_prices(ids, spots, 3);
+
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_DOUBLE_EQ(table.delta(ids[i]), deltas[i]);
+        EXPECT_DOUBLE_EQ(table.vega(ids[i]), vegas[i]);
+        EXPECT_DOUBLE_EQ(table.spot_price(ids[i]), spots[i]);
+    }
+    EXPECT_DOUBLE_EQ(table.delta(aapl), 1.0);
+}
+
+// ============================================================================
+// Test: Universe file round trip
+// ============================================================================
+
+class UniverseFileTest : public InstrumentTableTest {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        InstrumentTableTest::SetUp();
+        path = ::testing::TempDir() + "universe_file_test.bin";
+        ASSERT_TRUE(write_universe_file(path, table));
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(UniverseFileTest, MappedFileReadsInPlace) {
+    UniverseFile file;
+    ASSERT_TRUE(file.open(path)) << file.error();
+    ASSERT_EQ(file.size(), 4u);
+    EXPECT_EQ(file.underlyer_count(), 2u);
+
+    // Grouped by underlyer: AAPL's instruments first, in table order
+    EXPECT_EQ(file.symbol(0), "AAPL");
+    EXPECT_EQ(file.symbol(1), "AAPL_C100");
+    EXPECT_EQ(file.symbol(2), "AAPL_P100");
+    EXPECT_EQ(file.symbol(3), "MSFT_C300");
+    EXPECT_EQ(file.underlyer(2), "AAPL");
+    EXPECT_EQ(file.underlyer(3), "MSFT");
+    EXPECT_DOUBLE_EQ(file.contract_size(0), 1.0);
+    EXPECT_DOUBLE_EQ(file.contract_size(1), 100.0);
+    EXPECT_DOUBLE_EQ(file.deltas()[2], -0.45);
+    EXPECT_DOUBLE_EQ(file.pricing_inputs(3).underlyer_spot, 300.0);
+}
+
+TEST_F(UniverseFileTest, LoadedTableMatchesSource) {
+    UniverseFile file;
+    ASSERT_TRUE(file.open(path)) << file.error();
+    InstrumentTable loaded;
+    load_universe(file, loaded);
+
+    ASSERT_EQ(loaded.size(), table.size());
+    for (InstrumentId id = 0; id < table.size(); ++id) {
+        InstrumentId copy = loaded.find(table.symbol(id));
+        ASSERT_NE(copy, INVALID_INSTRUMENT_ID) << table.symbol(id);
+        EXPECT_EQ(loaded.underlyer(copy), table.underlyer(id));
+        EXPECT_DOUBLE_EQ(loaded.spot_price(copy), table.spot_price(id));
+        EXPECT_DOUBLE_EQ(loaded.contract_size(copy), table.contract_size(id));
+        EXPECT_DOUBLE_EQ(loaded.delta(copy), table.delta(id));
+        EXPECT_DOUBLE_EQ(loaded.vega(copy), table.vega(id));
+    }
+    EXPECT_EQ(loaded.find("AAPL_P100"), 2u) << "IDs follow file order";
+
+    // The loaded table behaves like one built by hand
+    loaded.update_underlyer_spot("AAPL", 105.0);
+    EXPECT_DOUBLE_EQ(loaded.spot_price(loaded.find("AAPL")), 105.0);
+    EXPECT_DOUBLE_EQ(loaded.underlyer_spot(loaded.find("AAPL_C100")), 105.0);
+    EXPECT_DOUBLE_EQ(loaded.underlyer_spot(loaded.find("MSFT_C300")), 300.0);
+}
+
+TEST_F(UniverseFileTest, RejectsInvalidFiles) {
+    UniverseFile file;
+    EXPECT_FALSE(file.open(path + ".missing"));
+    EXPECT_FALSE(file.is_open());
+
+    // Truncated: size no longer matches the header
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 1));
+    }
+    EXPECT_FALSE(file.open(path));
+    EXPECT_NE(file.error().find("size"), std::string::npos) << file.error();
+
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << std::string(64, 'x');
+    }
+    EXPECT_FALSE(file.open(path));
+    EXPECT_NE(file.error().find("not a universe file"), std::string::npos) << file.error();
+}
+
+TEST_F(UniverseFileTest, RejectsCorruptedHeaderAndOffsets) {
+    std::string original;
+    {
+        std::ifstream in(path, std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    auto write = [this](const std::string& bytes) {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    };
+    UniverseFileHeader header;
+    std::memcpy(&header, original.data(), sizeof(header));
+    UniverseFile file;
+
+    // String blob claimed far past the end of the file
+    for (uint64_t string_bytes : {uint64_t{1} << 32, std::numeric_limits<uint64_t>::max()}) {
+        UniverseFileHeader corrupt = header;
+        corrupt.string_bytes = string_bytes;
+        std::string bytes = original;
+        std::memcpy(bytes.data(), &corrupt, sizeof(corrupt));
+        write(bytes);
+        EXPECT_FALSE(file.open(path)) << string_bytes;
+        EXPECT_NE(file.error().find("size"), std::string::npos) << file.error();
+    }
+
+    // Counts whose sections alone exceed the file
+    {
+        UniverseFileHeader corrupt = header;
+        corrupt.instrument_count = std::numeric_limits<uint32_t>::max();
+        std::string bytes = original;
+        std::memcpy(bytes.data(), &corrupt, sizeof(corrupt));
+        write(bytes);
+        EXPECT_FALSE(file.open(path));
+        EXPECT_NE(file.error().find("size"), std::string::npos) << file.error();
+    }
+
+    // A symbol offset past the string blob
+    {
+        instrument::detail::UniverseLayout layout(header.instrument_count, header.underlyer_count, header.string_bytes);
+        std::string bytes = original;
+        const uint32_t past_end = static_cast<uint32_t>(header.string_bytes + 1);
+        std::memcpy(bytes.data() + layout.symbol_offset + header.instrument_count * sizeof(uint32_t),
+                    &past_end, sizeof(past_end));
+        write(bytes);
+        EXPECT_FALSE(file.open(path));
+        EXPECT_NE(file.error().find("offset"), std::string::npos) << file.error();
+    }
+
+    write(original);
+    EXPECT_TRUE(file.open(path)) << file.error();
+}
+
+// ============================================================================
+// Test: Engine over an InstrumentTable
+// ============================================================================
+//
+// Orders carry InstrumentRefs from the table; InstrumentTableContext reads
+// the columns. Stored inputs keep removal drift-free across table updates.
+//
+
+class InstrumentTableEngineTest : public InstrumentTableTest {
+protected:
+    using UnderlyerDelta = GrossDeltaMetric<UnderlyerKey, InstrumentTableContext, InstrumentRef, OpenStage, InFlightStage>;
+    using GlobalNotional = GlobalGrossNotionalMetric<InstrumentTableContext, InstrumentRef, OpenStage, InFlightStage>;
+
+    using TestEngine = RiskAggregationEngineWithLimits<
+        InstrumentTableContext,
+        InstrumentRef,
+        UnderlyerDelta,
+        GlobalNotional
+    >;
+
+    std::unique_ptr<InstrumentTableContext> context;
+    std::unique_ptr<TestEngine> engine;
+
+    void SetUp() override {
+        InstrumentTableTest::SetUp();
+        context = std::make_unique<InstrumentTableContext>(table);
+        engine = std::make_unique<TestEngine>(*context);
+        // Later reports use the InstrumentRef bound at entry
+        engine->set_instrument_binding(true);
+    }
+
+    double delta(const std::string& underlyer) const {
+        return engine->get_metric<UnderlyerDelta>().get(UnderlyerKey{underlyer});
+    }
+};
+
+TEST_F(InstrumentTableEngineTest, UnderlyerTickIsDriftFree) {
+    // 10 * 0.5 * 100 * 100 = 50,000
+    OrderHandle handle = engine->on_new_order_single(
+        create_order("ORD001", "AAPL_C100", "AAPL", Side::BID, 10), table.ref(aapl_call));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 50000.0);
+    EXPECT_DOUBLE_EQ(engine->get_metric<GlobalNotional>().get(GlobalKey::instance()), 10 * 100 * 10.0);
+
+    // Tick AAPL and re-mark the call; the ack re-captures at the new inputs
+    table.update_underlyer_spot("AAPL", 120.0);
+    const InstrumentId ids[] = {aapl_call};
+    const double deltas[] = {0.75};
+    table.update_deltas(ids, deltas, 1);
+    engine->on_execution_report(create_ack("ORD001", 10), handle);
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 10 * 0.75 * 100 * 120.0);
+
+    // Fills remove what was stored at the ack, whatever the table says now
+    table.update_underlyer_spot("AAPL", 90.0);
+    engine->on_execution_report(create_fill("ORD001", 4, 6, 10.0));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 6 * 0.75 * 100 * 120.0);
+    engine->on_execution_report(create_fill("ORD001", 6, 0, 10.0));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 0.0);
+    EXPECT_DOUBLE_EQ(delta("MSFT"), 0.0);
+}
+
+// Bound handles resolve through the table: later messages price from the
+// same live columns as the instrument-passing overloads, however the
+// table grows after binding
+TEST_F(InstrumentTableEngineTest, BoundHandlesReadLiveValues) {
+    static_assert(TestEngine::can_bind_instruments());
+    static_assert(!is_instrument_handle_v<InstrumentData>, "A copied InstrumentData would be a snapshot");
+    TestEngine passing(*context);
+
+    OrderHandle handle = engine->on_new_order_single(
+        create_order("ORD001", "AAPL_C100", "AAPL", Side::BID, 10), table.ref(aapl_call));
+    passing.on_new_order_single(create_order("ORD001", "AAPL_C100", "AAPL", Side::BID, 10), table.ref(aapl_call));
+    const InstrumentRef* bound = engine->bound_instrument(*engine->order_book().get_order(handle));
+    ASSERT_NE(bound, nullptr);
+    EXPECT_EQ(bound->id(), aapl_call);
+
+    for (int i = 0; i < 1000; ++i) {
+        table.add_equity("BOUND_EQ" + std::to_string(i), 1.0);
+    }
+    table.update_underlyer_spot("AAPL", 120.0);
+    const InstrumentId ids[] = {aapl_call};
+    const double deltas[] = {0.75};
+    table.update_deltas(ids, deltas, 1);
+
+    engine->on_execution_report(create_ack("ORD001", 10));
+    passing.on_execution_report(create_ack("ORD001", 10), table.ref(aapl_call));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 10 * 0.75 * 100 * 120.0);
+    EXPECT_DOUBLE_EQ(delta("AAPL"), passing.get_metric<UnderlyerDelta>().get(UnderlyerKey{"AAPL"}));
+
+    engine->on_execution_report(create_fill("ORD001", 4, 6, 10.0), handle);
+    passing.on_execution_report(create_fill("ORD001", 4, 6, 10.0), table.ref(aapl_call));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 6 * 0.75 * 100 * 120.0);
+    EXPECT_DOUBLE_EQ(delta("AAPL"), passing.get_metric<UnderlyerDelta>().get(UnderlyerKey{"AAPL"}));
+}
+
+TEST_F(InstrumentTableEngineTest, MessagesWithoutBoundInstrumentAreIgnored) {
+    engine->set_instrument_binding(false);
+    OrderHandle handle = engine->on_new_order_single(
+        create_order("ORD001", "AAPL_C100", "AAPL", Side::BID, 10), table.ref(aapl_call));
+    EXPECT_EQ(engine->bound_instrument(*engine->order_book().get_order(handle)), nullptr);
+
+    engine->on_execution_report(create_ack("ORD001", 10));
+    engine->on_execution_report(create_fill("ORD001", 10, 0, 10.0), handle);
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 50000.0) << "Reports without an instrument are dropped";
+
+    engine->on_execution_report(create_ack("ORD001", 10), table.ref(aapl_call));
+    engine->on_execution_report(create_fill("ORD001", 10, 0, 10.0), table.ref(aapl_call));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 0.0);
+}
+
+// ============================================================================
+// Test: Black-Scholes greeks
+// ============================================================================
+
+namespace {
+
+struct ReferenceGreeks {
+    double delta;
+    double vega;
+};
+
+ReferenceGreeks reference_greeks(double spot, double strike, double expiry, double vol,
+                                 double rate, double dividend, bool put) {
+    double sqrt_t = std::sqrt(expiry);
+    double d1 = (std::log(spot / strike) + (rate - dividend + 0.5 * vol * vol) * expiry) / (vol * sqrt_t);
+    double carry = std::exp(-dividend * expiry);
+    double cdf = 0.5 * std::erfc(-d1 / std::sqrt(2.0));
+    double pdf = std::exp(-0.5 * d1 * d1) / std::sqrt(2.0 * M_PI);
+    return ReferenceGreeks{carry * (cdf - (put ? 1.0 : 0.0)), carry * pdf * sqrt_t};
+}
+
+}  // namespace
+
+// Every lane width (the tail of each batch is scalar) against the libm formula
+TEST(BlackScholesTest, MatchesReferenceAcrossBatch) {
+    std::vector<double> spot, strike, expiry, vol, rate, dividend, put;
+    for (double k : {50.0, 90.0, 100.0, 110.0, 200.0}) {
+        for (double t : {0.01, 0.25, 1.0, 5.0}) {
+            for (double v : {0.05, 0.2, 0.8}) {
+                for (double p : {0.0, 1.0}) {
+                    spot.push_back(100.0);
+                    strike.push_back(k);
+                    expiry.push_back(t);
+                    vol.push_back(v);
+                    rate.push_back(0.03);
+                    dividend.push_back(0.01);
+                    put.push_back(p);
+                }
+            }
+        }
+    }
+    spot.push_back(100.0); strike.push_back(100.0); expiry.push_back(0.5); vol.push_back(0.3);
+    rate.push_back(0.0); dividend.push_back(0.0); put.push_back(0.0);  // Odd count: exercises the scalar tail
+
+    size_t n = spot.size();
+    std::vector<double> delta(n), vega(n);
+    BlackScholesBatch batch;
+    batch.spot = spot.data();
+    batch.strike = strike.data();
+    batch.expiry = expiry.data();
+    batch.volatility = vol.data();
+    batch.rate = rate.data();
+    batch.dividend_yield = dividend.data();
+    batch.put = put.data();
+    batch.delta = delta.data();
+    batch.vega = vega.data();
+    batch.count = n;
+    compute_black_scholes(batch);
+
+    for (size_t i = 0; i < n; ++i) {
+        ReferenceGreeks ref = reference_greeks(spot[i], strike[i], expiry[i], vol[i], rate[i], dividend[i], put[i] != 0.0);
+        EXPECT_NEAR(delta[i], ref.delta, 2e-7) << black_scholes_isa() << " row " << i;
+        EXPECT_NEAR(vega[i], ref.vega, 1e-12) << black_scholes_isa() << " row " << i;
+    }
+}
+
+TEST(BlackScholesTest, ExpiredOptionsHaveIntrinsicDelta) {
+    const double spot[] = {120.0, 80.0, 120.0, 80.0};
+    const double strike[] = {100.0, 100.0, 100.0, 100.0};
+    const double expiry[] = {0.0, 0.0, -0.1, -0.1};
+    const double vol[] = {0.2, 0.2, 0.2, 0.2};
+    const double zero[] = {0.0, 0.0, 0.0, 0.0};
+    const double put[] = {0.0, 0.0, 1.0, 1.0};
+    double delta[4], vega[4];
+    BlackScholesBatch batch{spot, strike, expiry, vol, zero, zero, put, delta, vega, 4};
+    compute_black_scholes(batch);
+
+    EXPECT_DOUBLE_EQ(delta[0], 1.0);   // ITM call
+    EXPECT_DOUBLE_EQ(delta[1], 0.0);   // OTM call
+    EXPECT_DOUBLE_EQ(delta[2], 0.0);   // OTM put
+    EXPECT_DOUBLE_EQ(delta[3], -1.0);  // ITM put
+    for (double v : vega) {
+        EXPECT_EQ(v, 0.0);
+    }
+}
+
+// ============================================================================
+// Test: Greeks republished on underlyer moves
+// ============================================================================
+
+class OptionGreeksEngineTest : public InstrumentTableEngineTest {
+protected:
+    std::unique_ptr<OptionGreeksEngine> greeks;
+    OptionTerms call_terms{100.0, 0.5, 0.25, 0.02, 0.0, OptionType::CALL};
+    OptionTerms put_terms{100.0, 0.5, 0.25, 0.02, 0.0, OptionType::PUT};
+
+    void SetUp() override {
+        InstrumentTableEngineTest::SetUp();
+        greeks = std::make_unique<OptionGreeksEngine>(table);
+        greeks->set_terms(aapl_call, call_terms);
+        greeks->set_terms(aapl_put, put_terms);
+        greeks->set_terms(msft_call, OptionTerms{300.0, 1.0, 0.3, 0.02, 0.0, OptionType::CALL});
+    }
+};
+
+TEST_F(OptionGreeksEngineTest, UnderlyerMoveRepublishesItsOptions) {
+    EXPECT_EQ(greeks->on_underlyer_spot("AAPL", 110.0), 2u) << "Only AAPL's options, not the equity";
+
+    ReferenceGreeks call = reference_greeks(110.0, 100.0, 0.5, 0.25, 0.02, 0.0, false);
+    ReferenceGreeks put = reference_greeks(110.0, 100.0, 0.5, 0.25, 0.02, 0.0, true);
+    EXPECT_NEAR(table.delta(aapl_call), call.delta, 2e-7);
+    EXPECT_NEAR(table.vega(aapl_call), call.vega, 1e-12);
+    EXPECT_NEAR(table.delta(aapl_put), put.delta, 2e-7);
+    EXPECT_NEAR(table.delta(aapl_call) - table.delta(aapl_put), 1.0, 1e-12) << "Put-call parity";
+    EXPECT_DOUBLE_EQ(table.delta(aapl), 1.0) << "Equity untouched";
+    EXPECT_DOUBLE_EQ(table.delta(msft_call), 0.4) << "Other underlyers untouched";
+    EXPECT_DOUBLE_EQ(table.spot_price(aapl), 110.0);
+
+    EXPECT_EQ(greeks->recompute_all(), 3u);
+    EXPECT_NE(table.delta(msft_call), 0.4);
+}
+
+// Orders priced through the Context see the republished greeks; stored
+// inputs keep earlier orders drift-free
+TEST_F(OptionGreeksEngineTest, EngineSeesRepublishedDelta) {
+    greeks->on_underlyer_spot("AAPL", 100.0);
+    double delta_at_100 = table.delta(aapl_call);
+    engine->on_new_order_single(create_order("ORD001", "AAPL_C100", "AAPL", Side::BID, 10), table.ref(aapl_call));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 10 * delta_at_100 * 100 * 100.0);
+
+    greeks->on_underlyer_spot("AAPL", 120.0);
+    double delta_at_120 = table.delta(aapl_call);
+    EXPECT_GT(delta_at_120, delta_at_100);
+    engine->on_execution_report(create_ack("ORD001", 10));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 10 * delta_at_120 * 100 * 120.0);
+
+    engine->on_execution_report(create_fill("ORD001", 10, 0, 10.0));
+    EXPECT_DOUBLE_EQ(delta("AAPL"), 0.0);
+}
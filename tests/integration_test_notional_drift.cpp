@@ -116,6 +116,33 @@ OrderCancelRequest create_cancel_request(const std::string& cancel_id, const std
     return req;
 }
 
+OrderCancelReplaceRequest create_replace(const std::string& new_id, const std::string& orig_id,
+                                          const std::string& symbol, Side side,
+                                          double new_price, int64_t new_qty) {
+    OrderCancelReplaceRequest req;
+    req.key.cl_ord_id = new_id;
+    req.orig_key.cl_ord_id = orig_id;
+    req.symbol = symbol;
+    req.side = side;
+    req.price = new_price;
+    req.quantity = new_qty;
+    return req;
+}
+
+ExecutionReport create_replace_ack(const std::string& new_id, const std::string& orig_id,
+                                    int64_t leaves_qty) {
+    ExecutionReport report;
+    report.key.cl_ord_id = new_id;
+    report.orig_key = OrderKey{orig_id};
+    report.order_id = "EX" + orig_id;
+    report.ord_status = OrdStatus::NEW;
+    report.exec_type = ExecType::REPLACED;
+    report.leaves_qty = leaves_qty;
+    report.cum_qty = 0;
+    report.is_unsolicited = false;
+    return report;
+}
+
 }  // namespace
 
 // ============================================================================
@@ -287,6 +314,27 @@ TEST_F(NotionalDriftTest, MultipleOrdersWithSpotChanges) {
     EXPECT_DOUBLE_EQ(get_open_notional(), 0.0) << "OPEN should be exactly 0 (no drift!)";
 }
 
+TEST_F(NotionalDriftTest, SpotPriceChangeDuringKeyedReplace) {
+    auto inst = get_instrument("AAPL");
+    engine->on_new_order_single(create_order("ORD001", "AAPL", Side::BID, 100.0, 10), inst);
+    engine->on_execution_report(create_ack("ORD001", 10), inst);
+
+    // Replace request at spot=$120: OPEN -> IN_FLIGHT with 10 * 120 = 1200
+    provider.update_spot_price("AAPL", 120.0);
+    auto inst2 = get_instrument("AAPL");
+    engine->on_order_cancel_replace(create_replace("ORD001_R", "ORD001", "AAPL", Side::BID, 120.0, 20), inst2);
+    EXPECT_DOUBLE_EQ(get_in_flight_notional(), 1200.0);
+
+    // Ack under the new ClOrdID at spot=$130: the inputs stored at request
+    // time are still found, so exactly 1200 leaves IN_FLIGHT
+    provider.update_spot_price("AAPL", 130.0);
+    auto inst3 = get_instrument("AAPL");
+    engine->on_execution_report(create_replace_ack("ORD001_R", "ORD001", 20), inst3);
+
+    EXPECT_DOUBLE_EQ(get_in_flight_notional(), 0.0) << "IN_FLIGHT should be exactly 0 (no drift!)";
+    EXPECT_DOUBLE_EQ(get_open_notional(), 2600.0) << "OPEN = 20 * 130 = 2600";
+}
+
 TEST_F(NotionalDriftTest, PartialFillWithSpotChange) {
     // Insert and ACK order at spot=$100
     auto order = create_order("ORD001", "AAPL", Side::BID, 100.0, 10);
@@ -399,3 +447,246 @@ TEST_F(DeltaDriftTest, DeltaChangeDoesNotAffectStoredValues) {
 
     EXPECT_DOUBLE_EQ(get_open_delta(), 0.0) << "OPEN should be exactly 0 (no drift!)";
 }
+
+// ============================================================================
+// Test: Exposure metrics share one capture and record per order
+// ============================================================================
+
+// Counts context accessor calls
+class CountingDriftContext : public DriftTestContext {
+public:
+    mutable int calls = 0;
+
+    using DriftTestContext::DriftTestContext;
+
+    double spot_price(const InstrumentData& inst) const { ++calls; return DriftTestContext::spot_price(inst); }
+    double fx_rate(const InstrumentData& inst) const { ++calls; return DriftTestContext::fx_rate(inst); }
+    double contract_size(const InstrumentData& inst) const { ++calls; return DriftTestContext::contract_size(inst); }
+    double underlyer_spot(const InstrumentData& inst) const { ++calls; return DriftTestContext::underlyer_spot(inst); }
+    double delta(const InstrumentData& inst) const { ++calls; return DriftTestContext::delta(inst); }
+    double vega(const InstrumentData& inst) const { ++calls; return DriftTestContext::vega(inst); }
+};
+
+TEST(SharedOrderInputsTest, InputsCapturedOncePerEventForAllMetrics) {
+    using GrossNotional = GlobalGrossNotionalMetric<CountingDriftContext, InstrumentData, OpenStage, InFlightStage>;
+    using NetNotional = GlobalNetNotionalMetric<CountingDriftContext, InstrumentData, OpenStage, InFlightStage>;
+    using GrossDelta = GlobalGrossDeltaMetric<CountingDriftContext, InstrumentData, OpenStage, InFlightStage>;
+    using NetDelta = GlobalNetDeltaMetric<CountingDriftContext, InstrumentData, OpenStage, InFlightStage>;
+    using TestEngine = GenericRiskAggregationEngine<CountingDriftContext, InstrumentData,
+                                                    GrossNotional, NetNotional, GrossDelta, NetDelta>;
+
+    StaticInstrumentProvider provider;
+    provider.add_option("AAPL_C100", "AAPL", 10.0, 100.0, 0.5, 100.0);
+    CountingDriftContext context(provider);
+    TestEngine engine(context);
+
+    auto order = create_order("ORD001", "AAPL_C100", Side::ASK, 10.0, 10);
+    order.underlyer = "AAPL";
+
+    // Contract size, spot, FX, underlyer spot and delta: once per event, not per metric
+    engine.on_new_order_single(order, provider.get_instrument("AAPL_C100"));
+    EXPECT_EQ(context.calls, 5);
+    engine.on_execution_report(create_ack("ORD001", 10), provider.get_instrument("AAPL_C100"));
+    EXPECT_EQ(context.calls, 10);
+
+    // Every metric removes what it added, from the one stored record
+    provider.update_underlyer_spot("AAPL", 120.0);
+    provider.update_delta("AAPL_C100", 0.6);
+    auto inst = provider.get_instrument("AAPL_C100");
+    engine.on_execution_report(create_fill("ORD001", 4, 6, 10.0), inst);
+    engine.on_order_cancel_request(create_cancel_request("CXL001", "ORD001", "AAPL_C100", Side::ASK), inst);
+    engine.on_execution_report(create_cancel_ack("CXL001", "ORD001"), inst);
+
+    GlobalKey key = GlobalKey::instance();
+    EXPECT_DOUBLE_EQ(engine.get_metric<GrossNotional>().get(key), 0.0);
+    EXPECT_DOUBLE_EQ(engine.get_metric<NetNotional>().get(key), 0.0);
+    EXPECT_DOUBLE_EQ(engine.get_metric<GrossDelta>().get(key), 0.0);
+    EXPECT_DOUBLE_EQ(engine.get_metric<NetDelta>().get(key), 0.0);
+}
+
+TEST(SharedOrderInputsTest, OrdersShareInternedSnapshots) {
+    using GrossNotional = GlobalGrossNotionalMetric<DriftTestContext, InstrumentData, OpenStage, InFlightStage>;
+    using NetDelta = GlobalNetDeltaMetric<DriftTestContext, InstrumentData, OpenStage, InFlightStage>;
+    using TestEngine = GenericRiskAggregationEngine<DriftTestContext, InstrumentData, GrossNotional, NetDelta>;
+
+    StaticInstrumentProvider provider;
+    provider.add_equity("AAPL", 100.0);
+    DriftTestContext context(provider);
+    TestEngine engine(context);
+    const auto& snapshots = engine.order_inputs().snapshots();
+
+    // Same instrument, same market data: one snapshot for both orders
+    engine.on_new_order_single(create_order("ORD001", "AAPL", Side::BID, 100.0, 10), provider.get_instrument("AAPL"));
+    engine.on_new_order_single(create_order("ORD002", "AAPL", Side::ASK, 100.0, 5), provider.get_instrument("AAPL"));
+    EXPECT_EQ(snapshots.size(), 1u);
+
+    // A tick gives later captures a new snapshot; ORD001 keeps its own
+    provider.update_underlyer_spot("AAPL", 110.0);
+    engine.on_execution_report(create_ack("ORD002", 5), provider.get_instrument("AAPL"));
+    EXPECT_EQ(snapshots.size(), 2u);
+
+    // Removing ORD001 drops the snapshot only it referred to, and exactly
+    // what it added
+    engine.on_execution_report(create_nack("ORD001"), provider.get_instrument("AAPL"));
+    EXPECT_EQ(snapshots.size(), 1u);
+    EXPECT_DOUBLE_EQ(engine.get_metric<GrossNotional>().get_in_flight(GlobalKey::instance()), 0.0);
+    EXPECT_DOUBLE_EQ(engine.get_metric<GrossNotional>().get_open(GlobalKey::instance()), 550.0);
+    EXPECT_DOUBLE_EQ(engine.get_metric<NetDelta>().get(GlobalKey::instance()), -550.0);
+
+    engine.on_execution_report(create_fill("ORD002", 5, 0, 110.0), provider.get_instrument("AAPL"));
+    EXPECT_EQ(snapshots.size(), 0u);
+    EXPECT_DOUBLE_EQ(engine.get_metric<GrossNotional>().get(GlobalKey::instance()), 0.0);
+}
+
+// Provides only the fused accessor; counts its calls
+class FusedDriftContext {
+    StaticInstrumentProvider& provider_;
+public:
+    mutable int calls = 0;
+
+    explicit FusedDriftContext(StaticInstrumentProvider& provider) : provider_(provider) {}
+
+    PricingInputs pricing_inputs(const InstrumentData& inst) const {
+        ++calls;
+        PricingInputs in;
+        in.spot_price = inst.spot_price();
+        in.fx_rate = inst.fx_rate();
+        in.contract_size = inst.contract_size();
+        in.underlyer_spot = inst.underlyer_spot();
+        in.delta = inst.delta();
+        in.vega = inst.vega();
+        return in;
+    }
+};
+
+TEST(SharedOrderInputsTest, FusedContextAccessorIsCalledOncePerCapture) {
+    using GrossNotional = GlobalGrossNotionalMetric<FusedDriftContext, InstrumentData, OpenStage, InFlightStage>;
+    using NetDelta = GlobalNetDeltaMetric<FusedDriftContext, InstrumentData, OpenStage, InFlightStage>;
+    using TestEngine = RiskAggregationEngineWithLimits<FusedDriftContext, InstrumentData, GrossNotional, NetDelta>;
+    static_assert(is_vega_context_v<FusedDriftContext, InstrumentData>);
+
+    StaticInstrumentProvider provider;
+    provider.add_option("AAPL_C100", "AAPL", 10.0, 100.0, 0.5, 100.0);
+    FusedDriftContext context(provider);
+    TestEngine engine(context);
+    engine.set_default_limit<GrossNotional>(1e9);
+    engine.set_default_limit<NetDelta>(1e9);
+
+    auto order = create_order("ORD001", "AAPL_C100", Side::BID, 10.0, 10);
+    order.underlyer = "AAPL";
+    auto inst = provider.get_instrument("AAPL_C100");
+
+    auto submit = engine.try_submit(order, inst);
+    EXPECT_TRUE(submit.handle.is_valid());
+    EXPECT_EQ(context.calls, 1);
+    engine.on_execution_report(create_ack("ORD001", 10), inst);
+    EXPECT_EQ(context.calls, 2);
+
+    // 10 * 10 * 100 notional, 10 * 0.5 * 100 * 100 delta
+    EXPECT_DOUBLE_EQ(engine.get_metric<GrossNotional>().get(GlobalKey::instance()), 10000.0);
+    EXPECT_DOUBLE_EQ(engine.get_metric<NetDelta>().get(GlobalKey::instance()), 50000.0);
+
+    // Pre-trade checks price from the context as well
+    EXPECT_FALSE(engine.pre_trade_check(order, inst).would_breach);
+    EXPECT_EQ(context.calls, 4);
+}
+
+// ============================================================================
+// Test: Co-located stage values (StagedBucket)
+// ============================================================================
+
+TEST(StagedBucketTest, StageMovesUpdateOneRecordInPlace) {
+    StagedBucket<UnderlyerKey, double, NoStageExtra, AllStages> values;
+    UnderlyerKey key{"AAPL"};
+
+    values.add(OrderStage::IN_FLIGHT, key, 50000.0);
+    values.move(key, OrderStage::IN_FLIGHT, 50000.0, OrderStage::OPEN, 60000.0);
+    values.add(OrderStage::POSITION, key, 10000.0);
+
+    EXPECT_EQ(values.size(), 1u);
+    EXPECT_DOUBLE_EQ(values.get(OrderStage::IN_FLIGHT, key), 0.0);
+    EXPECT_DOUBLE_EQ(values.get(OrderStage::OPEN, key), 60000.0);
+    EXPECT_DOUBLE_EQ(values.total(key), 70000.0);
+    EXPECT_DOUBLE_EQ(values.sum(key, false, true, true), 60000.0);
+
+    // A stage brought back to zero drops out, like an AggregationBucket entry
+    values.remove(OrderStage::OPEN, key, 60000.0);
+    values.remove(OrderStage::OPEN, key, 5.0);
+    EXPECT_DOUBLE_EQ(values.get(OrderStage::OPEN, key), 0.0);
+    int open_keys = 0;
+    values.for_each(OrderStage::OPEN, [&open_keys](const UnderlyerKey&, double) { ++open_keys; });
+    EXPECT_EQ(open_keys, 0);
+    EXPECT_DOUBLE_EQ(values.total(key), 10000.0);
+}
+
+TEST(StagedBucketTest, UntrackedStagesAreIgnored) {
+    StagedBucket<UnderlyerKey, int64_t, NoStageExtra, OpenStage, InFlightStage> counts;
+    UnderlyerKey key{"AAPL"};
+
+    counts.add(OrderStage::IN_FLIGHT, key, 1);
+    counts.add(OrderStage::POSITION, key, 1);
+    counts.move(key, OrderStage::IN_FLIGHT, 1, OrderStage::POSITION, 1);
+
+    EXPECT_EQ(counts.get(OrderStage::POSITION, key), 0);
+    EXPECT_EQ(counts.total(key), 0);
+}
+
+TEST(StagedBucketTest, EmptiedKeysAreReleasedAndRowsReused) {
+    using Bucket = StagedBucket<UnderlyerKey, int64_t, NoStageExtra, OpenStage, InFlightStage>;
+    Bucket counts;
+    UnderlyerKey aapl{"AAPL"};
+    UnderlyerKey msft{"MSFT"};
+
+    counts.add(OrderStage::IN_FLIGHT, aapl, 1);
+    counts.move(aapl, OrderStage::IN_FLIGHT, 1, OrderStage::OPEN, 1);
+    EXPECT_EQ(counts.size(), 1u);
+
+    // Back to zero in every stage: the key is gone, not just zeroed
+    counts.remove(OrderStage::OPEN, aapl, 1);
+    EXPECT_EQ(counts.size(), 0u);
+    EXPECT_EQ(counts.find(aapl), nullptr);
+    counts.remove(OrderStage::OPEN, aapl, 1);
+    EXPECT_EQ(counts.size(), 0u);
+
+    // A new key takes the released row over, starting from an empty record
+    counts.add(OrderStage::OPEN, msft, 2);
+    EXPECT_EQ(counts.size(), 1u);
+    EXPECT_EQ(counts.get(OrderStage::OPEN, msft), 2);
+    EXPECT_EQ(counts.get(OrderStage::IN_FLIGHT, msft), 0);
+    EXPECT_EQ(counts.get(OrderStage::OPEN, aapl), 0);
+}
+
+TEST(StagedBucketTest, SharedRowIsKeptUntilEveryColumnIsEmpty) {
+    using Bucket = StagedBucket<UnderlyerKey, int64_t, NoStageExtra, OpenStage, InFlightStage>;
+    Bucket::table_type table;
+    Bucket first;
+    Bucket second;
+    first.bind(table);
+    second.bind(table);
+    UnderlyerKey aapl{"AAPL"};
+    UnderlyerKey msft{"MSFT"};
+
+    first.add(OrderStage::OPEN, aapl, 1);
+    second.add(OrderStage::OPEN, aapl, 1);
+    second.add(OrderStage::OPEN, msft, 1);
+    EXPECT_EQ(first.size(), 1u);
+    EXPECT_EQ(second.size(), 2u);
+    EXPECT_EQ(table.size(), 2u);
+
+    // Emptying one column leaves the row to the other
+    first.remove(OrderStage::OPEN, aapl, 1);
+    EXPECT_EQ(first.size(), 0u);
+    EXPECT_EQ(table.size(), 2u);
+    EXPECT_EQ(second.get(OrderStage::OPEN, aapl), 1);
+
+    second.remove(OrderStage::OPEN, aapl, 1);
+    EXPECT_EQ(table.size(), 1u);
+
+    // Clearing a column releases the rows only it was holding
+    first.add(OrderStage::OPEN, msft, 1);
+    second.clear();
+    EXPECT_EQ(second.size(), 0u);
+    EXPECT_EQ(table.size(), 1u);
+    first.clear();
+    EXPECT_EQ(table.size(), 0u);
+}
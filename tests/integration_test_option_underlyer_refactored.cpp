@@ -445,3 +445,47 @@ TEST_F(OptionUnderlyerRefactoredTest, PreTradeCheckResultDetails) {
     EXPECT_NE(str.find("ORDER_COUNT"), std::string::npos);
     EXPECT_NE(str.find("FAILED"), std::string::npos);
 }
+
+// ============================================================================
+// Test: Batch pre-trade check counts each new instrument once
+// ============================================================================
+
+TEST_F(OptionUnderlyerRefactoredTest, BatchCheckQuotedInstruments) {
+    const std::string AAPL = "AAPL";
+
+    // Quoting OPT1 on both sides adds one instrument; OPT2 a second; OPT3 a
+    // third, over the limit of 2
+    std::vector<NewOrderSingle> batch_orders = {
+        create_order("B1", "AAPL_OPT1", AAPL, Side::BID, 5.0, 10),
+        create_order("B2", "AAPL_OPT1", AAPL, Side::ASK, 5.5, 10),
+        create_order("B3", "AAPL_OPT2", AAPL, Side::BID, 3.0, 10),
+        create_order("B4", "AAPL_OPT3", AAPL, Side::BID, 2.0, 10),
+    };
+
+    auto batch = engine.pre_trade_check_batch(batch_orders);
+    ASSERT_EQ(batch.size(), 4u);
+    EXPECT_EQ(batch.passed, 3u);
+    EXPECT_FALSE(batch[1].would_breach);
+    ASSERT_TRUE(batch[3].has_breach(LimitType::QUOTED_INSTRUMENTS));
+    EXPECT_DOUBLE_EQ(batch[3].get_breach(LimitType::QUOTED_INSTRUMENTS)->current_usage, 2.0);
+    EXPECT_FALSE(batch[3].has_breach(LimitType::ORDER_COUNT));
+}
+
+// ============================================================================
+// Test: Count limits gate the maximum permissible quantity
+// ============================================================================
+
+TEST_F(OptionUnderlyerRefactoredTest, MaxPermissibleQuantityIsGatedByCounts) {
+    const std::string OPT1 = "AAPL_OPT1";
+    const std::string AAPL = "AAPL";
+
+    auto bid = create_order("ORD002", OPT1, AAPL, Side::BID, 5.0, 100);
+    EXPECT_EQ(engine.max_permissible_quantity(bid), UNLIMITED_QUANTITY);
+
+    // One open BID reaches the per-side limit: no quantity fits
+    engine.on_new_order_single(create_order("ORD001", OPT1, AAPL, Side::BID, 5.0, 100));
+    engine.on_execution_report(create_ack("ORD001", 100));
+    EXPECT_EQ(engine.max_permissible_quantity(bid), 0);
+    EXPECT_EQ(engine.max_permissible_quantity(create_order("ORD003", OPT1, AAPL, Side::ASK, 5.0, 100)),
+              UNLIMITED_QUANTITY);
+}
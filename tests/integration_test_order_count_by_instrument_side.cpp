@@ -351,3 +351,221 @@ TEST_F(OrderCountByInstrumentSideTest, PreTradeCheckResultToString) {
     EXPECT_NE(breach_str.find("current=1"), std::string::npos);
     EXPECT_NE(breach_str.find("after_order=2"), std::string::npos);
 }
+
+TEST_F(OrderCountByInstrumentSideTest, PreTradeCheckOnUnseenInstrument) {
+    const std::string SYMBOL = "UNSEEN_PRE_TRADE_SYMBOL";
+    engine.set_default_limit<OpenOrderCount>(0);
+
+    // Pre-trade on a symbol no order has used yet: breach is reported with the
+    // order's own symbol, and the check does not intern the symbol
+    auto result = engine.pre_trade_check(create_order("ORD001", SYMBOL, SYMBOL, Side::BID, 150.0, 100));
+    ASSERT_TRUE(result.would_breach);
+    EXPECT_EQ(result.breaches[0].key, SYMBOL + ":1");
+    EXPECT_EQ(SymbolInterner::instance().find(SYMBOL), INVALID_INTERNED_ID);
+}
+
+TEST_F(OrderCountByInstrumentSideTest, TrySubmit) {
+    const std::string SYMBOL = "AAPL";
+
+    // First BID is within the limit and added
+    SubmitResult first = engine.try_submit(create_order("ORD001", SYMBOL, SYMBOL, Side::BID, 150.0, 100));
+    ASSERT_TRUE(first.accepted());
+    EXPECT_NE(engine.order_book().get_order(first.handle), nullptr);
+    EXPECT_EQ(in_flight_count(SYMBOL, Side::BID), 1);
+
+    // Second BID would breach the in-flight limit: not added
+    SubmitResult second = engine.try_submit(create_order("ORD002", SYMBOL, SYMBOL, Side::BID, 150.0, 100));
+    EXPECT_FALSE(second.accepted());
+    EXPECT_TRUE(second.check.has_breach(LimitType::ORDER_COUNT));
+    EXPECT_EQ(in_flight_count(SYMBOL, Side::BID), 1);
+    EXPECT_EQ(engine.active_order_count(), 1u);
+}
+
+TEST_F(OrderCountByInstrumentSideTest, BatchCheckQuoteLadder) {
+    const std::string SYMBOL = "AAPL";
+
+    // A two-sided ladder: one order per side fits the in-flight limit
+    std::vector<NewOrderSingle> ladder = {
+        create_order("L1", SYMBOL, SYMBOL, Side::BID, 150.0, 100),
+        create_order("L2", SYMBOL, SYMBOL, Side::ASK, 151.0, 100),
+        create_order("L3", SYMBOL, SYMBOL, Side::BID, 149.0, 100),
+        create_order("L4", SYMBOL, SYMBOL, Side::ASK, 152.0, 100),
+    };
+
+    BatchPreTradeCheckResult batch = engine.pre_trade_check_batch(ladder);
+    ASSERT_EQ(batch.size(), 4u);
+    EXPECT_EQ(batch.passed, 2u);
+    EXPECT_FALSE(batch[0].would_breach);
+    EXPECT_FALSE(batch[1].would_breach);
+    EXPECT_TRUE(batch[2].has_breach(LimitType::ORDER_COUNT));
+    EXPECT_TRUE(batch[3].has_breach(LimitType::ORDER_COUNT));
+    EXPECT_EQ(in_flight_count(SYMBOL, Side::BID), 0);
+}
+
+TEST_F(OrderCountByInstrumentSideTest, BatchCheckOnUnseenInstrumentsDoesNotIntern) {
+    const std::string FIRST = "UNSEEN_BATCH_SYMBOL_1";
+    const std::string SECOND = "UNSEEN_BATCH_SYMBOL_2";
+
+    // Two new instruments are two keys; a second BID on the first breaches
+    std::vector<NewOrderSingle> orders = {
+        create_order("U1", FIRST, FIRST, Side::BID, 10.0, 100),
+        create_order("U2", SECOND, SECOND, Side::BID, 10.0, 100),
+        create_order("U3", FIRST, FIRST, Side::BID, 10.0, 100),
+    };
+
+    BatchPreTradeCheckResult batch = engine.pre_trade_check_batch(orders);
+    ASSERT_EQ(batch.size(), 3u);
+    EXPECT_FALSE(batch[0].would_breach);
+    EXPECT_FALSE(batch[1].would_breach);
+    ASSERT_TRUE(batch[2].has_breach(LimitType::ORDER_COUNT));
+    EXPECT_EQ(batch[2].breaches[0].key, FIRST + ":1");
+    EXPECT_EQ(SymbolInterner::instance().find(FIRST), INVALID_INTERNED_ID);
+    EXPECT_EQ(SymbolInterner::instance().find(SECOND), INVALID_INTERNED_ID);
+}
+
+TEST_F(OrderCountByInstrumentSideTest, BatchCheckOverManyKeys) {
+    // More distinct keys than are scanned linearly: repeats still find
+    // their key's accumulated usage
+    constexpr int SYMBOLS = 60;
+    std::vector<NewOrderSingle> orders;
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int i = 0; i < SYMBOLS; ++i) {
+            std::string symbol = "BASKET_" + std::to_string(i);
+            orders.push_back(create_order("B" + std::to_string(pass) + "_" + symbol, symbol, symbol, Side::BID, 10.0, 100));
+        }
+    }
+    for (int i = 0; i < SYMBOLS; ++i) {
+        std::string symbol = "BASKET_" + std::to_string(i);
+        orders.push_back(create_order("A_" + symbol, symbol, symbol, Side::ASK, 10.0, 100));
+    }
+
+    BatchPreTradeCheckResult batch = engine.pre_trade_check_batch(orders);
+    ASSERT_EQ(batch.size(), 3u * SYMBOLS);
+    EXPECT_EQ(batch.passed, 2u * SYMBOLS);
+    for (int i = 0; i < SYMBOLS; ++i) {
+        EXPECT_FALSE(batch[i].would_breach) << i;
+        EXPECT_TRUE(batch[SYMBOLS + i].has_breach(LimitType::ORDER_COUNT)) << i;
+        EXPECT_FALSE(batch[2 * SYMBOLS + i].would_breach) << i;
+    }
+}
+
+TEST(BatchKeyUsageTest, QuotedInstrumentsPastLinearScan) {
+    using Usage = engine::detail::BatchKeyUsage<InstrumentSideKey>;
+    Usage usage;
+    constexpr InternedId COUNT = 3 * Usage::LINEAR_SCAN_LIMIT;
+    for (InternedId symbol = 0; symbol < COUNT; ++symbol) {
+        EXPECT_FALSE(usage.is_quoted(symbol));
+        usage.pending_symbol = symbol;
+        usage.commit();
+        EXPECT_TRUE(usage.is_quoted(symbol));
+    }
+    for (InternedId symbol = 0; symbol < COUNT; ++symbol) {
+        EXPECT_TRUE(usage.is_quoted(symbol)) << symbol;
+    }
+    EXPECT_FALSE(usage.is_quoted(COUNT));
+}
+
+TEST_F(OrderCountByInstrumentSideTest, TrySubmitInternsOnlyAcceptedOrders) {
+    const std::string SYMBOL = "UNSEEN_SUBMIT_SYMBOL";
+    engine.set_default_limit<InFlightOrderCount>(0);
+
+    SubmitResult rejected = engine.try_submit(create_order("ORD001", SYMBOL, SYMBOL, Side::BID, 150.0, 100));
+    EXPECT_FALSE(rejected.accepted());
+    EXPECT_EQ(SymbolInterner::instance().find(SYMBOL), INVALID_INTERNED_ID);
+
+    engine.set_default_limit<InFlightOrderCount>(1);
+    SubmitResult accepted = engine.try_submit(create_order("ORD002", SYMBOL, SYMBOL, Side::BID, 150.0, 100));
+    ASSERT_TRUE(accepted.accepted());
+    EXPECT_NE(SymbolInterner::instance().find(SYMBOL), INVALID_INTERNED_ID);
+    EXPECT_EQ(in_flight_count(SYMBOL, Side::BID), 1);
+}
+
+// ============================================================================
+// Test: Side-split bucket storage
+// ============================================================================
+
+TEST(SideSplitBucketTest, UnknownSidesStayDistinctFromBidAndAsk) {
+    AggregationBucket<InstrumentSideKey, SumCombiner<int64_t>> bucket;
+    auto key = [](int side) { return InstrumentSideKey("SIDE_SPLIT_SYM", side); };
+
+    bucket.add(key(1), 1);
+    bucket.add(key(2), 10);
+    bucket.add(key(0), 100);
+    bucket.add(key(3), 1000);
+
+    EXPECT_EQ(bucket.get(key(1)), 1);
+    EXPECT_EQ(bucket.get(key(2)), 10);
+    EXPECT_EQ(bucket.get(key(0)), 100);
+    EXPECT_EQ(bucket.get(key(3)), 1000);
+    EXPECT_EQ(bucket.size(), 4u);
+
+    int64_t total = 0;
+    bucket.for_each([&](const InstrumentSideKey&, int64_t value) { total += value; });
+    EXPECT_EQ(total, 1111);
+
+    bucket.remove(key(3), 1000);
+    EXPECT_FALSE(bucket.contains(key(3)));
+    EXPECT_EQ(bucket.get(key(2)), 10);
+    EXPECT_EQ(bucket.size(), 3u);
+}
+
+// ============================================================================
+// Test: Engine memory resource
+// ============================================================================
+
+namespace {
+
+// Forwards to new/delete and counts allocations
+class CountingResource : public std::pmr::memory_resource {
+public:
+    size_t allocations = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+}  // namespace
+
+TEST(EngineMemoryResourceTest, ContainersAllocateFromEngineResource) {
+    using OpenOrderCount = OrderCountMetric<InstrumentSideKey, OpenStage>;
+    using TestEngine = RiskAggregationEngineWithLimits<void, void, OpenOrderCount>;
+
+    CountingResource resource;
+    TestEngine engine(&resource);
+    engine.set_limit<OpenOrderCount>(InstrumentSideKey{"AAPL", static_cast<int>(Side::BID)}, 5);
+    engine.on_new_order_single(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    engine.on_execution_report(create_ack("ORD001", 100));
+
+    EXPECT_GT(resource.allocations, 0u);
+    EXPECT_EQ(engine.get_metric<OpenOrderCount>().get(InstrumentSideKey{"AAPL", static_cast<int>(Side::BID)}), 1);
+}
+
+TEST(EngineMemoryResourceTest, FixedArenaWithoutOverflow) {
+    using OpenOrderCount = OrderCountMetric<InstrumentSideKey, OpenStage>;
+    using TestEngine = RiskAggregationEngineWithLimits<void, void, OpenOrderCount>;
+
+    MemoryArenaOptions options;
+    options.capacity_bytes = size_t{4} << 20;
+    options.allow_overflow = false;
+    MemoryArena arena(options);
+
+    TestEngine engine(arena.resource());
+    for (int i = 0; i < 100; ++i) {
+        std::string id = "ORD" + std::to_string(i);
+        engine.on_new_order_single(create_order(id, "SYM" + std::to_string(i % 10), "UND", Side::ASK, 1.0, 1));
+        engine.on_execution_report(create_ack(id, 1));
+    }
+    EXPECT_EQ(engine.active_order_count(), 100u);
+    EXPECT_EQ(engine.get_metric<OpenOrderCount>().get(InstrumentSideKey{"SYM3", static_cast<int>(Side::ASK)}), 10);
+}
@@ -256,6 +256,232 @@ TEST_F(PreTradeCheckUpdateNotionalTest, UpdateNonExistentOrderReturnsOk) {
     EXPECT_FALSE(result.would_breach) << "Non-existent order should not breach";
 }
 
+TEST_F(PreTradeCheckUpdateNotionalTest, ReplaceViaHandleKeepsOrderInPlace) {
+    auto inst = get_instrument("AAPL");
+    OrderHandle handle = engine->on_new_order_single(
+        create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100), inst);
+    engine->on_execution_report(create_ack("ORD001", 100), inst, handle);
+    const TrackedOrder* order = engine->order_book().get_order(handle);
+    ASSERT_NE(order, nullptr);
+
+    // Replace is acked through the handle; the order is re-keyed, not moved
+    engine->on_order_cancel_replace(create_replace("ORD001_R", "ORD001", "AAPL", Side::BID, 150.0, 200), inst, handle);
+    engine->on_execution_report(create_replace_ack("ORD001_R", "ORD001", 200), inst, handle);
+
+    EXPECT_EQ(engine->order_book().get_order(handle), order);
+    EXPECT_EQ(engine->order_book().get_order(OrderKey{"ORD001_R"}), order);
+    EXPECT_EQ(engine->order_book().get_order(OrderKey{"ORD001"}), nullptr);
+    EXPECT_EQ(order->key.cl_ord_id, "ORD001_R");
+    EXPECT_DOUBLE_EQ(notional(), 30000.0);
+
+    // Unsolicited cancel delivered through the same handle
+    ExecutionReport cancel;
+    cancel.key.cl_ord_id = "ORD001_R";
+    cancel.ord_status = OrdStatus::CANCELED;
+    cancel.exec_type = ExecType::CANCELED;
+    cancel.leaves_qty = 0;
+    cancel.cum_qty = 0;
+    cancel.is_unsolicited = true;
+    engine->on_execution_report(cancel, inst, handle);
+
+    EXPECT_EQ(order->state, OrderState::CANCELED);
+    EXPECT_DOUBLE_EQ(notional(), 0.0);
+}
+
+TEST(OrderBookHandleTest, HandleGoesStaleAfterCleanup) {
+    OrderBook book;
+    OrderHandle first = book.add_order(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    book.reject_order(*book.get_order(first));
+    book.cleanup_terminal_orders();
+
+    EXPECT_EQ(book.get_order(first), nullptr);
+    EXPECT_FALSE(book.find_handle(OrderKey{"ORD001"}).is_valid());
+
+    // The slot is reused, but the old handle does not alias the new order
+    OrderHandle second = book.add_order(create_order("ORD002", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    EXPECT_EQ(second.index, first.index);
+    EXPECT_EQ(book.get_order(first), nullptr);
+    EXPECT_EQ(book.find_handle(OrderKey{"ORD002"}), second);
+}
+
+TEST(OrderBookRetirementTest, TerminalOrdersKeptByDefault) {
+    OrderBook book;
+    EXPECT_EQ(book.terminal_retention(), OrderBook::RETAIN_ALL_TERMINAL);
+
+    TrackedOrder* filled = book.get_order(book.add_order(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100)));
+    book.acknowledge_order(*filled);
+    book.apply_fill(*filled, 100, 150.0);
+    TrackedOrder* canceled = book.get_order(book.add_order(create_order("ORD002", "AAPL", "AAPL", Side::BID, 150.0, 100)));
+    book.acknowledge_order(*canceled);
+    book.start_cancel(*canceled, OrderKey{"CXL2"});
+    book.complete_cancel(*canceled);
+
+    for (int i = 3; i < 20; ++i) {
+        book.add_order(create_order("ORD0" + std::to_string(i), "AAPL", "AAPL", Side::BID, 150.0, 100));
+    }
+
+    // A late fill for the filled order and a late cancel ack for the
+    // canceled one still find them
+    ExecutionReport late_fill = create_ack("ORD001", 0);
+    late_fill.ord_status = OrdStatus::FILLED;
+    late_fill.exec_type = ExecType::FILL;
+    TrackedOrder* order = book.find_report_order(late_fill, late_fill.report_type());
+    ASSERT_NE(order, nullptr);
+    EXPECT_EQ(order->state, OrderState::FILLED);
+
+    ExecutionReport late_cancel = create_ack("CXL2", 0);
+    late_cancel.orig_key = OrderKey{"ORD002"};
+    late_cancel.ord_status = OrdStatus::CANCELED;
+    late_cancel.exec_type = ExecType::CANCELED;
+    order = book.find_report_order(late_cancel, late_cancel.report_type());
+    ASSERT_NE(order, nullptr);
+    EXPECT_EQ(order->state, OrderState::CANCELED);
+    EXPECT_EQ(book.size(), 19u);
+
+    book.cleanup_terminal_orders();
+    EXPECT_EQ(book.get_order(OrderKey{"ORD001"}), nullptr);
+    EXPECT_EQ(book.get_order(OrderKey{"ORD002"}), nullptr);
+    EXPECT_EQ(book.size(), 17u);
+}
+
+TEST(OrderBookRetirementTest, TerminalOrdersReclaimedByLaterOrders) {
+    OrderBook book;
+    book.set_terminal_retention(0);
+    OrderHandle first = book.add_order(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    book.reject_order(*book.get_order(first));
+
+    // Still resolvable until the next order arrives
+    EXPECT_EQ(book.retired_count(), 1u);
+    EXPECT_NE(book.get_order(OrderKey{"ORD001"}), nullptr);
+
+    book.add_order(create_order("ORD002", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    EXPECT_EQ(book.get_order(first), nullptr);
+    EXPECT_EQ(book.get_order(OrderKey{"ORD001"}), nullptr);
+    EXPECT_EQ(book.retired_count(), 0u);
+    EXPECT_EQ(book.size(), 1u);
+}
+
+TEST(OrderBookRetirementTest, RetentionKeepsRecentTerminalOrders) {
+    OrderBook book;
+    book.set_terminal_retention(2);
+    for (int i = 1; i <= 3; ++i) {
+        OrderHandle handle = book.add_order(create_order("ORD00" + std::to_string(i), "AAPL", "AAPL", Side::BID, 150.0, 100));
+        book.apply_fill(*book.get_order(handle), 100, 150.0);
+    }
+    book.add_order(create_order("ORD004", "AAPL", "AAPL", Side::BID, 150.0, 100));
+
+    // Oldest terminal order reclaimed; the two most recent still answer late reports
+    EXPECT_EQ(book.get_order(OrderKey{"ORD001"}), nullptr);
+    ASSERT_NE(book.get_order(OrderKey{"ORD002"}), nullptr);
+    ASSERT_NE(book.get_order(OrderKey{"ORD003"}), nullptr);
+    EXPECT_EQ(book.get_order(OrderKey{"ORD003"})->state, OrderState::FILLED);
+    EXPECT_EQ(book.size(), 3u);
+}
+
+TEST(OrderBookRetirementTest, PendingKeysRemovedOnEveryExit) {
+    OrderBook book;
+    TrackedOrder* order = book.get_order(book.add_order(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100)));
+    book.acknowledge_order(*order);
+
+    // Rejected cancel
+    book.start_cancel(*order, OrderKey{"CXL1"});
+    EXPECT_EQ(book.resolve_order(OrderKey{"CXL1"}), order);
+    book.reject_cancel(*order);
+    EXPECT_EQ(book.resolve_order(OrderKey{"CXL1"}), nullptr);
+
+    // Replace still pending when the order fills
+    book.start_replace(*order, OrderKey{"ORD001_R"}, 151.0, 100);
+    EXPECT_EQ(book.pending_key_count(), 1u);
+    book.apply_fill(*order, 100, 150.0);
+    EXPECT_EQ(book.resolve_order(OrderKey{"ORD001_R"}), nullptr);
+
+    // Completed cancel
+    TrackedOrder* second = book.get_order(book.add_order(create_order("ORD002", "AAPL", "AAPL", Side::BID, 150.0, 100)));
+    book.start_cancel(*second, OrderKey{"CXL2"});
+    book.complete_cancel(*second);
+    EXPECT_EQ(book.resolve_order(OrderKey{"CXL2"}), nullptr);
+    EXPECT_EQ(book.pending_key_count(), 0u);
+}
+
+TEST(OrderBookRetirementTest, MemoryStaysFlatOverManyOrders) {
+    OrderBook book;
+    book.set_terminal_retention(0);
+    for (int i = 0; i < 20000; ++i) {
+        std::string id = "ORD" + std::to_string(i);
+        TrackedOrder* order = book.get_order(book.add_order(create_order(id, "AAPL", "AAPL", Side::BID, 150.0, 100)));
+        book.acknowledge_order(*order);
+        book.start_cancel(*order, OrderKey{"CXL" + std::to_string(i)});
+        book.complete_cancel(*order);
+    }
+
+    EXPECT_EQ(book.size(), 1u);
+    EXPECT_EQ(book.pending_key_count(), 0u);
+    EXPECT_LE(book.retired_count(), 1u);
+}
+
+TEST(OrderBookRetirementTest, ReplaceOntoLiveClOrdIdDropsDisplacedOrder) {
+    // Like a NewOrderSingle reusing a ClOrdID, a replace re-keyed onto
+    // another live order's ClOrdID leaves only the replaced order tracked
+    OrderBook book;
+    OrderHandle a = book.add_order(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    OrderHandle b = book.add_order(create_order("ORD002", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    book.acknowledge_order(*book.get_order(a));
+    book.acknowledge_order(*book.get_order(b));
+
+    book.start_replace(*book.get_order(a), OrderKey{"ORD002"}, 151.0, 50);
+    ASSERT_TRUE(book.complete_replace(*book.get_order(a)).has_value());
+
+    EXPECT_EQ(book.get_order(b), nullptr);
+    EXPECT_EQ(book.find_handle(OrderKey{"ORD002"}), a);
+    EXPECT_EQ(book.get_order(OrderKey{"ORD001"}), nullptr);
+    EXPECT_EQ(book.active_order_count(), 1u);
+    EXPECT_EQ(book.size(), 1u);
+    EXPECT_EQ(book.pending_key_count(), 0u);
+
+    book.apply_fill(*book.get_order(a), 50, 151.0);
+    book.cleanup_terminal_orders();
+    EXPECT_EQ(book.active_order_count(), 0u);
+    EXPECT_EQ(book.size(), 0u);
+}
+
+TEST(OrderBookActiveOrdersTest, CountsAndActiveListFollowTransitions) {
+    OrderBook book;
+    TrackedOrder* a = book.get_order(book.add_order(create_order("ORD001", "AAPL", "AAPL", Side::BID, 150.0, 100)));
+    TrackedOrder* b = book.get_order(book.add_order(create_order("ORD002", "MSFT", "MSFT", Side::ASK, 300.0, 100)));
+    TrackedOrder* c = book.get_order(book.add_order(create_order("ORD003", "GOOG", "GOOG", Side::BID, 100.0, 100)));
+    EXPECT_EQ(book.order_count(OrderState::PENDING_NEW), 3u);
+    EXPECT_EQ(book.active_order_count(), 3u);
+
+    book.acknowledge_order(*a);
+    book.acknowledge_order(*b);
+    book.start_cancel(*b, OrderKey{"CXL2"});
+    book.reject_order(*c);
+    EXPECT_EQ(book.order_count(OrderState::PENDING_NEW), 0u);
+    EXPECT_EQ(book.order_count(OrderState::OPEN), 1u);
+    EXPECT_EQ(book.order_count(OrderState::PENDING_CANCEL), 1u);
+    EXPECT_EQ(book.order_count(OrderState::REJECTED), 1u);
+    EXPECT_EQ(book.active_order_count(), 2u);
+
+    // Active list skips the rejected order and keeps arrival order
+    std::vector<std::string> active;
+    book.for_each_active([&active](const TrackedOrder& order) {
+        active.push_back(order.key.cl_ord_id.str());
+    });
+    EXPECT_EQ(active, (std::vector<std::string>{"ORD001", "ORD002"}));
+
+    // Removing from the head and reclaiming keep the list and counts intact
+    book.apply_fill(*a, 100, 150.0);
+    book.complete_cancel(*b);
+    EXPECT_EQ(book.active_order_count(), 0u);
+    book.add_order(create_order("ORD004", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    book.add_order(create_order("ORD005", "AAPL", "AAPL", Side::BID, 150.0, 100));
+    EXPECT_EQ(book.order_count(OrderState::FILLED) + book.order_count(OrderState::CANCELED) +
+              book.order_count(OrderState::REJECTED), book.retired_count());
+    EXPECT_EQ(book.active_order_count(), 2u);
+    EXPECT_EQ(book.active_orders().size(), 2u);
+    EXPECT_EQ(book.active_orders().front()->key.cl_ord_id, "ORD004");
+}
+
 // ============================================================================
 // Test: Pre-trade check for order updates - Delta
 // ============================================================================
@@ -446,6 +672,145 @@ TEST_F(PreTradeCheckSingleMetricTest, SingleMetricCheckUpdate) {
     EXPECT_TRUE(net_result.would_breach) << "Net delta update should breach";
 }
 
+TEST_F(PreTradeCheckSingleMetricTest, FastPathMatchesDetailedCheck) {
+    // Same order as above: both delta limits breached, notional within limit
+    auto order = create_order("ORD001", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 100);
+    auto inst = get_instrument(order.symbol);
+
+    EXPECT_FALSE(engine->would_pass(order, inst));
+
+    LimitTypeMask mask = engine->breached_limits(order, inst);
+    EXPECT_EQ(mask.count(), 2u);
+    EXPECT_TRUE(mask.test(LimitType::GROSS_DELTA));
+    EXPECT_TRUE(mask.test(LimitType::NET_DELTA));
+    EXPECT_FALSE(mask.test(LimitType::GLOBAL_GROSS_NOTIONAL));
+
+    // Details on demand agree with the mask
+    auto details = engine->pre_trade_check(order, inst);
+    EXPECT_EQ(details.breached, mask);
+    EXPECT_EQ(details.breaches.size(), 2u);
+
+    // Within every limit: both paths pass
+    auto small = create_order("ORD002", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 10);
+    EXPECT_TRUE(engine->would_pass(small, inst));
+    EXPECT_TRUE(engine->breached_limits(small, inst).none());
+    EXPECT_FALSE(engine->pre_trade_check(small, inst).would_breach);
+}
+
+TEST_F(PreTradeCheckSingleMetricTest, FastPathUpdate) {
+    auto order = create_order("ORD001", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 50);
+    auto inst = get_instrument(order.symbol);
+    engine->on_new_order_single(order, inst);
+    engine->on_execution_report(create_ack("ORD001", 50), inst);
+
+    // 50 -> 100 contracts: both delta limits breached (see SingleMetricCheckUpdate)
+    auto replace = create_replace("ORD001_R", "ORD001", "AAPL_OPT1", Side::BID, 5.0, 100);
+    EXPECT_FALSE(engine->would_pass(replace, inst));
+    EXPECT_EQ(engine->breached_limits(replace, inst), engine->pre_trade_check(replace, inst).breached);
+
+    // Unknown orders are not a breach
+    auto unknown = create_replace("ORD009_R", "ORD009", "AAPL_OPT1", Side::BID, 5.0, 100);
+    EXPECT_TRUE(engine->would_pass(unknown, inst));
+}
+
+TEST_F(PreTradeCheckSingleMetricTest, MaxPermissibleQuantity) {
+    // Per contract: delta 0.5 * 100 * 150 = 7,500; notional 100 * 5.0 = 500
+    // BID: net delta 400K / 7,500 -> 53 contracts, the tightest limit
+    auto bid = create_order("ORD001", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 1);
+    auto inst = get_instrument(bid.symbol);
+    int64_t max_bid = engine->max_permissible_quantity(bid, inst);
+    EXPECT_EQ(max_bid, 53);
+
+    // Agrees with the pre-trade check on both sides of the boundary
+    bid.quantity = max_bid;
+    EXPECT_TRUE(engine->would_pass(bid, inst));
+    bid.quantity = max_bid + 1;
+    EXPECT_FALSE(engine->would_pass(bid, inst));
+
+    // Existing usage shrinks the headroom: 20 contracts in, 33 left
+    bid.quantity = 20;
+    engine->on_new_order_single(bid, inst);
+    EXPECT_EQ(engine->max_permissible_quantity(bid, inst), 33);
+
+    // ASK under a signed net limit only lowers net delta; gross bounds it:
+    // (500K - 150K) / 7,500 -> 46 contracts
+    engine->get_limit_store<NetDelta>().set_comparison_mode(LimitComparisonMode::SIGNED);
+    auto ask = create_order("ORD002", "AAPL_OPT1", "AAPL", Side::ASK, 5.0, 1);
+    EXPECT_EQ(engine->max_permissible_quantity(ask, inst), 46);
+
+    // No limit on any metric: unbounded
+    TestEngine unlimited(*context);
+    EXPECT_EQ(unlimited.max_permissible_quantity(ask, inst), UNLIMITED_QUANTITY);
+}
+
+TEST_F(PreTradeCheckSingleMetricTest, MaxPermissibleQuantityWithUsagePastNegativeLimit) {
+    // 60 contracts ASK: net delta -450K, beyond the absolute 400K limit;
+    // gross delta 450K
+    auto ask = create_order("ORD001", "AAPL_OPT1", "AAPL", Side::ASK, 5.0, 60);
+    auto inst = get_instrument(ask.symbol);
+    engine->on_new_order_single(ask, inst);
+
+    // A BID must bring net delta back within -400K: at least 7 contracts of
+    // 7,500 (6 leave it at -405K). Gross delta allows only 6 more, so no
+    // quantity passes; the smallest per-metric maximum (6) would not either
+    auto bid = create_order("ORD002", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 1);
+    EXPECT_EQ(engine->max_permissible_quantity(bid, inst), 0);
+    for (int64_t quantity : {1, 6, 7}) {
+        bid.quantity = quantity;
+        EXPECT_FALSE(engine->would_pass(bid, inst)) << quantity;
+    }
+
+    // More gross room: (600K - 450K) / 7,500 -> 20, above net's 7
+    engine->set_default_limit<GrossDelta>(600000.0);
+    bid.quantity = 1;
+    int64_t max_bid = engine->max_permissible_quantity(bid, inst);
+    EXPECT_EQ(max_bid, 20);
+    bid.quantity = max_bid;
+    EXPECT_TRUE(engine->would_pass(bid, inst));
+    bid.quantity = max_bid + 1;
+    EXPECT_FALSE(engine->would_pass(bid, inst));
+    bid.quantity = 6;
+    EXPECT_FALSE(engine->would_pass(bid, inst));
+}
+
+TEST_F(PreTradeCheckSingleMetricTest, CachedLimitsFollowStoreChanges) {
+    // 20 contracts in: net delta 150K; another 20 reaches 300K, within 400K
+    auto order = create_order("ORD001", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 20);
+    auto inst = get_instrument(order.symbol);
+    engine->on_new_order_single(order, inst);
+    engine->on_execution_report(create_ack("ORD001", 20), inst);
+
+    auto next = create_order("ORD002", "AAPL_OPT1", "AAPL", Side::BID, 5.0, 20);
+    EXPECT_TRUE(engine->would_pass(next, inst));
+
+    // The check reads value and limit from the metric's per-key record
+    const auto& store = engine->get_limit_store<NetDelta>();
+    auto usage = engine->get_metric<NetDelta>().limit_usage(UnderlyerKey{"AAPL"}, store);
+    EXPECT_DOUBLE_EQ(usage.current, engine->get_metric<NetDelta>().get(UnderlyerKey{"AAPL"}));
+    EXPECT_DOUBLE_EQ(usage.limit, 400000.0);
+
+    // Changes made directly on the store invalidate the cached limit
+    engine->get_limit_store<NetDelta>().set_limit(UnderlyerKey{"AAPL"}, 200000.0);
+    auto result = engine->pre_trade_check(next, inst);
+    ASSERT_EQ(result.breaches.size(), 1u);
+    EXPECT_DOUBLE_EQ(result.breaches[0].limit_value, 200000.0);
+    EXPECT_DOUBLE_EQ(result.breaches[0].current_usage, 150000.0);
+    EXPECT_DOUBLE_EQ(result.breaches[0].hypothetical_usage, 300000.0);
+
+    engine->get_limit_store<NetDelta>().remove_limit(UnderlyerKey{"AAPL"});
+    EXPECT_TRUE(engine->would_pass(next, inst));
+
+    engine->set_default_limit<NetDelta>(250000.0);
+    EXPECT_FALSE(engine->would_pass(next, inst));
+
+    // Selling 40 takes net delta to -150K: breaches 100K only as an absolute limit
+    engine->set_default_limit<NetDelta>(100000.0);
+    auto ask = create_order("ORD003", "AAPL_OPT1", "AAPL", Side::ASK, 5.0, 40);
+    EXPECT_TRUE(engine->pre_trade_check_single<NetDelta>(ask, inst).would_breach);
+    engine->get_limit_store<NetDelta>().set_comparison_mode(LimitComparisonMode::SIGNED);
+    EXPECT_FALSE(engine->pre_trade_check_single<NetDelta>(ask, inst).would_breach);
+}
+
 // ============================================================================
 // Test: Order count doesn't change on update
 // ============================================================================
@@ -0,0 +1,287 @@
+// Installs the counting global operator new for the whole test binary
+#define AGGREGATION_INSTALL_COUNTING_OPERATOR_NEW
+#include "../src/aggregation/allocation_counter.hpp"
+
+#include <gtest/gtest.h>
+#include "../src/engine/risk_engine_with_limits.hpp"
+#include "../src/metrics/notional_metric.hpp"
+#include "../src/metrics/delta_metric.hpp"
+#include "../src/metrics/order_count_metric.hpp"
+#include "../src/instrument/instrument.hpp"
+#include "../src/fix/fix_messages.hpp"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace engine;
+using namespace fix;
+using namespace aggregation;
+using namespace metrics;
+using namespace instrument;
+
+// ============================================================================
+// Test Context
+// ============================================================================
+
+class TestContext {
+public:
+    double spot_price(const InstrumentData& inst) const { return inst.spot_price(); }
+    double fx_rate(const InstrumentData& inst) const { return inst.fx_rate(); }
+    double contract_size(const InstrumentData& inst) const { return inst.contract_size(); }
+    const std::string& underlyer(const InstrumentData& inst) const { return inst.underlyer(); }
+    double underlyer_spot(const InstrumentData& inst) const { return inst.underlyer_spot(); }
+    double delta(const InstrumentData& inst) const { return inst.delta(); }
+    double vega(const InstrumentData& inst) const { return inst.vega(); }
+};
+
+// ============================================================================
+// Helper functions
+// ============================================================================
+
+namespace {
+
+// Messages for one order's lifecycle, built before any measurement
+struct OrderFlow {
+    NewOrderSingle order;
+    ExecutionReport ack;
+    ExecutionReport partial_fill;
+    ExecutionReport full_fill;
+};
+
+OrderFlow create_flow(int n, const std::string& symbol, Side side) {
+    std::string cl_ord_id = "ORD" + std::to_string(n);
+
+    OrderFlow flow;
+    flow.order.key.cl_ord_id = cl_ord_id;
+    flow.order.symbol = symbol;
+    flow.order.underlyer = symbol;
+    flow.order.side = side;
+    flow.order.price = 100.0;
+    flow.order.quantity = 100;
+    flow.order.strategy_id = "STRAT1";
+    flow.order.portfolio_id = "PORT1";
+
+    flow.ack.key.cl_ord_id = cl_ord_id;
+    flow.ack.ord_status = OrdStatus::NEW;
+    flow.ack.exec_type = ExecType::NEW;
+    flow.ack.leaves_qty = 100;
+    flow.ack.cum_qty = 0;
+    flow.ack.is_unsolicited = false;
+
+    flow.partial_fill.key.cl_ord_id = cl_ord_id;
+    flow.partial_fill.ord_status = OrdStatus::PARTIALLY_FILLED;
+    flow.partial_fill.exec_type = ExecType::PARTIAL_FILL;
+    flow.partial_fill.leaves_qty = 60;
+    flow.partial_fill.cum_qty = 40;
+    flow.partial_fill.last_qty = 40;
+    flow.partial_fill.last_px = 100.0;
+    flow.partial_fill.is_unsolicited = false;
+
+    flow.full_fill.key.cl_ord_id = cl_ord_id;
+    flow.full_fill.ord_status = OrdStatus::FILLED;
+    flow.full_fill.exec_type = ExecType::FILL;
+    flow.full_fill.leaves_qty = 0;
+    flow.full_fill.cum_qty = 100;
+    flow.full_fill.last_qty = 60;
+    flow.full_fill.last_px = 100.0;
+    flow.full_fill.is_unsolicited = false;
+    return flow;
+}
+
+const std::vector<std::string> SYMBOLS = {"AAPL", "MSFT", "GOOG", "TSLA", "AMZN", "NVDA", "META", "NFLX"};
+
+}  // namespace
+
+// ============================================================================
+// Test: Steady-state order flow performs no heap allocations
+// ============================================================================
+//
+// NewOrderSingle -> ack -> partial fill -> full fill, plus the pre-trade check
+// that precedes each order, over an engine sized with CapacityHints. After a
+// warm-up that interns every identifier and creates every bucket, the flow
+// must not touch the heap at all.
+//
+
+class SteadyStateAllocationTest : public ::testing::Test {
+protected:
+    using GlobalNotional = GlobalGrossNotionalMetric<TestContext, InstrumentData, OpenStage, InFlightStage>;
+    using InstrumentNotional = GrossNotionalMetric<InstrumentKey, TestContext, InstrumentData, OpenStage, InFlightStage>;
+    using UnderlyerDelta = GrossDeltaMetric<UnderlyerKey, TestContext, InstrumentData, OpenStage, InFlightStage>;
+    using SideOrderCount = OrderCountMetric<InstrumentSideKey, OpenStage, InFlightStage>;
+    using QuotedCount = QuotedInstrumentCountMetric<OpenStage, InFlightStage>;
+
+    using TestEngine = RiskAggregationEngineWithLimits<
+        TestContext,
+        InstrumentData,
+        GlobalNotional,
+        InstrumentNotional,
+        UnderlyerDelta,
+        SideOrderCount,
+        QuotedCount
+    >;
+
+    static constexpr int WARM_UP_ORDERS = 64;
+    static constexpr int MEASURED_ORDERS = 1000;
+
+    TestContext context;
+    SimpleInstrumentProvider provider;
+    std::vector<InstrumentData> instruments;
+    std::vector<OrderFlow> flows;
+
+    void SetUp() override {
+        for (const auto& symbol : SYMBOLS) {
+            provider.set_spot_price(symbol, 100.0);
+            instruments.push_back(provider.get_instrument(symbol));
+        }
+        for (int i = 0; i < WARM_UP_ORDERS + MEASURED_ORDERS; ++i) {
+            Side side = (i % 2 == 0) ? Side::BID : Side::ASK;
+            flows.push_back(create_flow(i, SYMBOLS[i % SYMBOLS.size()], side));
+        }
+    }
+
+    static CapacityHints capacity() {
+        CapacityHints hints;
+        hints.orders = WARM_UP_ORDERS + MEASURED_ORDERS;
+        hints.instruments = SYMBOLS.size();
+        hints.underlyers = SYMBOLS.size();
+        return hints;
+    }
+
+    // Limits that never breach; each filled order is reclaimed by the next
+    static void configure(TestEngine& engine) {
+        engine.set_terminal_order_retention(0);
+        engine.set_default_limit<GlobalNotional>(1e12);
+        engine.set_default_limit<InstrumentNotional>(1e12);
+        engine.set_default_limit<UnderlyerDelta>(1e12);
+        engine.set_default_limit<SideOrderCount>(1e6);
+        engine.set_default_limit<QuotedCount>(1e6);
+    }
+
+    // Submit orders with try_submit() instead of pre_trade_check() + on_new_order_single()
+    bool use_try_submit = false;
+
+    void run_flow(TestEngine& engine, int index) {
+        const OrderFlow& flow = flows[index];
+        const InstrumentData& inst = instruments[index % instruments.size()];
+        OrderHandle handle;
+        if (use_try_submit) {
+            handle = engine.try_submit(flow.order, inst).handle;
+            EXPECT_TRUE(handle.is_valid());
+        } else {
+            EXPECT_FALSE(engine.pre_trade_check(flow.order, inst).would_breach);
+            handle = engine.on_new_order_single(flow.order, inst);
+        }
+        engine.on_execution_report(flow.ack, inst);
+        engine.on_execution_report(flow.partial_fill, inst, handle);
+        engine.on_execution_report(flow.full_fill, inst);
+    }
+
+    void warm_up(TestEngine& engine) {
+        for (int i = 0; i < WARM_UP_ORDERS; ++i) {
+            run_flow(engine, i);
+        }
+    }
+
+    // Heap allocations made by the measured orders
+    uint64_t measure(TestEngine& engine) {
+        warm_up(engine);
+        uint64_t before = heap_allocation_count;
+        for (int i = WARM_UP_ORDERS; i < WARM_UP_ORDERS + MEASURED_ORDERS; ++i) {
+            run_flow(engine, i);
+        }
+        return heap_allocation_count - before;
+    }
+
+    void expect_flat(const TestEngine& engine) {
+        EXPECT_DOUBLE_EQ(engine.get_metric<GlobalNotional>().get(GlobalKey::instance()), 0.0);
+        EXPECT_EQ(engine.get_metric<QuotedCount>().get(UnderlyerKey{"AAPL"}), 0);
+        // Each filled order is reclaimed by the next one; only the last is left
+        EXPECT_EQ(engine.order_book().size(), 1u);
+    }
+};
+
+#ifndef AGGREGATION_USE_STD_UNORDERED_MAP
+// std::unordered_map allocates a node per insert; it needs a MemoryArena (below)
+TEST_F(SteadyStateAllocationTest, NoHeapAllocationsWithCapacityHints) {
+    TestEngine engine(context, capacity());
+    configure(engine);
+
+    EXPECT_EQ(measure(engine), 0u);
+    expect_flat(engine);
+}
+#endif
+
+TEST_F(SteadyStateAllocationTest, NoHeapAllocationsWithMemoryArena) {
+    MemoryArenaOptions options;
+    options.capacity_bytes = size_t{16} << 20;
+    MemoryArena arena(options);
+    TestEngine engine(context, capacity(), arena.resource());
+    configure(engine);
+
+    EXPECT_EQ(measure(engine), 0u);
+    expect_flat(engine);
+}
+
+TEST_F(SteadyStateAllocationTest, TrySubmitDoesNotAllocate) {
+    MemoryArena arena;
+    TestEngine engine(context, capacity(), arena.resource());
+    configure(engine);
+    use_try_submit = true;
+
+    EXPECT_EQ(measure(engine), 0u);
+    expect_flat(engine);
+}
+
+// A rejected order on the fast path allocates nothing; the detailed check
+// formats the breached keys
+TEST_F(SteadyStateAllocationTest, FastPathRejectDoesNotAllocate) {
+    MemoryArena arena;
+    TestEngine engine(context, capacity(), arena.resource());
+    configure(engine);
+    warm_up(engine);
+    engine.set_default_limit<InstrumentNotional>(1.0);
+    engine.set_default_limit<UnderlyerDelta>(1.0);
+
+    const OrderFlow& flow = flows[WARM_UP_ORDERS];
+    const InstrumentData& inst = instruments[WARM_UP_ORDERS % instruments.size()];
+
+    uint64_t before = heap_allocation_count;
+    bool passed = engine.would_pass(flow.order, inst);
+    LimitTypeMask mask = engine.breached_limits(flow.order, inst);
+    EXPECT_EQ(heap_allocation_count - before, 0u);
+
+    EXPECT_FALSE(passed);
+    EXPECT_TRUE(mask.test(LimitType::GLOBAL_GROSS_NOTIONAL));  // Per-instrument notional
+    EXPECT_TRUE(mask.test(LimitType::GROSS_DELTA));
+    EXPECT_FALSE(mask.test(LimitType::ORDER_COUNT));
+    EXPECT_EQ(engine.pre_trade_check(flow.order, inst).breached, mask);
+}
+
+#ifdef AGGREGATION_COUNT_ALLOCATIONS
+TEST_F(SteadyStateAllocationTest, PerHandlerAllocationStats) {
+    // Without hints the first orders grow the order book and buckets
+    TestEngine engine(context);
+    configure(engine);
+    run_flow(engine, 0);
+
+    auto stats = engine.allocation_stats();
+    EXPECT_EQ(stats.calls_to(EngineHandler::NEW_ORDER_SINGLE), 1u);
+    EXPECT_EQ(stats.calls_to(EngineHandler::EXECUTION_REPORT), 3u);
+    EXPECT_EQ(stats.calls_to(EngineHandler::PRE_TRADE_CHECK), 1u);
+    EXPECT_GT(stats.allocations_in(EngineHandler::NEW_ORDER_SINGLE), 0u);
+
+    // Once sized, every handler stays off the heap
+    MemoryArena arena;
+    TestEngine sized(context, capacity(), arena.resource());
+    configure(sized);
+    warm_up(sized);
+    sized.reset_allocation_stats();
+    for (int i = WARM_UP_ORDERS; i < WARM_UP_ORDERS + MEASURED_ORDERS; ++i) {
+        run_flow(sized, i);
+    }
+
+    stats = sized.allocation_stats();
+    EXPECT_EQ(stats.calls_to(EngineHandler::NEW_ORDER_SINGLE), static_cast<uint64_t>(MEASURED_ORDERS));
+    EXPECT_EQ(stats.total_allocations(), 0u);
+}
+#endif
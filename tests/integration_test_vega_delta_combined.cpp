@@ -547,6 +547,47 @@ TEST_F(VegaDeltaCombinedTest, ClearResetsAllMetrics) {
     EXPECT_DOUBLE_EQ(net_vega("AAPL"), 0.0);
 }
 
+// ============================================================================
+// Test: Metrics keyed by underlyer share one table, one column each
+// ============================================================================
+
+TEST_F(VegaDeltaCombinedTest, CoKeyedMetricsShareOneTable) {
+    using Tables = shared_metric_tables<UnderlyerGrossDelta, UnderlyerNetDelta,
+                                        UnderlyerGrossVega, UnderlyerNetVega>;
+    static_assert(std::tuple_size_v<Tables::type> == 1);
+    static_assert(Tables::users<shared_table_t<UnderlyerGrossDelta>> == 4);
+
+    // Buy then sell the same option: gross and net columns diverge on one row
+    auto option_inst = get_instrument("AAPL_C150");
+    engine->on_new_order_single(create_order("ORD001", "AAPL_C150", "AAPL", Side::BID, 5.0, 10), option_inst);
+    engine->on_execution_report(create_ack("ORD001", 10), option_inst);
+    engine->on_execution_report(create_fill("ORD001", 10, 0, 5.0), option_inst);
+    engine->on_new_order_single(create_order("ORD002", "AAPL_C150", "AAPL", Side::ASK, 5.0, 4), option_inst);
+    engine->on_execution_report(create_ack("ORD002", 4), option_inst);
+    engine->on_execution_report(create_fill("ORD002", 4, 0, 5.0), option_inst);
+
+    double delta_10 = expected_delta_exposure("AAPL_C150", 10);
+    double delta_4 = expected_delta_exposure("AAPL_C150", 4);
+    double vega_10 = expected_vega_exposure("AAPL_C150", 10);
+    double vega_4 = expected_vega_exposure("AAPL_C150", 4);
+    EXPECT_NEAR(gross_delta("AAPL"), delta_10 + delta_4, 1e-6);
+    EXPECT_NEAR(net_delta("AAPL"), delta_10 - delta_4, 1e-6);
+    EXPECT_NEAR(gross_vega("AAPL"), vega_10 + vega_4, 1e-6);
+    EXPECT_NEAR(net_vega("AAPL"), vega_10 - vega_4, 1e-6);
+
+    // Clearing keeps the rows; new flow accumulates from zero
+    engine->clear();
+    engine->on_new_order_single(create_order("ORD003", "AAPL_C150", "AAPL", Side::ASK, 5.0, 4), option_inst);
+    engine->on_execution_report(create_ack("ORD003", 4), option_inst);
+    engine->on_execution_report(create_fill("ORD003", 4, 0, 5.0), option_inst);
+
+    EXPECT_NEAR(gross_delta("AAPL"), delta_4, 1e-6);
+    EXPECT_NEAR(net_delta("AAPL"), -delta_4, 1e-6);
+    EXPECT_NEAR(gross_vega("AAPL"), vega_4, 1e-6);
+    EXPECT_NEAR(net_vega("AAPL"), -vega_4, 1e-6);
+    EXPECT_DOUBLE_EQ(gross_delta("MSFT"), 0.0);
+}
+
 // ============================================================================
 // Test: Pre-trade check can breach both delta and vega limits
 // ============================================================================